@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "aggregate.hpp"
+#include "sample.hpp"
+
+//Cost per sample of the windowed statistics.
+//Sensors at 1 kHz feed 1, 10 and 60 s windows on all three gyro channels, in
+//sliding and tumbling mode. The first 60 s of samples fill the rings and are not
+//timed, the cost is flat after that. The sliding result of the longest window
+//is checked against a direct computation over the same samples.
+//usage: aggregate_bench [sensors] [seconds]
+
+int main(int argc, char** argv)
+{
+    const uint32_t sensors{argc>1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 8u};
+    const double seconds{argc>2 ? std::stod(argv[2]) : 120.0};
+    const double period{1e-3};
+    const std::vector<double> lengths{1.0, 10.0, 60.0};
+    const size_t warmup{static_cast<size_t>(lengths.back()/period)};
+    const size_t steps{warmup+static_cast<size_t>(seconds/period)};
+
+    std::mt19937 rng{7};
+    std::normal_distribution<float> noise{0.0f, 5.0f};
+    std::vector<glm::vec3> values(steps);
+    for(glm::vec3& value : values) value = glm::vec3{noise(rng)+20.0f, noise(rng), noise(rng)-3.0f};
+
+    for(WindowAggregate::Mode mode : {WindowAggregate::SLIDING, WindowAggregate::TUMBLING})
+    {
+        AggregateEngine engine{lengths, mode};
+        Sample sample{};
+        sample.axes = 3;
+        std::chrono::steady_clock::time_point start;
+        for(size_t i=0; i<steps; ++i)
+        {
+            if(i==warmup) start = std::chrono::steady_clock::now();
+            sample.timestamp = static_cast<double>(i)*period;
+            sample.value = values[i];
+            for(uint32_t s=0; s<sensors; ++s)
+            {
+                sample.sensor = s;
+                engine.push(sample);
+            }
+        }
+        const double elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+        const double pushed{static_cast<double>((steps-warmup)*sensors)};
+
+        const Aggregate x{engine.get(0, lengths.size()-1, 0)};
+        std::string check{"tumbling"};
+        if(mode==WindowAggregate::SLIDING)
+        {
+            //the window holds the samples newer than newest - length
+            const double newest{static_cast<double>(steps-1)*period};
+            size_t first{steps-1};
+            while(first>0 && static_cast<double>(first-1)*period>newest-lengths.back()) --first;
+            double sum{0.0}, squares{0.0};
+            const size_t count{steps-first};
+            for(size_t i=first; i<steps; ++i) sum += values[i].x;
+            const double mean{sum/static_cast<double>(count)};
+            for(size_t i=first; i<steps; ++i) squares += (values[i].x-mean)*(values[i].x-mean);
+            const double variance{squares/static_cast<double>(count)};
+            check = fmt::format("variance error {:.1e}, count {}", std::fabs(x.variance-variance)/variance,
+                                x.count==count ? "ok" : "WRONG");
+        }
+        spdlog::info("{}: {:.1f} M samples/s, {:.1f} ns per sample for {} windows x 3 channels, 60s x mean {:.2f} rms {:.2f}, {}",
+                    mode==WindowAggregate::SLIDING ? "sliding" : "tumbling", pushed/elapsed*1e-6,
+                    elapsed/pushed*1e9, lengths.size(), x.mean, x.rms, check);
+    }
+    return 0;
+}
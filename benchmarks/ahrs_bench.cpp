@@ -0,0 +1,51 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "ahrs.hpp"
+
+//Single core throughput of FusionStage for 6-axis and 9-axis samples spread
+//over a number of sensors, as the listener thread would feed it.
+//usage: ahrs_bench [samples] [sensors]
+
+static std::vector<Sample> makeSamples(size_t count, uint32_t sensors, uint8_t axes)
+{
+    std::mt19937 rng{7};
+    std::normal_distribution<float> noise{0.0f, 0.05f};
+    std::vector<Sample> samples(count);
+    for(size_t i=0; i<count; ++i)
+    {
+        const double t{static_cast<double>(i/sensors)*1e-3};
+        samples[i] = Sample{static_cast<uint32_t>(i%sensors), t,
+                            glm::vec3(20.0f*std::sin(static_cast<float>(t)), noise(rng), 5.0f),
+                            glm::vec3(noise(rng), noise(rng), 9.81f+noise(rng)),
+                            glm::vec3(0.3f+noise(rng), noise(rng), -0.4f+noise(rng)),
+                            axes};
+    }
+    return samples;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t sample_count{argc>1 ? std::stoull(argv[1]) : 10'000'000ull};
+    const uint32_t sensors{argc>2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 16u};
+
+    for(uint8_t axes : {6, 9})
+    {
+        const std::vector<Sample> samples{makeSamples(sample_count, sensors, axes)};
+        FusionStage fusion;
+        const auto start{std::chrono::steady_clock::now()};
+        for(const Sample& sample : samples)
+        {
+            fusion.process(sample);
+        }
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now()-start};
+        const glm::quat q{fusion.orientation(0)};
+        spdlog::info("{}-axis: {:.2f} M fused samples/s, {:.1f} ns/sample (q0 w={:.3f})",
+                    axes, sample_count/elapsed.count()*1e-6,
+                    elapsed.count()*1e9/sample_count, q.w);
+    }
+    return 0;
+}
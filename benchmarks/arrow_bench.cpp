@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "series_store.hpp"
+#include "query.hpp"
+#include "arrow_export.hpp"
+#include "sample.hpp"
+#include "scratch_dir.hpp"
+
+//Arrow export against the CSV dump of sensor_query.
+//Records `minutes` of one 6-axis sensor at 1 kHz into a new directory under `parent`
+//(/tmp by default), then writes the whole recording once as CSV the way sensor_query
+//prints it and once with exportArrow(), and pushes the same samples through an
+//ArrowRecorder as if they came in live. Reports rows/s and file sizes. The directory is removed at the end
+//unless `keep` is given, e.g. for reading the Arrow files back with pyarrow.
+//usage: arrow_bench [minutes] [parent] [keep]
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+int main(int argc, char** argv)
+{
+    const double minutes{argc>1 ? std::stod(argv[1]) : 60.0};
+    const std::string directory{makeScratchDir(argc>2 ? argv[2] : "/tmp", "sensor_arrow_bench")};
+    const bool keep{argc>3};
+    const std::string topic{"bench/imu"};
+    const size_t count{static_cast<size_t>(minutes*60.0*1000.0)};
+
+    std::filesystem::create_directories(directory+"/rec");
+    std::vector<Sample> live;
+    {
+        std::mt19937 rng{3};
+        std::normal_distribution<float> noise{0.0f, 0.5f};
+        SeriesWriter writer{series::fileName(directory+"/rec", topic), topic};
+        Sample s{};
+        s.axes = 6;
+        s.orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        for(size_t i=0; i<count; ++i)
+        {
+            s.timestamp = static_cast<double>(i)*1e-3;
+            s.arrival = s.timestamp;
+            for(int c=0; c<3; ++c)
+            {
+                s.value[c] = 90.0f*std::sin(0.2f*(c+1)*static_cast<float>(s.timestamp))+noise(rng);
+                s.accel[c] = (c==2 ? 1.0f : 0.0f)+0.01f*noise(rng);
+            }
+            writer.push(s);
+            live.push_back(s);
+        }
+        writer.flush();
+    }
+    SeriesQuery query{directory+"/rec"};
+    query.open();
+    const IndexedSeries* series{query.find(topic)};
+    spdlog::info("recorded {} samples", series->sampleCount());
+
+    //as sensor_query prints raw samples
+    auto start{Clock::now()};
+    {
+        std::FILE* csv{std::fopen((directory+"/export.csv").c_str(), "w")};
+        std::vector<Sample> samples;
+        query.samples(topic, series->begin(), series->end(), samples);
+        for(const Sample& s : samples)
+        {
+            std::fprintf(csv, "%.6f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", s.timestamp, s.value.x, s.value.y, s.value.z,
+                        s.accel.x, s.accel.y, s.accel.z);
+        }
+        std::fclose(csv);
+    }
+    const double csv_seconds{since(start)};
+    spdlog::info("csv:   {:6.2f} M rows/s, {:.1f} MB", static_cast<double>(count)/csv_seconds*1e-6,
+                static_cast<double>(std::filesystem::file_size(directory+"/export.csv"))*1e-6);
+
+    start = Clock::now();
+    ArrowWriter::Stats exported{};
+    exportArrow(*series, series->begin(), series->end(), directory+"/export.arrow", exported);
+    const double arrow_seconds{since(start)};
+    spdlog::info("arrow: {:6.2f} M rows/s, {:.1f} MB in {} batches, {:.1f}x the csv rate",
+                static_cast<double>(exported.rows)/arrow_seconds*1e-6, static_cast<double>(exported.bytes)*1e-6,
+                exported.batches, csv_seconds/arrow_seconds);
+
+    start = Clock::now();
+    ArrowWriter::Stats recorded{};
+    {
+        ArrowRecorder recorder{directory+"/live.arrow", [&topic](uint32_t){return topic;}};
+        for(const Sample& s : live) recorder.push(s);
+        recorder.flush();
+        recorded = recorder.getStats();
+    }
+    const double live_seconds{since(start)};
+    spdlog::info("live:  {:6.2f} M rows/s, {:.1f} MB in {} batches",
+                static_cast<double>(recorded.rows)/live_seconds*1e-6, static_cast<double>(recorded.bytes)*1e-6,
+                recorded.batches);
+
+    if(keep) spdlog::info("kept the files in {}", directory);
+    else std::filesystem::remove_all(directory);
+    return 0;
+}
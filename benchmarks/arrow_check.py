@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Reads the files of `arrow_bench 60 <parent> keep` back with pyarrow.
+
+Checks that export.arrow and live.arrow open through the file, stream and memory
+mapped readers, validates every batch, and compares export.arrow with export.csv.
+pyarrow is installed from pip into a temporary directory if it is missing.
+usage: arrow_check.py directory
+The directory is the one arrow_bench logs as kept, a new one under <parent>.
+"""
+import csv
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def import_pyarrow():
+    try:
+        import pyarrow  # noqa: F401
+    except ImportError:
+        target = os.path.join(tempfile.gettempdir(), "sensor_arrow_check")
+        subprocess.check_call([sys.executable, "-m", "pip", "install", "--quiet", "--target", target, "pyarrow"])
+        sys.path.insert(0, target)
+    import pyarrow
+    import pyarrow.feather
+    import pyarrow.ipc
+    return pyarrow
+
+
+def read(pa, path):
+    table = pa.ipc.open_file(path).read_all()
+    table.validate(full=True)
+    mapped = pa.feather.read_table(path, memory_map=True)
+    with open(path, "rb") as f:
+        streamed = pa.ipc.open_stream(pa.py_buffer(f.read()[8:])).read_all()
+    assert mapped.num_rows == table.num_rows == streamed.num_rows, path
+    return table
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    directory = sys.argv[1]
+    pa = import_pyarrow()
+    exported = read(pa, os.path.join(directory, "export.arrow"))
+    live = read(pa, os.path.join(directory, "live.arrow"))
+    print(f"export.arrow: {exported.num_rows} rows, live.arrow: {live.num_rows} rows")
+
+    columns = [exported.column(name).to_pylist() for name in exported.column_names]
+    mismatches = 0
+    with open(os.path.join(directory, "export.csv")) as f:
+        for i, row in enumerate(csv.reader(f)):
+            for c, value in enumerate(row):
+                if not math.isclose(float(value), columns[c][i], abs_tol=1e-3):
+                    mismatches += 1
+    rows = i+1
+    if rows != exported.num_rows or mismatches:
+        print(f"FAILED: {rows} csv rows, {mismatches} values differ")
+        return 1
+    print("export.arrow matches export.csv")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
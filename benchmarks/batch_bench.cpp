@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "series_store.hpp"
+#include "query.hpp"
+#include "batch.hpp"
+#include "work_pool.hpp"
+#include "scratch_dir.hpp"
+
+//Scaling of BatchJob with the worker count.
+//Records `sensors` 6-axis sensors of `minutes` at 1 kHz into a new directory under
+//`parent` (/tmp by default), removed at the end, and reprocesses them with 1, 2, 4, ...
+//workers up to one per core or `threads`, exporting every 10th orientation and 1 s
+//statistics. Reports samples/s and the speedup against one worker, and checks that every run wrote the same result files.
+//usage: batch_bench [sensors] [minutes] [parent] [threads]
+
+using Clock = std::chrono::steady_clock;
+
+static size_t digest(const std::string& directory)
+{
+    std::vector<std::filesystem::path> files;
+    for(const auto& entry : std::filesystem::directory_iterator{directory}) files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
+    size_t hash{0};
+    for(const std::filesystem::path& file : files)
+    {
+        std::ifstream in{file, std::ios::binary};
+        const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        hash = hash*31+std::hash<std::string>{}(content);
+    }
+    return hash;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t sensors{argc>1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 16};
+    const double minutes{argc>2 ? std::stod(argv[2]) : 10.0};
+    const std::string directory{makeScratchDir(argc>3 ? argv[3] : "/tmp", "sensor_batch_bench")};
+    const std::string output{directory+"/out"};
+    const size_t count{static_cast<size_t>(minutes*60.0*1000.0)};
+
+    for(uint32_t k=0; k<sensors; ++k)
+    {
+        const std::string topic{"bench/imu"+std::to_string(k)};
+        SeriesWriter writer{series::fileName(directory, topic), topic};
+        std::mt19937 rng{k};
+        std::normal_distribution<float> noise{0.0f, 0.5f};
+        Sample s{};
+        s.axes = 6;
+        for(size_t i=0; i<count; ++i)
+        {
+            s.timestamp = static_cast<double>(i)*1e-3;
+            const float t{static_cast<float>(s.timestamp)};
+            for(int c=0; c<3; ++c)
+            {
+                s.value[c] = 90.0f*std::sin(0.2f*(c+1)*t)+noise(rng);
+                s.accel[c] = (c==2 ? 1.0f : 0.0f)+0.01f*noise(rng);
+            }
+            writer.push(s);
+        }
+        writer.flush();
+    }
+    SeriesQuery query{directory};
+    query.open();
+    spdlog::info("recorded {} sensors of {} samples", sensors, count);
+
+    const unsigned cores{argc>4 ? static_cast<unsigned>(std::stoul(argv[4]))
+                                : std::max(1u, std::thread::hardware_concurrency())};
+    double single{0.0};
+    size_t expected{0};
+    for(unsigned threads=1; threads<=cores; threads = threads<cores ? std::min(2*threads, cores) : threads+1)
+    {
+        std::filesystem::remove_all(output);
+        std::filesystem::create_directories(output);
+        WorkStealingPool pool{threads};
+        BatchJob batch{query, BatchJob::Options{output, glm::vec3(0.1f), glm::vec3(1.0f), 0.05f, {1.0}, 10}};
+        const auto start{Clock::now()};
+        batch.run(pool);
+        const double seconds{std::chrono::duration<double>(Clock::now()-start).count()};
+        const double rate{static_cast<double>(batch.getStats().samples)/seconds};
+        if(threads==1) single = rate;
+        const size_t hash{digest(output)};
+        if(threads==1) expected = hash;
+        spdlog::info("{:2} threads: {:6.2f} M samples/s, speedup {:.2f}, {} of {} tasks stolen{}", threads,
+                    rate*1e-6, rate/single, pool.getStats().stolen, pool.getStats().executed,
+                    hash==expected ? "" : ", RESULTS DIFFER");
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "decimator.hpp"
+
+//Feeds a synthetic gyro history through MinMaxDecimator and reports the
+//per-sample cost and the number of plot vertices the window reduces to.
+//usage: decimation_bench [samples] [columns] [window_seconds]
+
+int main(int argc, char** argv)
+{
+    const size_t sample_count{argc>1 ? std::stoull(argv[1]) : 10'000'000ull};
+    const uint columns{argc>2 ? static_cast<uint>(std::stoul(argv[2])) : 1920u};
+    const float window_length{argc>3 ? std::stof(argv[3]) : 600.0f};
+
+    std::vector<Sample> samples(sample_count);
+    const double dt{window_length/static_cast<double>(sample_count)};
+    for(size_t i=0; i<sample_count; ++i)
+    {
+        const float t{static_cast<float>(i*dt)};
+        samples[i] = Sample{0, i*dt, glm::vec3(90.0f*std::sin(0.5f*t),
+                                               45.0f*std::sin(3.0f*t),
+                                               10.0f*std::cos(t))};
+    }
+
+    MinMaxDecimator decimator{columns, window_length};
+    size_t opened{0};
+    const auto start{std::chrono::steady_clock::now()};
+    for(const Sample& sample : samples)
+    {
+        opened += decimator.add(sample);
+    }
+    const std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now()-start};
+
+    spdlog::info("{} samples -> {} columns ({} vertices per channel)",
+                sample_count, opened, 2*opened);
+    spdlog::info("{:.2f} ns/sample, {:.1f} M samples/s, {:.1f} ms total",
+                elapsed.count()/sample_count,
+                sample_count*1e3/elapsed.count(),
+                elapsed.count()*1e-6);
+    return 0;
+}
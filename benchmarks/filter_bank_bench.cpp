@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "ahrs.hpp"
+#include "filter_bank.hpp"
+
+//Per-sensor scalar Madgwick updates (one AhrsState after the other) against the
+//SoA FilterBank with the scalar and the detected SIMD kernel, at 1k, 10k and
+//100k sensors. Every sensor gets one 6-axis sample per step.
+//usage: filter_bank_bench [steps]
+
+struct Inputs{
+    std::vector<glm::vec3> gyro;
+    std::vector<glm::vec3> accel;
+};
+
+static Inputs makeInputs(size_t sensors)
+{
+    std::mt19937 rng{3};
+    std::normal_distribution<float> noise{0.0f, 0.1f};
+    Inputs in;
+    for(size_t i=0; i<sensors; ++i)
+    {
+        in.gyro.push_back(glm::vec3(noise(rng), noise(rng), 0.3f+noise(rng)));
+        in.accel.push_back(glm::vec3(noise(rng), noise(rng), 9.81f+noise(rng)));
+    }
+    return in;
+}
+
+template<typename Step>
+static double measure(size_t steps, Step&& step)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    for(size_t i=0; i<steps; ++i) step();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+int main(int argc, char** argv)
+{
+    const size_t steps{argc>1 ? std::stoull(argv[1]) : 200ull};
+    const float dt{1e-3f};
+    const float beta{ahrs::DEFAULT_BETA};
+
+    for(size_t sensors : {1000ul, 10000ul, 100000ul})
+    {
+        const Inputs in{makeInputs(sensors)};
+        const double updates{static_cast<double>(sensors*steps)};
+
+        std::vector<AhrsState> states(sensors, AhrsState{1.0f, 0.0f, 0.0f, 0.0f, 0.0, true});
+        const double t_aos{measure(steps, [&](){
+            for(size_t i=0; i<sensors; ++i)
+            {
+                ahrs::madgwickIMU(states[i], in.gyro[i].x, in.gyro[i].y, in.gyro[i].z,
+                                in.accel[i].x, in.accel[i].y, in.accel[i].z, dt, beta);
+            }
+        })};
+        spdlog::info("{:>6} sensors  per-sensor scalar: {:7.1f} M updates/s", sensors, updates/t_aos*1e-6);
+
+        for(simd::Level level : {simd::SCALAR, simd::detect()})
+        {
+            FilterBank bank{sensors, beta};
+            bank.setLevel(level);
+            const double t_bank{measure(steps, [&](){
+                for(size_t i=0; i<sensors; ++i)
+                {
+                    bank.setInput(i, in.gyro[i], in.accel[i], dt);
+                }
+                bank.advance();
+            })};
+            float max_error{0.0f};
+            for(size_t i=0; i<sensors; ++i)
+            {
+                const glm::quat q{bank.orientation(i)};
+                max_error = std::max({max_error, std::fabs(q.w-states[i].q0), std::fabs(q.x-states[i].q1),
+                                      std::fabs(q.y-states[i].q2), std::fabs(q.z-states[i].q3)});
+            }
+            spdlog::info("{:>6} sensors  bank {:>6}:        {:7.1f} M updates/s ({:.2f}x, max |dq| {:.1e})",
+                        sensors, simd::levelName(bank.getLevel()), updates/t_bank*1e-6,
+                        t_aos/t_bank, max_error);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "merge.hpp"
+#include "sample.hpp"
+
+//Throughput of WatermarkMerge for a growing number of sources.
+//Every source produces samples at the same rate with a little timestamp jitter;
+//they arrive in batches of `batch` per source, as a drained shard queue hands
+//them over, and are merged after every round. One source in 64 is bursty and
+//delivers a few rounds at once, the watermark has to wait for it. Only its first
+//burst can be late, the merge does not know the source before it. Output order is checked.
+//usage: merge_bench [samples] [batch]
+
+int main(int argc, char** argv)
+{
+    const size_t total{argc>1 ? std::stoul(argv[1]) : 20000000ul};
+    const size_t batch{argc>2 ? std::stoul(argv[2]) : 32ul};
+    const double period{1e-3};
+
+    for(uint32_t sources : {1u, 4u, 16u, 64u, 256u, 1024u})
+    {
+        //timestamps are generated up front, only the merge is timed
+        std::mt19937 rng{42};
+        std::uniform_real_distribution<double> jitter{0.0, 0.2*period};
+        const size_t per_source{std::max<size_t>(batch, total/sources/batch*batch)};
+        std::vector<std::vector<Sample>> streams(sources);
+        for(uint32_t s=0; s<sources; ++s)
+        {
+            streams[s].resize(per_source);
+            for(size_t i=0; i<per_source; ++i)
+            {
+                Sample& sample{streams[s][i]};
+                sample = Sample{};
+                sample.sensor = s;
+                sample.timestamp = static_cast<double>(i)*period+jitter(rng);
+            }
+        }
+
+        //a bursty source delivers every `burst` rounds, within both the lateness and the idle timeout
+        const size_t burst{4};
+        WatermarkMerge merge{10*batch*period, 2.0*burst};
+        std::vector<Sample> out;
+        out.reserve(sources*batch*4);
+        size_t merged{0};
+        bool ordered{true};
+        double last{-1.0};
+        const size_t rounds{per_source/batch};
+        const auto start{std::chrono::steady_clock::now()};
+        for(size_t round=0; round<rounds; ++round)
+        {
+            for(uint32_t s=0; s<sources; ++s)
+            {
+                const bool bursty{s%64==63};
+                if(bursty && round%burst!=burst-1 && round!=rounds-1) continue;
+                const size_t first{bursty ? round/burst*burst : round};
+                for(size_t i=first*batch; i<(round+1)*batch; ++i)
+                {
+                    streams[s][i].arrival = static_cast<double>(round);
+                    merge.push(streams[s][i]);
+                }
+            }
+            out.clear();
+            merge.pop(static_cast<double>(round), out);
+            merged += out.size();
+            for(const Sample& sample : out)
+            {
+                ordered &= sample.timestamp>=last;
+                last = sample.timestamp;
+            }
+        }
+        out.clear();
+        merged += merge.flush(out);
+        const double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+
+        const WatermarkMerge::Stats stats{merge.getStats()};
+        spdlog::info("{:>5} sources: {:>7.2f} M samples/s, {} merged, {} late, {}",
+                    sources, static_cast<double>(merged+stats.late)/seconds*1e-6, merged, stats.late,
+                    ordered ? "in order" : "OUT OF ORDER");
+    }
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+extern "C" {
+    #include <glad/glad.h>
+}
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cxxopts.hpp>
+#include "spdlog/spdlog.h"
+#include "shader.hpp"
+#include "axes.hpp"
+#include "window.hpp"
+#include "listener.hpp"
+#include "sample.hpp"
+#include "sample_queue.hpp"
+#include "ahrs.hpp"
+#include "jitter_buffer.hpp"
+#include "synthetic.hpp"
+
+//Motion-to-photon latency probe.
+//A synthetic publisher thread sends rotation steps stamped with the wall clock,
+//the probe receives them through the same listener, fusion, jitter buffer and
+//render path as the subscriber, reads every frame back and takes the first frame
+//that differs after a step as the moment the step became visible.
+//usage: motion_to_photon_bench --steps 200 [--extrapolate true] [--frame_sleep 0]
+
+const std::string SHADER_PATHS[2]{
+                                    "../shaders/vertex.txt", //vertex shader
+                                    "../shaders/fragment.txt" //fragment shader
+                                };
+
+//a step not seen after this long is counted as missed
+constexpr double STEP_TIMEOUT{JitterBuffer::MAX_DELAY+0.5};
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    const size_t index{static_cast<size_t>(p*static_cast<double>(sorted.size()-1)+0.5)};
+    return sorted[std::min(index, sorted.size()-1)];
+}
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options{"motion_to_photon_bench", "Measures motion-to-photon latency"};
+    options.add_options()
+    ("t, type", "type of the MQTT connection, i.e tcp, ssl, ws, wsl",
+    cxxopts::value<std::string>()->default_value("tcp"))
+    ("server", "IP address of the broker",
+    cxxopts::value<std::string>()->default_value("127.0.0.1"))
+    ("server_port", "port number of the broker",
+    cxxopts::value<uint16_t>()->default_value("1883"))
+    ("q, qos", "Quality of service level",
+    cxxopts::value<uint8_t>()->default_value("0"))
+    ("topic", "topic used for the probe samples",
+    cxxopts::value<std::string>()->default_value("latency/probe"))
+    ("steps", "number of steps to measure",
+    cxxopts::value<uint32_t>()->default_value("100"))
+    ("step_interval", "seconds between two steps",
+    cxxopts::value<double>()->default_value("0.5"))
+    ("rate", "samples per second of the synthetic sensor",
+    cxxopts::value<double>()->default_value("100"))
+    ("extrapolate", "predict the orientation past the newest sample instead of showing it delayed",
+    cxxopts::value<bool>()->default_value("false"))
+    ("frame_sleep", "milliseconds slept after every frame, the subscriber uses 10",
+    cxxopts::value<uint32_t>()->default_value("10"))
+    ("size", "edge length of the hidden framebuffer in pixels",
+    cxxopts::value<uint32_t>()->default_value("256"))
+    ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if(result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+    const uint32_t steps{result["steps"].as<uint32_t>()};
+    const double step_interval{result["step_interval"].as<double>()};
+    const auto frame_sleep{std::chrono::milliseconds(result["frame_sleep"].as<uint32_t>())};
+    const uint32_t size{result["size"].as<uint32_t>()};
+    const std::string server{result["type"].as<std::string>()+"://"+
+                            result["server"].as<std::string>()+":"+
+                            std::to_string(result["server_port"].as<uint16_t>())};
+    const std::string topic{result["topic"].as<std::string>()};
+    const uint8_t qos{result["qos"].as<uint8_t>()};
+
+    FusionStage fusion{ahrs::DEFAULT_BETA};
+    OrientationJitter jitter{result["extrapolate"].as<bool>()};
+    SampleQueue sample_queue;
+    std::vector<Sample> samples;
+    std::vector<glm::quat> orientations;
+
+    //no session kept, steps queued by the broker for an earlier run would count as latency
+    MQTTListener mqtt_client{{server}, "sensor_latency_probe", topic, qos, 0};
+    std::future<bool> mqtt_receiver_setup{std::async(std::launch::async,
+                                                    &MQTTListener::setupMQTT,
+                                                    &mqtt_client)};
+    std::future<bool> mqtt_receiver_listen{std::async(std::launch::async,
+                                                    &MQTTListener::listen,
+                                                    &mqtt_client,
+                                                    std::ref(sample_queue),
+                                                    std::ref(fusion))};
+    if(!mqtt_receiver_setup.get())
+    {
+        spdlog::critical("Latency probe could not subscribe to {}", topic);
+        std::exit(EXIT_FAILURE);
+    }
+
+    SyntheticPublisher publisher{server, "sensor_latency_publisher", topic, qos};
+    publisher.setStep(step_interval, 30.0f);
+    if(!publisher.connect()) std::exit(EXIT_FAILURE);
+    std::thread publisher_thread{&SyntheticPublisher::run, &publisher,
+                                SyntheticPublisher::STEPS, result["rate"].as<double>(), uint8_t{3}, uint64_t{0}};
+
+    GLFWwindow* window;
+    gl::Window frame{window, size, size, "latency_probe", false};
+    window = frame.get();
+    VertexShader vertex_shader{SHADER_PATHS[0]};
+    FragmentShader fragment_shader{SHADER_PATHS[1]};
+    vertex_shader.compile();
+    fragment_shader.compile();
+    const uint shader_program{linkProgram(vertex_shader, fragment_shader)};
+    auto axes{std::make_unique<gl::Axes>()};
+
+    //same scene as the subscriber
+    glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(-55.0f), glm::vec3(0.0f,1.0f,1.0f));
+    const glm::mat4 camera_view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f,0.0f,-3.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(30.0f), 1.0f, 0.1f, 100.0f);
+    glm::mat4 view = camera_view;
+
+    int fb_width, fb_height;
+    glfwGetFramebufferSize(window, &fb_width, &fb_height);
+    std::vector<uint8_t> pixels(static_cast<size_t>(fb_width)*fb_height*4);
+    std::vector<uint8_t> previous(pixels.size(), 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    //wall clock stamps of the steps received but not yet seen on screen
+    std::deque<double> pending;
+    std::vector<double> latencies;
+    latencies.reserve(steps);
+    uint32_t missed{0};
+    uint64_t frames{0};
+    const auto deadline{std::chrono::steady_clock::now()+
+                        std::chrono::duration<double>((steps+4)*step_interval*2.0+10.0)};
+
+    spdlog::info("Measuring {} steps, one every {} s...", steps, step_interval);
+    while(latencies.size()<steps && std::chrono::steady_clock::now()<deadline)
+    {
+        sample_queue.drain(samples);
+        for(const Sample& sample : samples)
+        {
+            jitter.push(sample);
+            if(sample.value.z!=0.0f) pending.push_back(sample.timestamp);
+        }
+        jitter.sample(steadySeconds(), orientations);
+        if(!orientations.empty())
+        {
+            view = camera_view*glm::mat4_cast(orientations[0]);
+        }
+
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        axes->draw(shader_program, model, view, projection);
+
+        //the back buffer holds exactly the frame the swap below presents
+        glReadPixels(0, 0, fb_width, fb_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glfwSwapBuffers(window);
+        glFinish();
+        const double presented{wallSeconds()};
+        ++frames;
+
+        const bool changed{std::memcmp(pixels.data(), previous.data(), pixels.size())!=0};
+        pixels.swap(previous);
+        while(!pending.empty() && presented-pending.front()>STEP_TIMEOUT)
+        {
+            pending.pop_front();
+            ++missed;
+        }
+        if(changed && !pending.empty())
+        {
+            latencies.push_back(presented-pending.front());
+            pending.pop_front();
+        }
+
+        glfwPollEvents();
+        std::this_thread::sleep_for(frame_sleep);
+    }
+    publisher.stop();
+    publisher_thread.join();
+
+    if(latencies.empty())
+    {
+        spdlog::error("No step became visible, is the broker at {} reachable?", server);
+        std::exit(EXIT_FAILURE);
+    }
+    std::vector<double> sorted{latencies};
+    std::sort(sorted.begin(), sorted.end());
+    const double mean{std::accumulate(sorted.begin(), sorted.end(), 0.0)/static_cast<double>(sorted.size())};
+    spdlog::info("motion-to-photon over {} steps ({} missed, {} frames):", sorted.size(), missed, frames);
+    spdlog::info("  mean {:7.2f} ms", mean*1e3);
+    spdlog::info("  min  {:7.2f} ms", sorted.front()*1e3);
+    spdlog::info("  p50  {:7.2f} ms", percentile(sorted, 0.50)*1e3);
+    spdlog::info("  p90  {:7.2f} ms", percentile(sorted, 0.90)*1e3);
+    spdlog::info("  p99  {:7.2f} ms", percentile(sorted, 0.99)*1e3);
+    spdlog::info("  max  {:7.2f} ms", sorted.back()*1e3);
+
+    axes.reset();
+    glDeleteProgram(shader_program);
+    glfwTerminate();
+    //the listener thread blocks on the broker forever
+    std::exit(EXIT_SUCCESS);
+}
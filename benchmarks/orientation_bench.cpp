@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "ahrs.hpp"
+
+//Per-sample cost of the gyro only path of FusionStage (ahrs::integrateGyro) and
+//its accuracy under jittered sample timing: a constant rotation about z is sampled
+//at several rates with random timestamp spacing and compared with the analytic angle.
+//usage: orientation_bench [samples]
+
+int main(int argc, char** argv)
+{
+    const size_t sample_count{argc>1 ? std::stoull(argv[1]) : 10'000'000ull};
+    std::mt19937 rng{42};
+
+    //cost per sample, raw update and through the locked per-sensor entry point
+    std::vector<Sample> samples(sample_count);
+    std::uniform_real_distribution<float> rate{-250.0f, 250.0f};
+    for(size_t i=0; i<sample_count; ++i)
+    {
+        samples[i] = Sample{static_cast<uint32_t>(i%8), i*1e-3, glm::vec3(rate(rng), rate(rng), rate(rng))};
+        samples[i].axes = 3;
+    }
+    AhrsState state{1.0f, 0.0f, 0.0f, 0.0f, 0.0, false};
+    auto start{std::chrono::steady_clock::now()};
+    for(const Sample& sample : samples)
+    {
+        FusionStage::update(state, sample, ahrs::DEFAULT_BETA);
+    }
+    std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now()-start};
+    spdlog::info("update:  {:.2f} ns/sample (q.w={:.3f})", elapsed.count()/sample_count, state.q0);
+
+    FusionStage fusion{ahrs::DEFAULT_BETA};
+    start = std::chrono::steady_clock::now();
+    for(const Sample& sample : samples)
+    {
+        fusion.process(sample);
+    }
+    elapsed = std::chrono::steady_clock::now()-start;
+    spdlog::info("process: {:.2f} ns/sample", elapsed.count()/sample_count);
+
+    //accuracy: 90 deg/s about z for 10 s, 900 deg in total
+    const float spin{90.0f};
+    const double duration{10.0};
+    for(double sample_rate : {50.0, 200.0, 1000.0})
+    {
+        std::uniform_real_distribution<double> jitter{0.5, 1.5};
+        AhrsState s{1.0f, 0.0f, 0.0f, 0.0f, 0.0, false};
+        Sample sample{0, 0.0, glm::vec3(0.0f, 0.0f, spin)};
+        sample.axes = 3;
+        FusionStage::update(s, sample, ahrs::DEFAULT_BETA);
+        while(sample.timestamp<duration)
+        {
+            sample.timestamp = std::min(duration, sample.timestamp+jitter(rng)/sample_rate);
+            FusionStage::update(s, sample, ahrs::DEFAULT_BETA);
+        }
+        const double expected{glm::radians(spin)*duration};
+        const double measured{2.0*std::atan2(static_cast<double>(s.q3), static_cast<double>(s.q0))};
+        const double error{std::remainder(measured-expected, 2.0*M_PI)};
+        spdlog::info("{:6.0f} Hz jittered: angle error {:.3e} deg", sample_rate, glm::degrees(static_cast<float>(error)));
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "spdlog/spdlog.h"
+#include "sample_queue.hpp"
+
+//Drives SampleQueue with a producer that publishes `overload` times faster than the
+//consumer can process, once per policy, and reports what was dropped, how stale the
+//newest sample was when the consumer got it and how much the peak RSS grew.
+//usage: overload_bench [producer_rate_hz] [overload] [seconds] [sensors]
+
+static long peakRssKiB()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char** argv)
+{
+    const double rate{argc>1 ? std::stod(argv[1]) : 200000.0};
+    const double overload{argc>2 ? std::stod(argv[2]) : 10.0};
+    const double seconds{argc>3 ? std::stod(argv[3]) : 2.0};
+    const uint32_t sensors{argc>4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 4u};
+    //samples the consumer manages per second
+    const double capacity{rate/overload};
+
+    for(OverloadPolicy policy : {OverloadPolicy::DROP_OLDEST, OverloadPolicy::DROP_NEWEST,
+                                OverloadPolicy::COALESCE, OverloadPolicy::DOWNSAMPLE})
+    {
+        SampleQueue queue{SampleQueue::DEFAULT_CAPACITY, policy, 4};
+        const long rss_before{peakRssKiB()};
+        std::atomic<bool> running{true};
+        std::atomic<uint64_t> produced_total{0};
+
+        std::thread producer{[&](){
+            const auto start{std::chrono::steady_clock::now()};
+            uint64_t produced{0};
+            Sample sample{};
+            while(running)
+            {
+                //publish in 1ms bursts at the target rate
+                const double elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+                const uint64_t due{static_cast<uint64_t>(elapsed*rate)};
+                for(; produced<due; ++produced)
+                {
+                    sample.sensor = static_cast<uint32_t>(produced%sensors);
+                    sample.timestamp = sample.arrival = steadySeconds();
+                    queue.push(sample);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            produced_total = produced;
+        }};
+
+        std::vector<Sample> samples;
+        uint64_t consumed{0};
+        double staleness{0.0};
+        uint64_t frames{0};
+        const auto end{std::chrono::steady_clock::now()+std::chrono::duration<double>(seconds)};
+        while(std::chrono::steady_clock::now()<end)
+        {
+            const size_t count{queue.drain(samples)};
+            if(count>0)
+            {
+                double newest{0.0};
+                for(const Sample& sample : samples) newest = std::max(newest, sample.arrival);
+                staleness += steadySeconds()-newest;
+                ++frames;
+            }
+            consumed += count;
+            //emulated per sample work, plus a 10ms frame
+            std::this_thread::sleep_for(std::chrono::duration<double>(count/capacity+0.01));
+        }
+        running = false;
+        producer.join();
+
+        std::vector<SampleQueue::Stats> stats;
+        queue.stats(stats);
+        uint64_t dropped{0};
+        uint32_t max_depth{0};
+        for(const SampleQueue::Stats& s : stats)
+        {
+            dropped += s.dropped;
+            max_depth = std::max(max_depth, s.max_depth);
+        }
+        const uint64_t produced{produced_total};
+        spdlog::info("{:>12}: {} produced, {} consumed, {} dropped ({:.1f}%), depth <= {}, newest sample {:.2f} ms old, peak RSS +{} KiB",
+                    policyName(policy), produced, consumed, dropped,
+                    100.0*dropped/std::max<uint64_t>(1, produced), max_depth,
+                    frames ? 1e3*staleness/frames : 0.0, peakRssKiB()-rss_before);
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "series_store.hpp"
+#include "playback.hpp"
+#include "sample.hpp"
+#include "scratch_dir.hpp"
+
+//Frame side cost of Playback while playing and while scrubbing.
+//Records `hours` of `sensors` 1 kHz gyros into a new directory under `parent` (/tmp
+//by default), removed at the end, then runs a 60 Hz frame loop without a window:
+//10 s of playing at normal speed, then 10 s of scrubbing, dragging the cursor over
+//an 800 pixel timeline by up to 20 pixels per frame for half a second and holding
+//it for half a second. Per frame it times what the renderer does: seek, the
+//orientation at the cursor and the plot samples since the last frame, all of the
+//history after a jump. It also counts the frames after a drag stops until the
+//prefetch thread has loaded the position; until then the previous position stays
+//on screen.
+//usage: playback_bench [hours] [sensors] [parent]
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    if(values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size()-1, static_cast<size_t>(p*static_cast<double>(values.size())))];
+}
+
+int main(int argc, char** argv)
+{
+    const double hours{argc>1 ? std::stod(argv[1]) : 1.0};
+    const uint32_t sensors{argc>2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 2};
+    const std::string directory{makeScratchDir(argc>3 ? argv[3] : "/tmp", "sensor_playback_bench")};
+    const size_t count{static_cast<size_t>(hours*3600.0*1000.0)};
+    const double history{10.0};
+    const double frame{1.0/60.0};
+
+    for(uint32_t k=0; k<sensors; ++k)
+    {
+        const std::string topic{"bench/imu"+std::to_string(k)};
+        SeriesWriter writer{series::fileName(directory, topic), topic};
+        std::mt19937 rng{k};
+        std::normal_distribution<float> noise{0.0f, 0.5f};
+        Sample s{};
+        s.axes = 3;
+        for(size_t i=0; i<count; ++i)
+        {
+            s.timestamp = static_cast<double>(i)*1e-3;
+            for(int c=0; c<3; ++c)
+            {
+                s.value[c] = 90.0f*std::sin(0.2f*(c+1)*static_cast<float>(s.timestamp))+noise(rng);
+            }
+            writer.push(s);
+        }
+        writer.flush();
+    }
+    spdlog::info("recorded {} sensors of {} samples", sensors, count);
+
+    auto start{Clock::now()};
+    Playback playback{directory, history};
+    if(!playback.open()) return 1;
+    spdlog::info("opened in {:.1f} ms, {:.0f} s recorded", since(start)*1e3, playback.end()-playback.begin());
+
+    std::mt19937 rng{1};
+    std::uniform_real_distribution<double> drag{-20.0, 20.0};
+    const double pixel{(playback.end()-playback.begin())/800.0};
+    std::vector<Sample> samples;
+    for(const char* phase : {"playing", "scrubbing"})
+    {
+        const bool scrubbing{phase[0]=='s'};
+        std::vector<double> costs;
+        std::vector<double> settles;
+        double cursor{playback.begin()+0.5*(playback.end()-playback.begin())};
+        double shown{-history};
+        int held{-1};   //frames since the drag stopped, -1 once loaded
+        glm::quat q;
+        for(int f=0; f<600; ++f)
+        {
+            const bool dragging{scrubbing && (f/30)%2==0};
+            if(dragging) cursor = std::clamp(cursor+drag(rng)*pixel, playback.begin(), playback.end());
+            else if(!scrubbing) cursor += frame;
+            if(scrubbing && !dragging && f%30==0) held = 0;
+            start = Clock::now();
+            playback.seek(cursor);
+            //same refill rule as the subscriber
+            const bool jump{cursor<shown || cursor-shown>history};
+            bool loaded{true};
+            for(uint32_t sensor=0; sensor<sensors; ++sensor)
+            {
+                loaded = playback.orientation(sensor, cursor, q) && loaded;
+                loaded = playback.samples(sensor, jump ? cursor-history : shown, cursor, samples) && loaded;
+            }
+            costs.push_back(since(start));
+            samples.clear();
+            if(loaded) shown = cursor;
+            if(held>=0 && loaded)
+            {
+                settles.push_back(held);
+                held = -1;
+            }
+            else if(held>=0) ++held;
+            std::this_thread::sleep_for(std::chrono::duration<double>(frame));
+        }
+        spdlog::info("{}: per frame median {:.1f} us, p99 {:.1f} us, max {:.1f} us", phase,
+                    percentile(costs, 0.5)*1e6, percentile(costs, 0.99)*1e6, percentile(costs, 1.0)*1e6);
+        if(scrubbing)
+        {
+            spdlog::info("{} drags, loaded after the drag stopped within median {:.0f}, max {:.0f} frames",
+                        settles.size(), percentile(settles, 0.5), percentile(settles, 1.0));
+        }
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "spdlog/spdlog.h"
+#include "kernels.hpp"
+
+//Checks every batched quaternion kernel of every level available on this CPU
+//against glm and compares their throughput with a glm loop.
+//usage: quat_kernels_bench [elements]
+
+struct QuatArrays{
+    std::vector<float> w, x, y, z;
+    explicit QuatArrays(size_t n):w(n), x(n), y(n), z(n){}
+    QuatSoA view() {return QuatSoA{w.data(), x.data(), y.data(), z.data()};}
+    glm::quat at(size_t i) const {return glm::quat(w[i], x[i], y[i], z[i]);}
+    void set(size_t i, const glm::quat& q) {w[i] = q.w; x[i] = q.x; y[i] = q.y; z[i] = q.z;}
+};
+
+struct Vec3Arrays{
+    std::vector<float> x, y, z;
+    explicit Vec3Arrays(size_t n):x(n), y(n), z(n){}
+    Vec3SoA view() {return Vec3SoA{x.data(), y.data(), z.data()};}
+    glm::vec3 at(size_t i) const {return glm::vec3(x[i], y[i], z[i]);}
+};
+
+static float quatError(const glm::quat& a, const glm::quat& b)
+{
+    //q and -q are the same rotation
+    const float same{std::max({std::fabs(a.w-b.w), std::fabs(a.x-b.x), std::fabs(a.y-b.y), std::fabs(a.z-b.z)})};
+    const float flipped{std::max({std::fabs(a.w+b.w), std::fabs(a.x+b.x), std::fabs(a.y+b.y), std::fabs(a.z+b.z)})};
+    return std::min(same, flipped);
+}
+
+template<typename F>
+static double seconds(F&& f)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n{argc>1 ? std::stoull(argv[1]) : 1'000'000ull};
+    std::mt19937 rng{11};
+    std::normal_distribution<float> gauss{0.0f, 1.0f};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+    QuatArrays a{n}, b{n}, out{n}, raw{n};
+    Vec3Arrays v{n}, v_out{n};
+    std::vector<float> t(n);
+    for(size_t i=0; i<n; ++i)
+    {
+        raw.set(i, glm::quat(gauss(rng), gauss(rng), gauss(rng), gauss(rng)));
+        a.set(i, glm::normalize(raw.at(i)));
+        //every 8th pair nearly parallel to exercise the lerp path of slerp
+        const glm::quat qb{glm::normalize(glm::quat(gauss(rng), gauss(rng), gauss(rng), gauss(rng)))};
+        b.set(i, i%8==0 ? glm::normalize(a.at(i)+qb*1e-3f) : qb);
+        v.x[i] = gauss(rng); v.y[i] = gauss(rng); v.z[i] = gauss(rng);
+        t[i] = unit(rng);
+    }
+
+    //glm reference results and timings
+    std::vector<glm::quat> ref_mul(n), ref_norm(n), ref_slerp(n);
+    std::vector<glm::vec3> ref_rot(n);
+    const double g_mul{seconds([&](){ for(size_t i=0; i<n; ++i) ref_mul[i] = a.at(i)*b.at(i); })};
+    const double g_norm{seconds([&](){ for(size_t i=0; i<n; ++i) ref_norm[i] = glm::normalize(raw.at(i)); })};
+    const double g_rot{seconds([&](){ for(size_t i=0; i<n; ++i) ref_rot[i] = a.at(i)*v.at(i); })};
+    const double g_slerp{seconds([&](){ for(size_t i=0; i<n; ++i) ref_slerp[i] = glm::slerp(a.at(i), b.at(i), t[i]); })};
+
+    for(simd::Level level : {simd::SCALAR, simd::NEON, simd::SSE42, simd::AVX2, simd::AVX512})
+    {
+        const simd::Kernels& k{simd::kernels(level)};
+        if(k.level!=level) continue;
+
+        float e_mul{0.0f}, e_norm{0.0f}, e_rot{0.0f}, e_slerp{0.0f};
+        const double s_mul{seconds([&](){ k.quatMultiply(a.view(), b.view(), out.view(), n); })};
+        for(size_t i=0; i<n; ++i) e_mul = std::max(e_mul, quatError(out.at(i), ref_mul[i]));
+
+        QuatArrays normalized{raw};
+        const double s_norm{seconds([&](){ k.quatNormalize(normalized.view(), n); })};
+        for(size_t i=0; i<n; ++i) e_norm = std::max(e_norm, quatError(normalized.at(i), ref_norm[i]));
+
+        const double s_rot{seconds([&](){ k.rotateVector(a.view(), v.view(), v_out.view(), n); })};
+        for(size_t i=0; i<n; ++i)
+        {
+            const glm::vec3 d{v_out.at(i)-ref_rot[i]};
+            e_rot = std::max({e_rot, std::fabs(d.x), std::fabs(d.y), std::fabs(d.z)});
+        }
+
+        const double s_slerp{seconds([&](){ k.quatSlerp(a.view(), b.view(), t.data(), out.view(), n); })};
+        for(size_t i=0; i<n; ++i) e_slerp = std::max(e_slerp, quatError(out.at(i), ref_slerp[i]));
+
+        spdlog::info("{:>8}: multiply {:5.2f}x (err {:.1e})  normalize {:5.2f}x (err {:.1e})  "
+                    "rotate {:5.2f}x (err {:.1e})  slerp {:5.2f}x (err {:.1e})",
+                    simd::levelName(level),
+                    g_mul/s_mul, e_mul, g_norm/s_norm, e_norm,
+                    g_rot/s_rot, e_rot, g_slerp/s_slerp, e_slerp);
+    }
+    spdlog::info("speedups are relative to the glm loop, errors are max abs differences to glm");
+    return 0;
+}
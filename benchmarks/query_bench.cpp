@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "series_store.hpp"
+#include "query.hpp"
+#include "sample.hpp"
+#include "scratch_dir.hpp"
+
+//Latency of SeriesQuery on a long recording.
+//Records `hours` of one 1 kHz gyro (8 bytes per sample, 24 h are about 700 MB)
+//into a new directory under `parent` (/tmp by default), removed at the end. Then times
+//opening it without and with the sparse index, and one hour at the end of the recording read raw, at 0.1 s, 1 s and 60 s resolution
+//and as orientations at 1 s resolution.
+//usage: query_bench [hours] [parent]
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+int main(int argc, char** argv)
+{
+    const double hours{argc>1 ? std::stod(argv[1]) : 24.0};
+    const std::string directory{makeScratchDir(argc>2 ? argv[2] : "/tmp", "sensor_query_bench")};
+    const std::string topic{"bench/imu"};
+    const size_t count{static_cast<size_t>(hours*3600.0*1000.0)};
+    const float lsb{2000.0f/32768.0f};
+
+    {
+        std::mt19937 rng{5};
+        std::normal_distribution<double> noise{0.0, 3.0};
+        SeriesWriter writer{series::fileName(directory, topic), topic};
+        Sample s{};
+        s.axes = 3;
+        const auto start{Clock::now()};
+        for(size_t i=0; i<count; ++i)
+        {
+            s.timestamp = static_cast<double>(i)*1e-3;
+            for(int c=0; c<3; ++c)
+            {
+                const double x{100.0*std::sin(0.3*(c+1)*s.timestamp)+noise(rng)*lsb};
+                s.value[c] = static_cast<float>(std::round(x/lsb))*lsb;
+            }
+            writer.push(s);
+        }
+        writer.flush();
+        spdlog::info("recorded {} samples ({:.0f} MB) in {:.1f} s", count,
+                    static_cast<double>(writer.getStats().bytes)*1e-6, since(start));
+    }
+
+    for(const char* pass : {"without index", "with index"})
+    {
+        const auto start{Clock::now()};
+        SeriesQuery query{directory};
+        query.open();
+        spdlog::info("open {}: {:.1f} ms", pass, since(start)*1e3);
+    }
+
+    SeriesQuery query{directory};
+    query.open();
+    const IndexedSeries* indexed{query.find(topic)};
+    const double to{indexed->end()}, from{to-3600.0};
+    std::vector<Sample> samples;
+    std::vector<Bucket> buckets;
+    std::vector<SeriesQuery::Orientation> orientations;
+
+    auto start{Clock::now()};
+    query.samples(topic, from, to, samples);
+    spdlog::info("1 h raw: {} samples in {:.1f} ms", samples.size(), since(start)*1e3);
+    for(double resolution : {0.1, 1.0, 60.0})
+    {
+        buckets.clear();
+        const SeriesQuery::Stats before{query.getStats()};
+        start = Clock::now();
+        query.buckets(topic, from, to, resolution, buckets);
+        const double seconds{since(start)};
+        const SeriesQuery::Stats after{query.getStats()};
+        spdlog::info("1 h at {} s: {} buckets in {:.2f} ms, segments decoded {}, summarized {}, rolled up {}",
+                    resolution, buckets.size(), seconds*1e3, after.decoded-before.decoded,
+                    after.summarized-before.summarized, after.rolled-before.rolled);
+    }
+    start = Clock::now();
+    //the recording is gyro only, the drifting orientation is fine for timing the replay
+    query.orientations(topic, from, to, 1.0, orientations, 5.0, ahrs::DEFAULT_BETA, true);
+    spdlog::info("1 h orientation at 1 s: {} rows in {:.1f} ms", orientations.size(), since(start)*1e3);
+    std::filesystem::remove_all(directory);
+    return 0;
+}
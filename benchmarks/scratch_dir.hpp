@@ -0,0 +1,28 @@
+#ifndef SCRATCH_DIR_H
+#define SCRATCH_DIR_H
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include "spdlog/spdlog.h"
+
+//A new directory "<parent>/<name>.XXXXXX" made by mkdtemp for the files of a benchmark.
+//It never existed before, so removing it afterwards only removes what the benchmark wrote,
+//whatever path was given on the command line. Exits if it cannot be created.
+inline std::string makeScratchDir(const std::string& parent, const std::string& name)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(parent, ec);
+    std::string path{parent+"/"+name+".XXXXXX"};
+    if(!mkdtemp(path.data()))
+    {
+        spdlog::critical("Could not create a directory in {}: {}", parent, std::strerror(errno));
+        std::exit(EXIT_FAILURE);
+    }
+    spdlog::info("writing to {}", path);
+    return path;
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "spdlog/spdlog.h"
+#include "series_store.hpp"
+#include "sample.hpp"
+
+//Compression and read throughput of the series store on a gyro-like stream.
+//The samples mimic a MEMS gyro at 1 kHz: a 16 bit ADC at +-2000 deg/s (0.061
+//deg/s per LSB), timestamps from the sensor's microsecond counter with a few
+//microseconds of jitter, and a mix of rest (noise only) and motion (a few slow
+//sinusoids up to 200 deg/s). The file is written through SeriesWriter, then read
+//back fully and by a short range through the mapped SeriesReader, and checked.
+//usage: series_store_bench [seconds] [directory]
+
+int main(int argc, char** argv)
+{
+    const double seconds{argc>1 ? std::stod(argv[1]) : 600.0};
+    const std::string directory{argc>2 ? argv[2] : "/tmp"};
+    const double rate{1000.0};
+    const float lsb{2000.0f/32768.0f};
+    const size_t count{static_cast<size_t>(seconds*rate)};
+
+    std::mt19937 rng{11};
+    std::normal_distribution<double> noise{0.0, 3.0};
+    std::uniform_int_distribution<int> jitter{-3, 3};
+    std::vector<Sample> samples(count);
+    size_t csv_bytes{0};
+    char line[96];
+    for(size_t i=0; i<count; ++i)
+    {
+        Sample& s{samples[i]};
+        s = Sample{};
+        s.axes = 3;
+        s.timestamp = static_cast<double>(static_cast<int64_t>(i)*1000+jitter(rng))*1e-6;
+        //30 s of motion, then 30 s at rest
+        const bool moving{static_cast<int64_t>(s.timestamp/30.0)%2==0};
+        for(int c=0; c<3; ++c)
+        {
+            double x{noise(rng)*lsb};
+            if(moving) x += 200.0*std::sin(0.7*(c+1)*s.timestamp)+40.0*std::sin(5.3*s.timestamp+c);
+            s.value[c] = static_cast<float>(std::round(x/lsb))*lsb;
+        }
+        csv_bytes += static_cast<size_t>(std::snprintf(line, sizeof(line), "%.6f,%.3f,%.3f,%.3f\n",
+                                                    s.timestamp, s.value.x, s.value.y, s.value.z));
+    }
+
+    const std::string path{series::fileName(directory, "bench/gyro")};
+    unlink(path.c_str());
+    auto start{std::chrono::steady_clock::now()};
+    {
+        SeriesWriter writer{path, "bench/gyro"};
+        if(!writer.ok()) return 1;
+        for(const Sample& s : samples) writer.push(s);
+        writer.flush();
+    }
+    const double write_seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+
+    SeriesReader reader;
+    if(!reader.open(path)) return 1;
+    const double binary_bytes{static_cast<double>(count*(sizeof(double)+3*sizeof(float)))};
+    const double file_bytes{static_cast<double>(reader.fileSize())};
+    spdlog::info("{} samples in {} segments: {:.2f} bytes per sample, {:.1f}x smaller than binary (20 B), "
+                "{:.1f}x smaller than CSV ({:.1f} B)", count, reader.segments().size(), file_bytes/count,
+                binary_bytes/file_bytes, csv_bytes/file_bytes, static_cast<double>(csv_bytes)/count);
+    spdlog::info("write: {:.1f} M samples/s", count/write_seconds*1e-6);
+
+    std::vector<Sample> out;
+    out.reserve(count);
+    const int repeats{5};
+    start = std::chrono::steady_clock::now();
+    for(int r=0; r<repeats; ++r)
+    {
+        out.clear();
+        reader.read(-INFINITY, INFINITY, out);
+    }
+    const double read_seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()/repeats};
+    bool exact{out.size()==count};
+    for(size_t i=0; exact && i<count; ++i)
+    {
+        exact = std::fabs(out[i].timestamp-samples[i].timestamp)<0.5e-6 && out[i].value.x==samples[i].value.x &&
+                out[i].value.y==samples[i].value.y && out[i].value.z==samples[i].value.z;
+    }
+    spdlog::info("full read: {:.1f} M samples/s, {:.0f} MB/s of file, {:.0f} MB/s of decoded binary, {}",
+                count/read_seconds*1e-6, file_bytes/read_seconds*1e-6, binary_bytes/read_seconds*1e-6,
+                exact ? "exact" : "MISMATCH");
+
+    //one second from the middle, the footer index skips all other segments
+    const double middle{seconds/2};
+    const int ranges{1000};
+    size_t found{0};
+    start = std::chrono::steady_clock::now();
+    for(int r=0; r<ranges; ++r)
+    {
+        out.clear();
+        found = reader.read(middle, middle+1.0, out);
+    }
+    const double range_seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()/ranges};
+    spdlog::info("1 s range read: {} samples in {:.1f} us", found, range_seconds*1e6);
+    unlink(path.c_str());
+    return exact ? 0 : 1;
+}
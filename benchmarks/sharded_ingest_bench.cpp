@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cxxopts.hpp>
+#include "mqtt/async_client.h"
+#include "spdlog/spdlog.h"
+#include "ingest.hpp"
+#include "sample.hpp"
+#include "sample_queue.hpp"
+
+//Ingest throughput over K MQTT connections in one process.
+//Publisher threads flood one topic per sensor, a ShardedIngest with K shards
+//(K = 1, 2, 4, ... up to --shards) subscribes the sensor topics spread over its
+//connections, and the samples fused and queued during the window are counted.
+//usage: sharded_ingest_bench --shards 8 --sensors 32 --publishers 4 --seconds 5
+
+using namespace std::chrono_literals;
+
+//connecting and the first messages are not measured
+constexpr double WARMUP{1.0};
+
+static uint64_t accepted(ShardedIngest& ingest, std::vector<SampleQueue::Stats>& stats)
+{
+    ingest.stats(stats);
+    uint64_t total{0};
+    for(const SampleQueue::Stats& s : stats) total += s.accepted;
+    return total;
+}
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options{"sharded_ingest_bench", "Ingest throughput over several MQTT connections"};
+    options.add_options()
+    ("server", "broker URI",
+    cxxopts::value<std::string>()->default_value("tcp://127.0.0.1:1883"))
+    ("q, qos", "Quality of service level",
+    cxxopts::value<uint8_t>()->default_value("0"))
+    ("topic", "prefix of the sensor topics",
+    cxxopts::value<std::string>()->default_value("bench/sharded"))
+    ("sensors", "number of sensor topics",
+    cxxopts::value<uint32_t>()->default_value("32"))
+    ("shards", "largest number of shards",
+    cxxopts::value<uint32_t>()->default_value("8"))
+    ("publishers", "publisher threads",
+    cxxopts::value<uint32_t>()->default_value("4"))
+    ("seconds", "measured seconds per shard count",
+    cxxopts::value<double>()->default_value("5"))
+    ("pin", "pin the ingest threads to cores",
+    cxxopts::value<bool>()->default_value("true"))
+    ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if(result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+    const std::string server{result["server"].as<std::string>()};
+    const uint8_t qos{result["qos"].as<uint8_t>()};
+    const double seconds{result["seconds"].as<double>()};
+    const uint32_t sensors{std::max(1u, result["sensors"].as<uint32_t>())};
+    std::vector<std::string> topics;
+    for(uint32_t i=0; i<sensors; ++i) topics.push_back(result["topic"].as<std::string>()+"/s"+std::to_string(i));
+
+    double single{0.0};
+    for(uint32_t shards=1; shards<=result["shards"].as<uint32_t>(); shards*=2)
+    {
+        std::vector<Sample> samples;
+        std::vector<SampleQueue::Stats> stats;
+        uint64_t counted{0};
+        std::atomic<bool> running{true};
+        std::atomic<uint64_t> published{0};
+        {
+            //no session kept, a backlog from the previous round would inflate the next
+            ShardedIngest ingest{IngestOptions{{server}, "sensor_bench_shard", topics, qos, 0,
+                                                64<<20, "/tmp", SampleQueue::DEFAULT_CAPACITY,
+                                                OverloadPolicy::DROP_OLDEST, 4, ahrs::DEFAULT_BETA,
+                                                "", false, "", false, 0.5f, 0.8f, "control",
+                                                result["pin"].as<bool>()},
+                                shards};
+            ingest.start();
+
+            std::vector<std::thread> publishers;
+            for(uint32_t p=0; p<result["publishers"].as<uint32_t>(); ++p)
+            {
+                publishers.emplace_back([&, p](){
+                    mqtt::async_client cli{server, "sensor_bench_publisher_"+std::to_string(p),
+                                        mqtt::create_options(MQTTVERSION_5)};
+                    try
+                    {
+                        cli.connect(mqtt::connect_options_builder().mqtt_version(MQTTVERSION_5).finalize())->wait();
+                        char payload[96];
+                        uint64_t n{p};
+                        uint64_t sent{0};
+                        mqtt::delivery_token_ptr token;
+                        while(running)
+                        {
+                            const int length{std::snprintf(payload, sizeof(payload), "%.6f,%.3f,%.3f,%.3f",
+                                                        steadySeconds(), 10.0, 20.0, 30.0)};
+                            token = cli.publish(topics[n%sensors], payload, static_cast<size_t>(length), qos, false);
+                            ++n;
+                            //bounded in-flight, the client library would buffer without limit
+                            if(++sent%256==0) token->wait();
+                        }
+                        published += sent;
+                        cli.disconnect()->wait();
+                    }
+                    catch(const mqtt::exception& e)
+                    {
+                        spdlog::error("Publisher {}: {}", p, e.what());
+                    }
+                });
+            }
+
+            const double start{steadySeconds()};
+            uint64_t first{0};
+            bool measuring{false};
+            while(steadySeconds()-start<WARMUP+seconds)
+            {
+                ingest.drain(samples);
+                if(!measuring && steadySeconds()-start>=WARMUP)
+                {
+                    first = accepted(ingest, stats);
+                    measuring = true;
+                }
+                std::this_thread::sleep_for(1ms);
+            }
+            counted = accepted(ingest, stats)-first;
+            running = false;
+            for(std::thread& publisher : publishers) publisher.join();
+        }
+
+        const double rate{static_cast<double>(counted)/seconds};
+        if(shards==1) single = rate;
+        spdlog::info("{} shards: {:>10.0f} samples/s, x{:.2f} of one shard, {} published",
+                    shards, rate, single>0.0 ? rate/single : 0.0, published.load());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <cxxopts.hpp>
+#include "mqtt/async_client.h"
+#include "spdlog/spdlog.h"
+#include "listener.hpp"
+#include "sample.hpp"
+#include "sample_queue.hpp"
+#include "ahrs.hpp"
+
+//Ingest throughput of 1..N worker processes sharing one subscription.
+//Publisher threads flood "<topic>/s<i>" for every sensor, the benchmark starts
+//k copies of itself as workers in the group "$share/bench/<topic>/#" and adds up
+//the samples they fused and queued during the measured window.
+//Publishers and workers share the host, so leave cores for the broker.
+//usage: shared_subscription_bench --workers 4 --publishers 2 --seconds 5
+
+using namespace std::chrono_literals;
+
+//subscribing and the first messages are not measured
+constexpr double WARMUP{1.0};
+
+static uint64_t accepted(const SampleQueue& queue, std::vector<SampleQueue::Stats>& stats)
+{
+    queue.stats(stats);
+    uint64_t total{0};
+    for(const SampleQueue::Stats& s : stats) total += s.accepted;
+    return total;
+}
+
+//one worker process, prints "RESULT <samples>" for the measured window
+static int worker(const std::string& server, const std::string& topic, uint32_t index, uint8_t qos, double seconds)
+{
+    spdlog::set_level(spdlog::level::warn);
+    FusionStage fusion{ahrs::DEFAULT_BETA};
+    SampleQueue queue;
+    MQTTListener listener{{server}, "sensor_bench_worker_"+std::to_string(index), topic+"/#", qos, 0};
+    listener.setShareGroup("bench");
+    std::future<bool> setup{std::async(std::launch::async, &MQTTListener::setupMQTT, &listener)};
+    std::future<bool> listen{std::async(std::launch::async, &MQTTListener::listen,
+                                        &listener, std::ref(queue), std::ref(fusion))};
+    if(!setup.get()) return EXIT_FAILURE;
+
+    std::vector<Sample> samples;
+    std::vector<SampleQueue::Stats> stats;
+    const double start{steadySeconds()};
+    uint64_t first{0};
+    bool measuring{false};
+    while(steadySeconds()-start<WARMUP+seconds)
+    {
+        queue.drain(samples);
+        if(!measuring && steadySeconds()-start>=WARMUP)
+        {
+            first = accepted(queue, stats);
+            measuring = true;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    std::printf("RESULT %llu\n", static_cast<unsigned long long>(accepted(queue, stats)-first));
+    std::fflush(stdout);
+    //the listener thread never returns
+    std::_Exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options{"shared_subscription_bench", "Ingest throughput of workers in a shared subscription"};
+    options.add_options()
+    ("server", "broker URI",
+    cxxopts::value<std::string>()->default_value("tcp://127.0.0.1:1883"))
+    ("q, qos", "Quality of service level",
+    cxxopts::value<uint8_t>()->default_value("0"))
+    ("topic", "prefix of the sensor topics",
+    cxxopts::value<std::string>()->default_value("bench/shared"))
+    ("sensors", "number of sensor topics",
+    cxxopts::value<uint32_t>()->default_value("16"))
+    ("workers", "largest number of worker processes",
+    cxxopts::value<uint32_t>()->default_value("4"))
+    ("publishers", "publisher threads",
+    cxxopts::value<uint32_t>()->default_value("2"))
+    ("seconds", "measured seconds per worker count",
+    cxxopts::value<double>()->default_value("5"))
+    ("worker", "internal: run as worker number N",
+    cxxopts::value<uint32_t>())
+    ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if(result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+    const std::string server{result["server"].as<std::string>()};
+    const std::string topic{result["topic"].as<std::string>()};
+    const uint8_t qos{result["qos"].as<uint8_t>()};
+    const double seconds{result["seconds"].as<double>()};
+    if(result.count("worker"))
+    {
+        return worker(server, topic, result["worker"].as<uint32_t>(), qos, seconds);
+    }
+    const uint32_t sensors{std::max(1u, result["sensors"].as<uint32_t>())};
+    std::vector<std::string> topics;
+    for(uint32_t i=0; i<sensors; ++i) topics.push_back(topic+"/s"+std::to_string(i));
+
+    double single{0.0};
+    for(uint32_t workers=1; workers<=result["workers"].as<uint32_t>(); ++workers)
+    {
+        //the workers are copies of this binary, so nothing here is shared with them but the broker
+        std::vector<FILE*> pipes;
+        for(uint32_t i=0; i<workers; ++i)
+        {
+            const std::string command{"/proc/"+std::to_string(getpid())+"/exe --worker "+std::to_string(i)+
+                                    " --server "+server+" --topic "+topic+" --qos "+std::to_string(qos)+
+                                    " --seconds "+std::to_string(seconds)};
+            pipes.push_back(popen(command.c_str(), "r"));
+        }
+
+        std::atomic<bool> running{true};
+        std::atomic<uint64_t> published{0};
+        std::vector<std::thread> publishers;
+        for(uint32_t p=0; p<result["publishers"].as<uint32_t>(); ++p)
+        {
+            publishers.emplace_back([&, p](){
+                mqtt::async_client cli{server, "sensor_bench_publisher_"+std::to_string(p),
+                                    mqtt::create_options(MQTTVERSION_5)};
+                try
+                {
+                    cli.connect(mqtt::connect_options_builder().mqtt_version(MQTTVERSION_5).finalize())->wait();
+                    char payload[96];
+                    uint64_t n{0};
+                    mqtt::delivery_token_ptr token;
+                    while(running)
+                    {
+                        const int length{std::snprintf(payload, sizeof(payload), "%.6f,%.3f,%.3f,%.3f",
+                                                    steadySeconds(), 10.0, 20.0, 30.0)};
+                        token = cli.publish(topics[n%sensors], payload,
+                                            static_cast<size_t>(length), qos, false);
+                        //bounded in-flight, the client library would buffer without limit
+                        if(++n%256==0) token->wait();
+                    }
+                    published += n;
+                    cli.disconnect()->wait();
+                }
+                catch(const mqtt::exception& e)
+                {
+                    spdlog::error("Publisher {}: {}", p, e.what());
+                }
+            });
+        }
+
+        uint64_t total{0};
+        std::vector<uint64_t> counts;
+        for(FILE* pipe : pipes)
+        {
+            char line[128];
+            unsigned long long count{0};
+            while(pipe && std::fgets(line, sizeof(line), pipe))
+            {
+                std::sscanf(line, "RESULT %llu", &count);
+            }
+            if(pipe) pclose(pipe);
+            counts.push_back(count);
+            total += count;
+        }
+        running = false;
+        for(std::thread& publisher : publishers) publisher.join();
+
+        const double rate{static_cast<double>(total)/seconds};
+        if(workers==1) single = rate;
+        const auto [low, high] = std::minmax_element(counts.begin(), counts.end());
+        spdlog::info("{} workers: {:>10.0f} samples/s, x{:.2f} of one worker, per worker {:.0f}..{:.0f}/s, {} published",
+                    workers, rate, single>0.0 ? rate/single : 0.0,
+                    static_cast<double>(*low)/seconds, static_cast<double>(*high)/seconds, published.load());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+extern "C" {
+    #include <glad/glad.h>
+}
+#include <GLFW/glfw3.h>
+#include "spdlog/spdlog.h"
+#include "shader.hpp"
+#include "window.hpp"
+#include "stream_buffer.hpp"
+
+//Compares three ways of uploading a fresh vertex array every frame:
+//  subdata   - glBufferSubData into the same buffer object (implicit sync)
+//  orphan    - glBufferData(NULL) followed by glBufferSubData (driver side renaming)
+//  persistent- gl::StreamBuffer, persistently mapped with three fenced regions
+//usage: stream_buffer_bench [vertices_per_frame] [frames]
+
+const std::string SHADER_PATHS[2]{
+                                    "../shaders/vertex.txt", //vertex shader
+                                    "../shaders/fragment.txt" //fragment shader
+                                };
+
+constexpr uint FLOATS_PER_VERTEX{6};
+constexpr GLsizei STRIDE{FLOATS_PER_VERTEX*sizeof(float)};
+
+static void setAttributes()
+{
+    glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,STRIDE,(void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,STRIDE,(void*)(3*sizeof(float)));
+    glEnableVertexAttribArray(1);
+}
+
+static void fillVertices(float* dst, uint vertex_count, uint frame)
+{
+    for(uint i=0; i<vertex_count; ++i)
+    {
+        float* v = dst + i*FLOATS_PER_VERTEX;
+        v[0] = static_cast<float>(i%1024)/1024.0f;
+        v[1] = static_cast<float>((i+frame)%768)/768.0f;
+        v[2] = 0.0f;
+        v[3] = 1.0f; v[4] = 1.0f; v[5] = 1.0f;
+    }
+}
+
+template<typename Upload>
+static void run(const char* name, uint vertex_count, uint frames, Upload&& upload)
+{
+    glFinish();
+    const auto start{std::chrono::steady_clock::now()};
+    for(uint frame=0; frame<frames; ++frame)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        upload(frame);
+    }
+    glFinish();
+    const std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now()-start};
+    const double bytes{static_cast<double>(vertex_count)*STRIDE*frames};
+    spdlog::info("{:>10}: {:8.3f} ms/frame, {:8.1f} MB/s",
+                name, elapsed.count()/frames, bytes/(elapsed.count()*1e3));
+}
+
+int main(int argc, char** argv)
+{
+    const uint vertex_count{argc>1 ? static_cast<uint>(std::stoul(argv[1])) : 65536u};
+    const uint frames{argc>2 ? static_cast<uint>(std::stoul(argv[2])) : 1000u};
+    const GLsizeiptr frame_bytes{static_cast<GLsizeiptr>(vertex_count)*STRIDE};
+
+    GLFWwindow* window{nullptr};
+    gl::Window frame{window, 600, 800, "stream_buffer_bench"};
+    glfwSwapInterval(0);
+
+    VertexShader vertex_shader{SHADER_PATHS[0]};
+    FragmentShader fragment_shader{SHADER_PATHS[1]};
+    vertex_shader.compile();
+    fragment_shader.compile();
+    uint shader_program{glCreateProgram()};
+    glAttachShader(shader_program, vertex_shader.get());
+    glAttachShader(shader_program, fragment_shader.get());
+    glLinkProgram(shader_program);
+    glUseProgram(shader_program);
+    const float identity[16]{1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    for(const char* name : {"model", "view", "projection"})
+    {
+        glUniformMatrix4fv(glGetUniformLocation(shader_program, name), 1, GL_FALSE, identity);
+    }
+
+    std::vector<float> staging(vertex_count*FLOATS_PER_VERTEX);
+    spdlog::info("Streaming {} vertices ({} KiB) per frame over {} frames",
+                vertex_count, frame_bytes/1024, frames);
+
+    uint VAO[3];
+    uint VBO[2];
+    glGenVertexArrays(3, VAO);
+    glGenBuffers(2, VBO);
+
+    glBindVertexArray(VAO[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, frame_bytes, nullptr, GL_DYNAMIC_DRAW);
+    setAttributes();
+    run("subdata", vertex_count, frames, [&](uint i){
+        fillVertices(staging.data(), vertex_count, i);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, frame_bytes, staging.data());
+        glDrawArrays(GL_POINTS, 0, vertex_count);
+    });
+
+    glBindVertexArray(VAO[1]);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
+    glBufferData(GL_ARRAY_BUFFER, frame_bytes, nullptr, GL_STREAM_DRAW);
+    setAttributes();
+    run("orphan", vertex_count, frames, [&](uint i){
+        fillVertices(staging.data(), vertex_count, i);
+        glBufferData(GL_ARRAY_BUFFER, frame_bytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, frame_bytes, staging.data());
+        glDrawArrays(GL_POINTS, 0, vertex_count);
+    });
+
+    glBindVertexArray(VAO[2]);
+    gl::StreamBuffer stream{GL_ARRAY_BUFFER, frame_bytes};
+    setAttributes();
+    run("persistent", vertex_count, frames, [&](uint i){
+        //vertices are written straight into mapped memory, no staging copy
+        float* dst = static_cast<float*>(stream.begin());
+        fillVertices(dst, vertex_count, i);
+        glDrawArrays(GL_POINTS, static_cast<GLint>(stream.offset()/STRIDE), vertex_count);
+        stream.end();
+    });
+    spdlog::info("persistent: {} fence stalls", stream.stalls());
+
+    glDeleteVertexArrays(3, VAO);
+    glDeleteBuffers(2, VBO);
+    glDeleteProgram(shader_program);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "tiers.hpp"
+#include "sample.hpp"
+
+//Cost of the pre-aggregation tiers on the ingest side, and of reading a plot's
+//worth of history from them. One sensor at 1 kHz is pushed for `hours`, then
+//ranges of 10 s to 1 h are read at 800 columns, the width of the plot. Reading
+//the matching tier touches a few thousand buckets instead of millions of samples.
+//usage: tiers_bench [hours]
+
+int main(int argc, char** argv)
+{
+    const double hours{argc>1 ? std::stod(argv[1]) : 2.0};
+    const double period{1e-3};
+    const size_t steps{static_cast<size_t>(hours*3600.0/period)};
+    const double columns{800.0};
+
+    std::mt19937 rng{3};
+    std::normal_distribution<float> noise{0.0f, 5.0f};
+    std::vector<glm::vec3> values(4096);
+    for(glm::vec3& value : values) value = glm::vec3{noise(rng), noise(rng), noise(rng)};
+    TierStore store{16384};
+    Sample sample{};
+    sample.axes = 3;
+    const auto start{std::chrono::steady_clock::now()};
+    for(size_t i=0; i<steps; ++i)
+    {
+        sample.timestamp = static_cast<double>(i)*period;
+        sample.value = values[i%values.size()];
+        store.push(sample);
+    }
+    const double elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+    spdlog::info("push: {:.1f} ns per sample, tiers hold {} / {} / {} buckets",
+                elapsed/static_cast<double>(steps)*1e9, store.size(0), store.size(1), store.size(2));
+
+    std::vector<Bucket> out;
+    for(double range : {10.0, 60.0, 600.0, 3600.0})
+    {
+        const size_t repeats{1000};
+        size_t read{0};
+        size_t tier{0};
+        const auto begin{std::chrono::steady_clock::now()};
+        for(size_t r=0; r<repeats; ++r)
+        {
+            out.clear();
+            tier = store.select(store.newest()-range, range/columns);
+            read += store.read(store.newest()-range, store.newest(), range/columns, out);
+        }
+        const double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-begin).count()};
+        spdlog::info("{:>6.0f} s at {:.3f} s per column: tier {} ({} s buckets), {} buckets, {:.1f} us per read",
+                    range, range/columns, tier, TierStore::WIDTHS[tier], read/repeats, seconds/repeats*1e6);
+    }
+    return 0;
+}
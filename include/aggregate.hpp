@@ -0,0 +1,119 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "sample.hpp"
+
+//statistics of one channel over one window
+struct Aggregate{
+    uint64_t count;     //samples in the window, 0 if none yet
+    double min;
+    double max;
+    double mean;
+    double variance;    //population variance
+    double rms;
+};
+
+//Running statistics of one channel over a window of `length` seconds.
+//Sliding: the window ends at the newest sample. Mean and variance are updated
+//with Welford's method on the way in and reverted on the way out, min and max
+//come from monotonic deques. The summary is recomputed from the window once as
+//many samples left as it holds, which bounds the rounding drift of the reverts
+//at amortized O(1). Tumbling: the window is the last completed [k*length,
+//(k+1)*length) interval, nothing is stored per sample.
+//Rings grow by doubling until they fit the window, after that no sample allocates.
+class WindowAggregate{
+    public:
+        enum Mode : uint8_t{
+            SLIDING,
+            TUMBLING
+        };
+
+        WindowAggregate(double _length, Mode _mode);
+
+        //samples of one channel in timestamp order, older ones are ignored
+        void push(double _timestamp, double _value);
+        Aggregate get() const;
+        //summary of the samples pushed so far, the open interval when tumbling
+        Aggregate current() const;
+        double length() const {return window_length;}
+
+    private:
+        struct Entry{
+            double t;
+            double value;
+        };
+        //power of two ring used as a deque
+        struct Ring{
+            std::vector<Entry> entries;
+            size_t head{0};
+            size_t count{0};
+            bool empty() const {return count==0;}
+            const Entry& front() const {return entries[head];}
+            const Entry& back() const {return entries[(head+count-1)&(entries.size()-1)];}
+            const Entry& operator[](size_t _i) const {return entries[(head+_i)&(entries.size()-1)];}
+            void push_back(const Entry& _entry);
+            void pop_front() {head = (head+1)&(entries.size()-1); --count;}
+            void pop_back() {--count;}
+        };
+
+        void expire(double _cutoff);
+        void resync();
+        void reset();
+
+        double window_length;
+        Mode mode;
+        double newest;
+        //running summary of the samples in the window
+        uint64_t count;
+        double mean;
+        double m2;
+        double sum_squares;
+        double min;     //tumbling only, sliding uses the deques
+        double max;
+        //sliding only
+        Ring values;
+        Ring mins;      //increasing values, the front is the minimum
+        Ring maxs;      //decreasing values, the front is the maximum
+        uint64_t removed;
+        //tumbling only: index of the open interval and the result of the last closed one
+        int64_t interval;
+        Aggregate closed;
+};
+
+
+//Windowed statistics of the gyro x, y and z rates of every sensor.
+//Every sensor gets one WindowAggregate per window length and channel, created
+//with its first sample. Samples are pushed from one thread, the one that reads.
+class AggregateEngine{
+    public:
+        static constexpr size_t CHANNELS{3};
+
+        AggregateEngine(const std::vector<double>& _lengths, WindowAggregate::Mode _mode);
+
+        void push(const Sample& _sample);
+        //statistics of channel _channel of _sensor over window _window, count 0 if unknown
+        Aggregate get(uint32_t _sensor, size_t _window, size_t _channel) const;
+        size_t sensorCount() const {return sensors.size();}
+        bool known(uint32_t _sensor) const {return _sensor<sensors.size() && !sensors[_sensor].empty();}
+        const std::vector<double>& lengths() const {return window_lengths;}
+        //one "window,channel,count,min,max,mean,variance,rms" line per window and channel of _sensor
+        void format(uint32_t _sensor, std::string& _out) const;
+
+    private:
+        std::vector<double> window_lengths;
+        WindowAggregate::Mode mode;
+        //indexed by sensor id, then window*CHANNELS+channel
+        std::vector<std::vector<WindowAggregate>> sensors;
+};
+
+//parses "sliding" or "tumbling"
+bool parseWindowMode(std::string_view _name, WindowAggregate::Mode& _mode);
+//parses a comma separated list of window lengths in seconds, e.g. "1,10,60"
+bool parseWindowLengths(std::string_view _list, std::vector<double>& _lengths);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef AHRS_H
+#define AHRS_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "sample.hpp"
+
+//Filter state of one sensor, kept small so thousands of them stay cache resident.
+struct AhrsState{
+    float q0, q1, q2, q3;   //orientation quaternion, w first
+    double last_timestamp;
+    bool initialized;
+};
+
+namespace ahrs{
+    constexpr float DEFAULT_BETA{0.1f};
+
+    //Madgwick gradient descent steps. Rates in rad/s, accel and mag in any unit
+    //(they are normalized), dt in seconds. A zero accel or mag vector skips the
+    //corresponding correction.
+    void madgwickIMU(AhrsState& _s, float gx, float gy, float gz,
+                    float ax, float ay, float az, float dt, float beta);
+    void madgwickMARG(AhrsState& _s, float gx, float gy, float gz,
+                    float ax, float ay, float az,
+                    float mx, float my, float mz, float dt, float beta);
+    //gyro only, exact rotation for a constant rate over dt
+    void integrateGyro(AhrsState& _s, float gx, float gy, float gz, float dt);
+}
+
+//Fusion pipeline stage: one Madgwick filter per sensor.
+//3-axis samples are integrated, 6-axis samples are corrected for tilt with the
+//accelerometer and 9-axis samples additionally for heading with the magnetometer.
+class FusionStage{
+    public:
+        //longest time step applied at once, gaps above it restart the time base
+        static constexpr double MAX_STEP{0.5};
+
+        explicit FusionStage(float beta_=ahrs::DEFAULT_BETA);
+
+        //returns the orientation of the sample's sensor after the update
+        glm::quat process(const Sample& _sample);
+        //identity for sensors which did not report yet
+        glm::quat orientation(uint32_t _sensor) const;
+        void setBeta(float _beta) {beta = _beta;}
+
+        //the per-sensor update without locking, shared with benchmarks and batch tools
+        static void update(AhrsState& _state, const Sample& _sample, float _beta);
+
+    private:
+        float beta;
+        mutable std::mutex mx;
+        std::vector<AhrsState> states;
+};
+
+#endif
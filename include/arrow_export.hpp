@@ -0,0 +1,124 @@
+#ifndef ARROW_EXPORT_H
+#define ARROW_EXPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "sample.hpp"
+#include "series_store.hpp"
+#include "query.hpp"
+
+//Writes the Arrow IPC file format (Feather v2), readable by pyarrow.feather,
+//pandas.read_feather and every other Arrow implementation without conversion.
+//The file is the magic, a schema message and one record batch message per write(),
+//then the footer with the schema and the position of every batch. Columns are plain
+//little endian values without nulls; write() takes them as one buffer per field and
+//hands those buffers to a single writev() together with the batch metadata, so
+//column data is never copied on the way to the file. The footer is rewritten behind
+//the last batch on every write(), the file is complete and readable after each one.
+//The metadata is a minimal FlatBuffers encoding of the Arrow Schema, Message and
+//Footer tables built in arrow_export.cpp, no Arrow library is needed.
+class ArrowWriter{
+    public:
+        //body buffers start at multiples of this, as recommended for SIMD access
+        static constexpr size_t ALIGNMENT{64};
+        //rows per record batch of ArrowRecorder and exportArrow()
+        static constexpr size_t BATCH_ROWS{65536};
+
+        enum class Type: uint8_t{
+            UINT32,
+            FLOAT32,
+            FLOAT64
+        };
+        struct Field{
+            std::string name;
+            Type type;
+        };
+        struct Stats{
+            uint64_t batches;
+            uint64_t rows;
+            uint64_t bytes;     //file size
+        };
+
+        ArrowWriter(const std::string& _path, const std::vector<Field>& _fields,
+                    const std::vector<std::pair<std::string, std::string>>& _metadata = {});
+        ~ArrowWriter();
+        ArrowWriter(const ArrowWriter&) = delete;
+        ArrowWriter& operator=(const ArrowWriter&) = delete;
+
+        //false if the file could not be created or a write failed, write() then does nothing
+        bool ok() const {return fd>=0;}
+        //appends one record batch of _rows rows, one buffer of _rows values per field in field order
+        bool write(size_t _rows, const std::vector<const void*>& _columns);
+        //schema metadata of the footer, readers of the file format take the schema from there
+        void setMetadata(const std::string& _key, const std::string& _value);
+        const std::string& path() const {return file_path;}
+        Stats getStats() const {return stats;}
+
+    private:
+        //Block of the Arrow Footer
+        struct Block{
+            int64_t offset;
+            int32_t metadata;   //message prefix, flatbuffer and padding
+            int32_t padding;
+            int64_t body;
+        };
+
+        int fd;
+        std::string file_path;
+        std::vector<Field> fields;
+        std::vector<std::pair<std::string, std::string>> metadata;
+        std::vector<Block> blocks;
+        size_t end;     //behind the last record batch, where the footer starts
+        Stats stats;
+};
+
+
+//Exports the live samples of every sensor to one Arrow file with the columns
+//sensor, t, gx, gy, gz, ax, ay, az, mx, my, mz, qw, qx, qy, qz. Samples are
+//transposed into the column buffers as they are pushed and written as a record
+//batch of ArrowWriter::BATCH_ROWS rows, or fewer once the oldest row waited FLUSH_SECONDS,
+//checked on push() and by flushIdle() for when no samples come in.
+//Channels a sensor does not have are NaN. The topic of every sensor id is kept
+//in the schema metadata as "sensor.<id>".
+class ArrowRecorder{
+    public:
+        static constexpr double FLUSH_SECONDS{10.0};
+
+        ArrowRecorder(const std::string& _path, SeriesRecorder::TopicLookup _topic);
+        ~ArrowRecorder();
+
+        bool ok() const {return writer.ok();}
+        void push(const Sample& _sample);
+        //writes the buffered rows as a record batch, returns false if the write failed
+        bool flush();
+        //flushes if the oldest buffered row arrived FLUSH_SECONDS before _now (steadySeconds)
+        bool flushIdle(double _now);
+        ArrowWriter::Stats getStats() const {return writer.getStats();}
+
+    private:
+        //channels 0-8 gyro, accel, mag, 9-12 orientation w, x, y, z
+        static constexpr size_t CHANNELS{13};
+
+        ArrowWriter writer;
+        SeriesRecorder::TopicLookup topic;
+        std::vector<bool> named;
+        std::vector<uint32_t> sensors;
+        std::vector<double> timestamps;
+        std::vector<float> channels[CHANNELS];
+        double opened;  //arrival of the oldest buffered row
+};
+
+
+//Writes the raw samples of _series in [_from, _to] to the Arrow file _path with the
+//columns t, gx, gy, gz, plus ax, ay, az and mx, my, mz if any segment in the range
+//has them (NaN in those that do not). Segments are decompressed column by column
+//directly into the batch buffers, which go to the file as they are once they hold
+//ArrowWriter::BATCH_ROWS rows (rounded up to whole segments). Returns false if the
+//file could not be written.
+bool exportArrow(const IndexedSeries& _series, double _from, double _to, const std::string& _path,
+                ArrowWriter::Stats& _stats);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef AXES_H
+#define AXES_H
+
+extern "C"{
+    #include <glad/glad.h>
+}
+#include <glm/glm.hpp>
+
+namespace gl{
+    //the three colored axis lines that show the orientation of a sensor.
+    //shared by the subscriber and the latency probe, so both render the same frame.
+    class Axes{
+        public:
+            Axes();
+            ~Axes();
+            Axes(const Axes&) = delete;
+            Axes& operator=(const Axes&) = delete;
+
+            //_program is the vertex.txt/fragment.txt program with model, view and projection uniforms
+            void draw(uint _program, const glm::mat4& _model,
+                    const glm::mat4& _view, const glm::mat4& _projection) const;
+
+        private:
+            uint VAO; //vertex array object
+            uint VBO; //vertex buffer object
+            uint EBO; //element buffer object
+    };
+}
+
+#endif
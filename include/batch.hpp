@@ -0,0 +1,100 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "sample.hpp"
+#include "query.hpp"
+#include "aggregate.hpp"
+#include "ahrs.hpp"
+#include "work_pool.hpp"
+
+//Reprocesses a recording on a WorkStealingPool, one task per segment and stage.
+//Every segment of every sensor passes four stages:
+//  decode   - decompress and apply the calibration, independent of other segments
+//  fuse     - Madgwick filter and tumbling statistics windows, which carry state
+//             from one segment to the next
+//  format   - orientations to CSV text, independent again
+//  write    - append the text and the closed statistics windows to the output
+//             files of the sensor, in order
+//The independent stages run on any worker as soon as they are submitted. A fuse or
+//write task needs its input and the same stage of the previous segment done; the
+//task completing the second of the two submits it. Sensors thereby flow through
+//side by side, and decoding runs at most LOOKAHEAD segments ahead of the writes of
+//its sensor, which bounds the memory. The output equals a sequential run.
+class BatchJob{
+    public:
+        static constexpr size_t LOOKAHEAD{32};
+
+        struct Options{
+            std::string output;             //directory of the result files
+            glm::vec3 bias;                 //subtracted from the gyro rates, deg/s
+            glm::vec3 scale;                //applied after the bias
+            float beta;
+            std::vector<double> windows;    //tumbling statistics windows in seconds, may be empty
+            uint32_t decimate;              //every Nth orientation is exported, 0 for none
+        };
+        struct Stats{
+            uint64_t samples;
+            uint64_t segments;
+            uint64_t bytes;     //written to the result files
+        };
+
+        BatchJob(const SeriesQuery& _query, const Options& _options);
+        ~BatchJob();
+        BatchJob(const BatchJob&) = delete;
+        BatchJob& operator=(const BatchJob&) = delete;
+
+        //processes every segment of every topic of the query, returns false if an output file failed
+        bool run(WorkStealingPool& _pool);
+        Stats getStats() const {return Stats{samples.load(), segments.load(), bytes.load()}; }
+
+    private:
+        struct Link{
+            std::vector<Sample> samples;
+            size_t first;                           //first exported sample after decimation
+            std::string text;
+            std::string statistics;                 //windows closed in this segment
+            std::atomic<uint8_t> fuse_waiting;      //decode and the previous fuse
+            std::atomic<uint8_t> write_waiting;     //format and the previous write
+        };
+        //per sensor state of the chained stages
+        struct Chain{
+            const IndexedSeries* series;
+            std::vector<uint32_t> segments;     //entry indices in start order
+            std::unique_ptr<Link[]> links;
+            AhrsState state;
+            std::vector<WindowAggregate> windows;
+            std::vector<int64_t> intervals;     //open interval per window
+            uint64_t exported;                  //orientations seen, for decimation
+            std::FILE* orientations;
+            std::FILE* summary;
+            bool failed;
+        };
+
+        void decode(Chain& _chain, size_t _link);
+        void fuse(Chain& _chain, size_t _link);
+        void format(Chain& _chain, size_t _link);
+        void write(Chain& _chain, size_t _link);
+        void arriveFuse(Chain& _chain, size_t _link);
+        void arriveWrite(Chain& _chain, size_t _link);
+
+        const SeriesQuery& query;
+        Options options;
+        WorkStealingPool* pool;
+        std::vector<std::unique_ptr<Chain>> chains;
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> segments;
+        std::atomic<uint64_t> bytes;
+};
+
+//"x,y,z" into a vector
+bool parseVector(const std::string& _text, glm::vec3& _out);
+
+#endif
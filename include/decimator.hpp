@@ -0,0 +1,74 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "sample.hpp"
+
+//Per pixel column min/max reduction of a sample stream.
+//Time is cut into fixed buckets of window_length/columns seconds, one bucket per
+//pixel column of the plot. Every sample only widens the min/max of the bucket it
+//falls into, so the cost is O(1) per sample and the plot needs two vertices per
+//column no matter how many samples the window holds.
+class MinMaxDecimator{
+    public:
+        struct Column{
+            int64_t index;      //bucket number counted from the first sample
+            glm::vec3 min;
+            glm::vec3 max;
+            uint32_t count;
+        };
+
+        MinMaxDecimator(uint columns_, float window_length_):
+                                    bucket{static_cast<double>(window_length_)/columns_},
+                                    has_epoch{false},
+                                    epoch{0.0},
+                                    column{0, glm::vec3(0.0f), glm::vec3(0.0f), 0}
+        {
+        }
+
+        //folds the sample into the current column, returns true if it opened a new one
+        bool add(const Sample& _sample)
+        {
+            return add(_sample.timestamp, _sample.value, _sample.value, 1);
+        }
+
+        //the same for a range of _count samples starting at _timestamp, e.g. a pre-aggregated bucket
+        bool add(double _timestamp, const glm::vec3& _min, const glm::vec3& _max, uint32_t _count)
+        {
+            if(!has_epoch)
+            {
+                epoch = _timestamp;
+                has_epoch = true;
+            }
+            const int64_t index{static_cast<int64_t>(std::floor((_timestamp-epoch)/bucket))};
+            //late samples are kept in the current column instead of rewriting history
+            if(column.count==0 || index>column.index)
+            {
+                column = Column{index, _min, _max, _count};
+                return true;
+            }
+            column.min = glm::vec3(std::fmin(column.min.x, _min.x),
+                                   std::fmin(column.min.y, _min.y),
+                                   std::fmin(column.min.z, _min.z));
+            column.max = glm::vec3(std::fmax(column.max.x, _max.x),
+                                   std::fmax(column.max.y, _max.y),
+                                   std::fmax(column.max.z, _max.z));
+            column.count += _count;
+            return false;
+        }
+
+        const Column& current() const {return column;}
+        //plot time of the center of a column, relative to the first sample
+        float columnTime(int64_t _index) const {return static_cast<float>((_index+0.5)*bucket);}
+        double getEpoch() const {return epoch;}
+
+    private:
+        double bucket;
+        bool has_epoch;
+        double epoch;
+        Column column;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef FILTER_BANK_H
+#define FILTER_BANK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "sample.hpp"
+#include "kernels.hpp"
+#include "ahrs.hpp"
+
+//Madgwick IMU filters of many sensors laid out as structure of arrays.
+//Samples are staged per sensor and the whole bank is advanced in one pass, with
+//the kernel picked at startup for the running CPU (see simd::kernels()), so a
+//batch over thousands of sensors keeps the vector units busy instead of running
+//one filter object after the other. Magnetometer data is not used here; 9-axis
+//samples are fused as 6-axis ones.
+//Nothing but filter_bank_bench uses it yet. The subscriber needs the orientation
+//of each sample as it arrives and fuses the magnetometer, so it keeps FusionStage.
+class FilterBank{
+    public:
+        explicit FilterBank(size_t sensors_=0, float beta_=ahrs::DEFAULT_BETA);
+
+        void resize(size_t _sensors);
+        size_t size() const {return q0.size();}
+
+        //stages one sample for its sensor, advancing the bank first if that sensor
+        //already has a sample waiting in the current batch
+        void stage(const Sample& _sample);
+        //stages raw inputs directly (rates in rad/s), used by bulk producers
+        void setInput(size_t _sensor, const glm::vec3& _gyro, const glm::vec3& _accel, float _dt)
+        {
+            gx[_sensor] = _gyro.x; gy[_sensor] = _gyro.y; gz[_sensor] = _gyro.z;
+            ax[_sensor] = _accel.x; ay[_sensor] = _accel.y; az[_sensor] = _accel.z;
+            dt[_sensor] = _dt;
+        }
+        //runs the filter step over every sensor; sensors without input keep their state
+        void advance();
+        //samples staged since the last advance()
+        size_t pendingSamples() const {return pending;}
+
+        glm::quat orientation(size_t _sensor) const
+        {
+            return glm::quat(q0[_sensor], q1[_sensor], q2[_sensor], q3[_sensor]);
+        }
+        simd::Level getLevel() const {return level;}
+        //levels above the detected one fall back to it
+        void setLevel(simd::Level _level);
+        void setBeta(float _beta) {beta = _beta;}
+
+    private:
+        float beta;
+        simd::Level level;
+        size_t pending;
+        //filter state
+        std::vector<float> q0, q1, q2, q3;
+        std::vector<double> last_timestamp;
+        std::vector<uint8_t> initialized;
+        //inputs of the current batch
+        std::vector<float> gx, gy, gz, ax, ay, az, dt;
+};
+
+#endif
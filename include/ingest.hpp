@@ -0,0 +1,101 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include "listener.hpp"
+#include "sample.hpp"
+#include "sample_queue.hpp"
+#include "ahrs.hpp"
+#include "throttle.hpp"
+#include "merge.hpp"
+#include "tiers.hpp"
+
+//everything a shard needs to build its listener, queue and fusion stage
+struct IngestOptions{
+    std::vector<std::string> servers;
+    std::string client_id;
+    std::vector<std::string> topics;    //topic filters, spread over the shards
+    uint8_t qos;
+    uint32_t session_expiry;
+    size_t spill_capacity;              //split between the shards
+    std::string spill_directory;
+    size_t queue_capacity;
+    OverloadPolicy policy;
+    uint32_t downsample;
+    float beta;
+    std::string share_group;
+    bool share_by_topic;                //the broker keeps every topic of the group on one client
+    std::string result_topic;
+    bool throttle;
+    float throttle_depth;
+    float throttle_cpu;
+    std::string control_topic;
+    bool pin;                           //pin shard k's ingest thread to core k
+};
+
+//Ingest over K MQTT connections.
+//Every shard is an MQTTListener with its own connection, ingest thread, fusion
+//stage and sample queue, the topic filters are dealt out round robin. With a
+//share group every shard subscribes all filters in the group instead and the
+//broker balances them; results are only published from a group whose broker
+//dispatches by topic (share_by_topic). Sensor ids are strided by the shard count, so the
+//consumer sees one id space. One shard is the plain single connection setup.
+//Samples come out in order per sensor, or in global timestamp order through a
+//WatermarkMerge with setOrdered(). With setTiers() every drained sample also
+//updates the downsampled history of its sensor.
+class ShardedIngest{
+    public:
+        ShardedIngest(const IngestOptions& _options, uint32_t _shards);
+        ~ShardedIngest();
+        ShardedIngest(const ShardedIngest&) = delete;
+        ShardedIngest& operator=(const ShardedIngest&) = delete;
+
+        //connects and starts the ingest threads, returns at once
+        void start();
+        void stop();
+        //drain() releases the samples of all shards in timestamp order, see WatermarkMerge
+        void setOrdered(double _lateness, double _idle = 0.5);
+        //keeps raw, 1 s and 1 min history per sensor, fed by drain(), see TierStore
+        void setTiers(size_t _raw_capacity, size_t _second_capacity = 3600, size_t _minute_capacity = 1440);
+        //history of _sensor, nullptr without tiers or before its first sample; read on the thread calling drain()
+        const TierStore* tiers(uint32_t _sensor) const
+        {
+            return _sensor<tier_stores.size() ? tier_stores[_sensor].get() : nullptr;
+        }
+        //moves the pending samples of every shard into _out (cleared first), returns their count
+        size_t drain(std::vector<Sample>& _out);
+        //queue counters indexed by sensor id
+        void stats(std::vector<SampleQueue::Stats>& _out);
+        //MQTT topic of _sensor, empty if no shard knows it
+        std::string topic(uint32_t _sensor);
+        //publishes _payload on "<_prefix>/<sensor topic>" through the shard owning the sensor
+        bool publish(uint32_t _sensor, const std::string& _prefix, const std::string& _payload);
+        size_t shardCount() const {return shards.size();}
+        bool ordered() const {return merge!=nullptr;}
+        WatermarkMerge::Stats mergeStats() const {return merge ? merge->getStats() : WatermarkMerge::Stats{};}
+
+    private:
+        struct Shard{
+            std::unique_ptr<FusionStage> fusion;
+            std::unique_ptr<SampleQueue> queue;
+            std::unique_ptr<ThrottleController> throttle;
+            std::unique_ptr<MQTTListener> listener;
+            std::future<bool> setup;
+            std::future<bool> listen;
+        };
+
+        std::vector<Shard> shards;
+        std::unique_ptr<WatermarkMerge> merge;
+        //indexed by sensor id, empty without tiers
+        std::array<size_t, TierStore::TIERS> tier_capacities;
+        std::vector<std::unique_ptr<TierStore>> tier_stores;
+        std::vector<Sample> scratch;
+        std::vector<SampleQueue::Stats> scratch_stats;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "sample.hpp"
+
+//Recent timestamped orientations of one sensor, replayed at a steady delay.
+//Sensor time is mapped to the local steady clock through the smallest transit
+//time seen so far, and the delay follows the measured spread of the transit time
+//(mean + 4 deviations, like a TCP retransmission timer) plus one sample period.
+//Rendering "now - delay" then nearly always falls between two received samples,
+//so bursts and gaps of the transport do not show up as jumps or freezes.
+class JitterBuffer{
+    public:
+        static constexpr size_t CAPACITY{64};
+        //upper bound for the adaptive delay in seconds
+        static constexpr double MAX_DELAY{0.5};
+        //how far past the newest sample extrapolation may reach in seconds
+        static constexpr double MAX_EXTRAPOLATION{0.1};
+
+        enum Result : uint8_t{
+            EMPTY,
+            INTERPOLATE,    //slerp(a, b, t)
+            DIRECT          //a holds the final orientation
+        };
+
+        JitterBuffer();
+
+        //samples older than the newest one are ignored
+        void push(double _timestamp, double _arrival, const glm::quat& _q);
+        //orientation to show at local steady time _now. Without extrapolation the
+        //buffer is read at _now - delay(); with it at _now, predicting forward
+        //from the last two samples when _now is past the newest one.
+        Result bracket(double _now, bool _extrapolate, glm::quat& _a, glm::quat& _b, float& _t) const;
+
+        double delay() const {return target_delay;}
+        double jitter() const {return transit_dev;}
+
+    private:
+        struct Entry{
+            double t;
+            glm::quat q;
+        };
+        const Entry& at(size_t _age) const {return entries[(head+CAPACITY-1-_age)%CAPACITY];}
+
+        std::array<Entry, CAPACITY> entries;
+        size_t head;
+        size_t count;
+        double offset;          //local time minus sensor time of the fastest sample
+        double last_arrival;
+        double transit_mean;    //transit time above the fastest one
+        double transit_dev;
+        double period;
+        double target_delay;
+};
+
+//One JitterBuffer per sensor; interpolates all sensors of a frame in a single
+//batched slerp call.
+class OrientationJitter{
+    public:
+        explicit OrientationJitter(bool extrapolate_=false):extrapolate{extrapolate_}{}
+
+        //_sample.orientation is the fused orientation after the sample
+        void push(const Sample& _sample);
+        //orientation of every sensor at local steady time _now, identity for
+        //sensors without data
+        void sample(double _now, std::vector<glm::quat>& _out);
+
+        const JitterBuffer& buffer(uint32_t _sensor) const {return buffers[_sensor];}
+        size_t size() const {return buffers.size();}
+
+    private:
+        bool extrapolate;
+        std::vector<JitterBuffer> buffers;
+        //slerp batch scratch, one lane per interpolated sensor
+        std::vector<float> a_w, a_x, a_y, a_z, b_w, b_x, b_y, b_z, t, o_w, o_x, o_y, o_z;
+        std::vector<uint32_t> lanes;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "simd.hpp"
+#include "madgwick_batch.hpp"
+#include "quat_kernels.hpp"
+
+namespace simd{
+    //Batched kernels of one ISA. The table of the best level available is picked
+    //once at startup; every entry handles any array length.
+    struct Kernels{
+        Level level;
+        void (*madgwickIMU)(const ImuBatchView& _batch);
+        void (*quatMultiply)(const QuatSoA& _a, const QuatSoA& _b, const QuatSoA& _out, size_t _n);
+        void (*quatNormalize)(const QuatSoA& _q, size_t _n);
+        void (*rotateVector)(const QuatSoA& _q, const Vec3SoA& _v, const Vec3SoA& _out, size_t _n);
+        void (*quatSlerp)(const QuatSoA& _a, const QuatSoA& _b, const float* _t, const QuatSoA& _out, size_t _n);
+    };
+
+namespace{
+    template<typename V>
+    constexpr Kernels makeKernels(Level _level)
+    {
+        return Kernels{_level,
+                    madgwickIMUBatch<V>,
+                    quatMultiplyBatch<V>,
+                    quatNormalizeBatch<V>,
+                    rotateVectorBatch<V>,
+                    quatSlerpBatch<V>};
+    }
+}
+
+    //kernels of the detected level
+    const Kernels& kernels();
+    //kernels of the requested level, or of the detected one if it is not available
+    const Kernels& kernels(Level _level);
+
+#if defined(SENSOR_HAVE_X86_KERNELS)
+    //defined in simd_<isa>.cpp, the only units compiled with the matching -m flags
+    const Kernels& kernelsSse42();
+    const Kernels& kernelsAvx2();
+    const Kernels& kernelsAvx512();
+#endif
+}
+
+#endif
@@ -5,15 +5,26 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <future>
 #include <mutex>
 #include <chrono>
+#include <unordered_map>
+#include <array>
+#include <atomic>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "mqtt/client.h"
+#include "mqtt/async_client.h"
 #include "mqtt/topic.h"
+#include "sample.hpp"
+#include "sample_queue.hpp"
+#include "ahrs.hpp"
+#include "sequence.hpp"
+#include "throttle.hpp"
+#include "reconnect.hpp"
+#include "spill_buffer.hpp"
 
 using namespace std::chrono_literals;
 
@@ -24,23 +35,99 @@ class MQTTListener{
         bool ready;
         uint8_t QOS;
         const std::string client_id;
-        const std::string server_address;
-        std::string topic_name;
-        mqtt::client cli;
-        mqtt::connect_options connOpts;
+        //redundant brokers, ReconnectManager picks one and fails over to the others
+        const std::vector<std::string> servers;
+        //topic filters subscribed, the first one comes with the constructor
+        std::vector<std::string> topic_names;
+        ReconnectManager reconnect;
+        //filled by the transport callback, drained by listen()
+        SpillBuffer spill;
+        uint64_t spill_rejected;
+        //every topic seen on the subscription is one sensor, looked up without a copy of the topic
+        struct TopicHash{
+            using is_transparent = void;
+            size_t operator()(std::string_view _topic) const {return std::hash<std::string_view>{}(_topic);}
+        };
+        std::unordered_map<std::string, uint32_t, TopicHash, std::equal_to<>> sensor_ids;
+        std::vector<std::string> sensor_topics;
+        //sensor_topics grows on the ingest thread, publishSensor() reads it from others
+        std::mutex topics_mx;
+        //indexed by sensor id, only used for messages carrying a "seq" user property
+        std::vector<SequenceTracker> sequences;
+        double stats_time;
+        //optional flow control, commands go to "<control_prefix>/<sensor topic>"
+        ThrottleController* throttle;
+        std::string control_prefix;
+        std::vector<std::pair<uint32_t, ThrottleCommand>> commands;
+        std::vector<ThrottleCommand> throttled;   //last command sent per sensor
+        //optional MQTT v5 shared subscription, the broker splits the messages between the group
+        std::string share_group;
+        //optional republishing of fused orientations, batched per sensor on "<result_prefix>/<sensor topic>"
+        std::string result_prefix;
+        std::vector<std::string> results;
+        double result_time;
+        //position among the shards of a ShardedIngest, the ingest thread is pinned to core if >=0
+        uint32_t shard_index;
+        uint32_t shard_count;
+        int core;
+        std::atomic<bool> stopping;
+
+        bool decodeSample(const char* _line, size_t _len, Sample& _sample);
+        void deliver(Sample& _sample, SampleQueue& _queue, FusionStage& _fusion);
+        void expireSequences(double _now, SampleQueue& _queue, FusionStage& _fusion);
+        void logSequenceStats(double _now);
+        void throttleSensors(double _now, const SampleQueue& _queue);
+        void publishResults(double _now);
+        static bool pinThread(int _core);
     
     public:
-        MQTTListener(const std::string _address,
+        //longest payload layout: timestamp, gyro, accel and mag x,y,z
+        static constexpr size_t MAX_FIELDS{10};
+        //seconds between two sequence statistics reports
+        static constexpr double STATS_INTERVAL{10.0};
+        //records handled per wakeup before expiry and throttling get their turn
+        static constexpr size_t DRAIN_BATCH{256};
+        //seconds between two batches of republished orientations
+        static constexpr double RESULT_INTERVAL{0.05};
+
+        MQTTListener(const std::vector<std::string> _servers,
                     const std::string _client_id,
                     const std::string _topic_name,
-                    const uint8_t _qos);
+                    const uint8_t _qos,
+                    const uint32_t _session_expiry = 300,
+                    const size_t _spill_capacity = 64<<20,
+                    const std::string _spill_directory = "/tmp");
 
         ~MQTTListener();
 
-        glm::vec3 decodeBuffer(const char* _str);
-        bool data_handler(const mqtt::message& _msg, glm::vec3& _angles);
+        //comma separated numbers into _fields, 0 if a field is malformed, not finite or beyond the float range
+        size_t decodeBuffer(const char* _str, size_t _len, std::array<double, MAX_FIELDS>& _fields);
+        bool data_handler(const SpillBuffer::Record& _record, SampleQueue& _queue, FusionStage& _fusion);
+        uint32_t sensorId(std::string_view _topic);
+        //publisher counter from the MQTT v5 user property "seq", false if the message has none;
+        //_epoch from the "epoch" property if the publisher sends one, else 0
+        static bool sequenceNumber(const mqtt::message& _msg, uint32_t& _seq, uint32_t& _epoch);
+        //enables publisher throttling, must be called before listen()
+        void setThrottle(ThrottleController* _throttle, const std::string& _control_prefix);
+        //another topic filter on the same connection, must be called before setupMQTT()
+        void addTopic(const std::string& _topic_name);
+        //sensor ids become local*_count+_index, listen() pins its thread to _core unless negative
+        void setShard(uint32_t _index, uint32_t _count, int _core = -1);
+        //ends listen() and disconnects, callable from any thread
+        void stop();
+        //subscribes "$share/<_group>/<topic>" instead of the topic, must be called before setupMQTT()
+        void setShareGroup(const std::string& _group);
+        //republishes "t,w,x,y,z" per fused sample, must be called before listen()
+        void setResultTopic(const std::string& _result_prefix);
+        //topic of sensor id _sensor, callable from any thread, false if this listener does not own it
+        bool sensorTopic(uint32_t _sensor, std::string& _topic);
+        //publishes _payload on "<_prefix>/<topic of _sensor>", callable from any thread,
+        //false if the sensor is not known to this listener or the broker refused it
+        bool publishSensor(uint32_t _sensor, const std::string& _prefix, const std::string& _payload);
         bool setupMQTT();
-        bool listen(glm::vec3& _angles);
+        bool listen(SampleQueue& _queue, FusionStage& _fusion);
+        ReconnectManager::Stats reconnectStats() const {return reconnect.getStats();}
+        SpillBuffer::Stats spillStats() const {return spill.getStats();}
 
 };
 
@@ -0,0 +1,94 @@
+#ifndef MADGWICK_BATCH_H
+#define MADGWICK_BATCH_H
+
+#include <cstddef>
+#include "simd.hpp"
+
+//Structure-of-arrays view over a FilterBank step: one lane per sensor.
+//Rates in rad/s, accel in any unit, dt in seconds. A lane with dt==0 keeps its
+//orientation, a lane with zero accel is integrated without correction.
+struct ImuBatchView{
+    float* q0;
+    float* q1;
+    float* q2;
+    float* q3;
+    const float* gx;
+    const float* gy;
+    const float* gz;
+    const float* ax;
+    const float* ay;
+    const float* az;
+    const float* dt;
+    size_t count;
+    float beta;
+};
+
+namespace simd{
+namespace{
+    //Madgwick IMU update for V::WIDTH sensors at once, the lane-wise twin of
+    //ahrs::madgwickIMU with branches replaced by masks
+    template<typename V>
+    inline void madgwickIMU(V& q0, V& q1, V& q2, V& q3,
+                            V gx, V gy, V gz, V ax, V ay, V az, V dt, V beta)
+    {
+        V qDot1{V(0.5f)*(-q1*gx - q2*gy - q3*gz)};
+        V qDot2{V(0.5f)*(q0*gx + q2*gz - q3*gy)};
+        V qDot3{V(0.5f)*(q0*gy - q1*gz + q3*gx)};
+        V qDot4{V(0.5f)*(q0*gz + q1*gy - q2*gx)};
+
+        const V accel_norm{ax*ax + ay*ay + az*az};
+        const auto has_accel{greater(accel_norm, V(0.0f))};
+        V recipNorm{V(1.0f)/sqrt(select(has_accel, accel_norm, V(1.0f)))};
+        ax = ax*recipNorm;
+        ay = ay*recipNorm;
+        az = az*recipNorm;
+
+        const V _2q0{V(2.0f)*q0}, _2q1{V(2.0f)*q1}, _2q2{V(2.0f)*q2}, _2q3{V(2.0f)*q3};
+        const V _4q0{V(4.0f)*q0}, _4q1{V(4.0f)*q1}, _4q2{V(4.0f)*q2};
+        const V _8q1{V(8.0f)*q1}, _8q2{V(8.0f)*q2};
+        const V q0q0{q0*q0}, q1q1{q1*q1}, q2q2{q2*q2}, q3q3{q3*q3};
+
+        const V s0{_4q0*q2q2 + _2q2*ax + _4q0*q1q1 - _2q1*ay};
+        const V s1{_4q1*q3q3 - _2q3*ax + V(4.0f)*q0q0*q1 - _2q0*ay - _4q1 + _8q1*q1q1 + _8q1*q2q2 + _4q1*az};
+        const V s2{V(4.0f)*q0q0*q2 + _2q0*ax + _4q2*q3q3 - _2q3*ay - _4q2 + _8q2*q1q1 + _8q2*q2q2 + _4q2*az};
+        const V s3{V(4.0f)*q1q1*q3 - _2q1*ax + V(4.0f)*q2q2*q3 - _2q2*ay};
+        const V step_norm{s0*s0 + s1*s1 + s2*s2 + s3*s3};
+        const auto has_step{has_accel & greater(step_norm, V(0.0f))};
+        recipNorm = V(1.0f)/sqrt(select(has_step, step_norm, V(1.0f)));
+        const V gain{select(has_step, beta*recipNorm, V(0.0f))};
+        qDot1 = qDot1 - gain*s0;
+        qDot2 = qDot2 - gain*s1;
+        qDot3 = qDot3 - gain*s2;
+        qDot4 = qDot4 - gain*s3;
+
+        q0 = q0 + qDot1*dt;
+        q1 = q1 + qDot2*dt;
+        q2 = q2 + qDot3*dt;
+        q3 = q3 + qDot4*dt;
+        recipNorm = V(1.0f)/sqrt(q0*q0 + q1*q1 + q2*q2 + q3*q3);
+        q0 = q0*recipNorm;
+        q1 = q1*recipNorm;
+        q2 = q2*recipNorm;
+        q3 = q3*recipNorm;
+    }
+
+    //advances every lane of the batch, V::WIDTH sensors per step
+    template<typename V>
+    void madgwickIMUBatch(const ImuBatchView& b)
+    {
+        forLanes<V>(b.count, [&]<typename W>(size_t i){
+            W q0{W::load(b.q0+i)}, q1{W::load(b.q1+i)}, q2{W::load(b.q2+i)}, q3{W::load(b.q3+i)};
+            madgwickIMU(q0, q1, q2, q3,
+                        W::load(b.gx+i), W::load(b.gy+i), W::load(b.gz+i),
+                        W::load(b.ax+i), W::load(b.ay+i), W::load(b.az+i),
+                        W::load(b.dt+i), W(b.beta));
+            q0.store(b.q0+i);
+            q1.store(b.q1+i);
+            q2.store(b.q2+i);
+            q3.store(b.q3+i);
+        });
+    }
+}
+}
+
+#endif
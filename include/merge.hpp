@@ -0,0 +1,64 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <cstdint>
+#include <vector>
+#include "sample.hpp"
+
+//Merges per-sensor streams into one stream in timestamp order.
+//Every sensor is a source whose samples arrive in timestamp order. They wait in
+//a ring per source, and a winner tree over the oldest waiting sample of every
+//source picks the next one in O(log K). A sample is released once no active
+//source can still deliver an older one: the watermark is the lowest newest
+//timestamp over the active sources, but never lags the newest timestamp seen by
+//more than the lateness. Sources without a sample for `idle` seconds (arrival
+//time) stop holding the watermark back. A sample older than one already released
+//is late, it is counted and dropped.
+//Timestamps of different sensors are only comparable if they share a clock, e.g.
+//samples stamped on arrival or by synchronized sensors.
+class WatermarkMerge{
+    public:
+        struct Stats{
+            uint64_t merged;    //released in order
+            uint64_t late;      //dropped, older than the watermark on arrival
+            uint64_t waiting;   //held right now
+            double watermark;   //timestamp released up to
+        };
+
+        explicit WatermarkMerge(double _lateness = 0.1, double _idle = 0.5);
+
+        void push(const Sample& _sample);
+        //appends every sample up to the watermark to _out in timestamp order, returns their count
+        size_t pop(double _now, std::vector<Sample>& _out);
+        //releases everything still waiting, e.g. at the end of a recording
+        size_t flush(std::vector<Sample>& _out);
+        Stats getStats() const;
+
+    private:
+        struct Source{
+            std::vector<Sample> ring;   //capacity is a power of two, grows when full
+            size_t head;
+            size_t count;
+            double newest;              //timestamp of the last sample pushed
+            double arrival;             //steady clock seconds of the last sample pushed
+        };
+
+        void addSources(uint32_t _count);
+        //recomputes the path from the leaf of _source to the root
+        void update(uint32_t _source);
+        size_t release(double _watermark, std::vector<Sample>& _out);
+
+        double lateness;
+        double idle;
+        std::vector<Source> sources;
+        //winner tree: leaves at [leaves, 2*leaves), node i holds the source with the
+        //oldest head below it, keys caches the head timestamp of every leaf
+        uint32_t leaves;
+        std::vector<uint32_t> tree;
+        std::vector<double> keys;
+        double newest;
+        double released;
+        Stats stats;
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <cxxopts.hpp>
 #include <cstdlib>
 #include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
 
 
 
@@ -27,12 +30,73 @@ class ArgParser{
                 cxxopts::value<std::string>()->default_value("127.0.0.1"))
                 ("server_port", "port number of the remote device",
                 cxxopts::value<uint16_t>()->default_value("1883"))
+                ("servers", "comma separated redundant brokers, ip or ip:port, replaces server and server_port",
+                cxxopts::value<std::string>()->default_value(""))
                 ("q, qos", "Quality of service level",
                 cxxopts::value<uint8_t>()->default_value("0"))
-                ("topic", "the name of the topic at which MQTT broker service runs",
+                ("topic", "the name of the topic at which MQTT broker service runs, comma separated for several filters",
                 cxxopts::value<std::string>()->default_value("coords"))
                 ("client_id", "name of the client project",
                 cxxopts::value<std::string>()->default_value("sensor_listener"))
+                ("history", "length of the plotted angle history in seconds",
+                cxxopts::value<float>()->default_value("10"))
+                ("beta", "gain of the Madgwick orientation filter",
+                cxxopts::value<float>()->default_value("0.1"))
+                ("extrapolate", "predict the orientation past the newest sample instead of showing it delayed",
+                cxxopts::value<bool>()->default_value("false"))
+                ("queue_capacity", "samples buffered per sensor between the listener and the renderer",
+                cxxopts::value<uint32_t>()->default_value("4096"))
+                ("queue_policy", "what to drop when the renderer falls behind: drop_oldest, drop_newest, coalesce or downsample",
+                cxxopts::value<std::string>()->default_value("drop_oldest"))
+                ("downsample", "keep every Nth sample of an overloaded sensor with the downsample policy",
+                cxxopts::value<uint32_t>()->default_value("4"))
+                ("throttle", "ask publishers to slow down while the subscriber is overloaded",
+                cxxopts::value<bool>()->default_value("false"))
+                ("throttle_depth", "queue fill fraction of a sensor that counts as overload",
+                cxxopts::value<float>()->default_value("0.5"))
+                ("throttle_cpu", "busy fraction of the listener thread that counts as overload",
+                cxxopts::value<float>()->default_value("0.8"))
+                ("control_topic", "prefix of the topics throttle requests are sent on",
+                cxxopts::value<std::string>()->default_value("control"))
+                ("session_expiry", "seconds the broker keeps the session and queued messages after a disconnect",
+                cxxopts::value<uint32_t>()->default_value("300"))
+                ("spill_mb", "size of the memory mapped buffer absorbing bursts from the broker in MiB",
+                cxxopts::value<uint32_t>()->default_value("64"))
+                ("spill_dir", "directory of the spill buffer file",
+                cxxopts::value<std::string>()->default_value("/tmp"))
+                ("share_group", "join a shared subscription group, the broker splits the messages between its members",
+                cxxopts::value<std::string>()->default_value(""))
+                ("share_by_topic", "the broker of the share group sends all messages of a topic to the same member, "
+                "required for --result_topic with --share_group",
+                cxxopts::value<bool>()->default_value("false"))
+                ("headless", "run as a worker without a window",
+                cxxopts::value<bool>()->default_value("false"))
+                ("result_topic", "prefix of the topics fused orientations are republished on, empty to disable",
+                cxxopts::value<std::string>()->default_value(""))
+                ("shards", "MQTT connections the topic filters are spread over, each with its own ingest thread",
+                cxxopts::value<uint32_t>()->default_value("1"))
+                ("pin", "pin every ingest thread to its own core",
+                cxxopts::value<bool>()->default_value("false"))
+                ("ordered", "hand samples of all sensors to the renderer in timestamp order",
+                cxxopts::value<bool>()->default_value("false"))
+                ("lateness", "seconds the ordered merge waits for a slow sensor",
+                cxxopts::value<double>()->default_value("0.1"))
+                ("aggregate", "comma separated window lengths in seconds for per sensor statistics, empty to disable",
+                cxxopts::value<std::string>()->default_value(""))
+                ("aggregate_mode", "statistics windows: sliding or tumbling",
+                cxxopts::value<std::string>()->default_value("sliding"))
+                ("aggregate_topic", "prefix of the topics window statistics are republished on once per second, empty to disable",
+                cxxopts::value<std::string>()->default_value(""))
+                ("tier_raw", "raw samples kept per sensor next to the 1 s and 1 min history tiers, 0 to disable",
+                cxxopts::value<uint32_t>()->default_value("16384"))
+                ("record", "directory every sensor is recorded to as a compressed series file, empty to disable",
+                cxxopts::value<std::string>()->default_value(""))
+                ("arrow", "file the live samples of every sensor are exported to in the Arrow IPC file format, empty to disable",
+                cxxopts::value<std::string>()->default_value(""))
+                ("playback", "replay a --record directory with a timeline instead of subscribing, empty to disable",
+                cxxopts::value<std::string>()->default_value(""))
+                ("playback_speed", "recording seconds played per second",
+                cxxopts::value<double>()->default_value("1"))
                 ("h,help", "Print usage");
             }
             ~ArgParser()
@@ -59,10 +123,40 @@ class ArgParser{
             result_ = options_.parse(argc, argv);
             server_ip = result_["server"].as<std::string>();
             server_port = result_["server_port"].as<uint16_t>();
+            servers = result_["servers"].as<std::string>();
             qos = result_["qos"].as<uint8_t>();
             topic = result_["topic"].as<std::string>();
             cn = result_["type"].as<std::string>();
             client_id = result_["client_id"].as<std::string>();
+            history = result_["history"].as<float>();
+            beta = result_["beta"].as<float>();
+            extrapolate = result_["extrapolate"].as<bool>();
+            queue_capacity = result_["queue_capacity"].as<uint32_t>();
+            queue_policy = result_["queue_policy"].as<std::string>();
+            downsample = result_["downsample"].as<uint32_t>();
+            throttle = result_["throttle"].as<bool>();
+            throttle_depth = result_["throttle_depth"].as<float>();
+            throttle_cpu = result_["throttle_cpu"].as<float>();
+            control_topic = result_["control_topic"].as<std::string>();
+            session_expiry = result_["session_expiry"].as<uint32_t>();
+            spill_mb = result_["spill_mb"].as<uint32_t>();
+            spill_dir = result_["spill_dir"].as<std::string>();
+            share_group = result_["share_group"].as<std::string>();
+            share_by_topic = result_["share_by_topic"].as<bool>();
+            headless = result_["headless"].as<bool>();
+            result_topic = result_["result_topic"].as<std::string>();
+            shards = result_["shards"].as<uint32_t>();
+            pin = result_["pin"].as<bool>();
+            ordered = result_["ordered"].as<bool>();
+            lateness = result_["lateness"].as<double>();
+            aggregate = result_["aggregate"].as<std::string>();
+            aggregate_mode = result_["aggregate_mode"].as<std::string>();
+            aggregate_topic = result_["aggregate_topic"].as<std::string>();
+            tier_raw = result_["tier_raw"].as<uint32_t>();
+            record = result_["record"].as<std::string>();
+            arrow = result_["arrow"].as<std::string>();
+            playback = result_["playback"].as<std::string>();
+            playback_speed = result_["playback_speed"].as<double>();
         }
 
 
@@ -80,11 +174,67 @@ class ArgParser{
             return cn+"://"+server_ip+":"+std::to_string(server_port);
         }
         
+        //every broker to connect to, the single server unless a list was given
+        std::vector<std::string> getServers() const
+        {
+            if(servers.empty()) return {getServer()};
+            std::vector<std::string> uris;
+            std::stringstream list{servers};
+            std::string host;
+            while(std::getline(list, host, ','))
+            {
+                if(host.empty()) continue;
+                if(host.find(':')==std::string::npos) host += ":"+std::to_string(server_port);
+                uris.push_back(cn+"://"+host);
+            }
+            return uris;
+        }
+        
         uint16_t getServerPort() const {return server_port;}
         uint8_t getQualityLevel() const {return qos;}
         std::string getTopic() const {return topic;}
+        std::vector<std::string> getTopics() const
+        {
+            std::vector<std::string> filters;
+            std::stringstream list{topic};
+            std::string filter;
+            while(std::getline(list, filter, ','))
+            {
+                if(!filter.empty()) filters.push_back(filter);
+            }
+            return filters;
+        }
         std::string getConnectionType() const {return cn;}
         std::string getClientID() const {return client_id;}
+        float getHistoryLength() const {return history;}
+        float getBeta() const {return beta;}
+        bool getExtrapolate() const {return extrapolate;}
+        uint32_t getQueueCapacity() const {return queue_capacity;}
+        std::string getQueuePolicy() const {return queue_policy;}
+        uint32_t getDownsample() const {return downsample;}
+        bool getThrottle() const {return throttle;}
+        float getThrottleDepth() const {return throttle_depth;}
+        float getThrottleCpu() const {return throttle_cpu;}
+        std::string getControlTopic() const {return control_topic;}
+        uint32_t getSessionExpiry() const {return session_expiry;}
+        size_t getSpillCapacity() const {return static_cast<size_t>(spill_mb)<<20;}
+        std::string getSpillDirectory() const {return spill_dir;}
+        std::string getShareGroup() const {return share_group;}
+        bool getShareByTopic() const {return share_by_topic;}
+        bool getHeadless() const {return headless;}
+        std::string getResultTopic() const {return result_topic;}
+        uint32_t getShards() const {return shards;}
+        bool getPin() const {return pin;}
+        bool getOrdered() const {return ordered;}
+        double getLateness() const {return lateness;}
+        std::string getAggregate() const {return aggregate;}
+        std::string getAggregateMode() const {return aggregate_mode;}
+        std::string getAggregateTopic() const {return aggregate_topic;}
+        uint32_t getTierRaw() const {return tier_raw;}
+        std::string getRecord() const {return record;}
+        std::string getArrow() const {return arrow;}
+        std::string getPlayback() const {return playback;}
+        double getPlaybackSpeed() const {return playback_speed;}
 
 
     private:
@@ -92,10 +242,40 @@ class ArgParser{
             cxxopts::ParseResult result_;
             std::string server_ip;
             uint16_t server_port;
+            std::string servers;
             uint8_t qos;
             std::string topic;
             std::string cn;
             std::string client_id;       
+            float history;
+            float beta;
+            bool extrapolate;
+            uint32_t queue_capacity;
+            std::string queue_policy;
+            uint32_t downsample;
+            bool throttle;
+            float throttle_depth;
+            float throttle_cpu;
+            std::string control_topic;
+            uint32_t session_expiry;
+            uint32_t spill_mb;
+            std::string spill_dir;
+            std::string share_group;
+            bool share_by_topic;
+            bool headless;
+            std::string result_topic;
+            uint32_t shards;
+            bool pin;
+            bool ordered;
+            double lateness;
+            std::string aggregate;
+            std::string aggregate_mode;
+            std::string aggregate_topic;
+            uint32_t tier_raw;
+            std::string record;
+            std::string arrow;
+            std::string playback;
+            double playback_speed;
             static inline ArgParser* parser_{nullptr};
             static std::mutex mx_; 
 };
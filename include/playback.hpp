@@ -0,0 +1,88 @@
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "sample.hpp"
+#include "query.hpp"
+#include "tiers.hpp"
+#include "ahrs.hpp"
+
+//Replays a directory written with --record, one sensor per topic.
+//The renderer moves a cursor through the recording with seek(). A prefetch thread
+//keeps the samples from _behind seconds before the cursor to PREFETCH_AHEAD after
+//it decoded and fused in a Chunk, which is only swapped in once complete. Reading
+//a frame is a binary search in the current chunk, so the renderer never waits for
+//the disk or the decoder: while a distant seek loads, the last orientation stays
+//on screen. A chunk continuing the previous one carries its filter state over, so
+//orientations do not jump while playing; after a seek the filter settles over
+//WARMUP seconds of samples before the cursor.
+class Playback{
+    public:
+        static constexpr double PREFETCH_AHEAD{20.0};
+        static constexpr double WARMUP{5.0};
+        //intervals of the timeline overview, read from the index summaries
+        static constexpr size_t OVERVIEW_COLUMNS{4096};
+
+        Playback(const std::string& _directory, double _behind, float _beta = ahrs::DEFAULT_BETA);
+        ~Playback();
+        Playback(const Playback&) = delete;
+        Playback& operator=(const Playback&) = delete;
+
+        //indexes the recording and starts prefetching at its beginning, false if it holds no series
+        bool open();
+        size_t sensorCount() const {return topics.size();}
+        const std::string& topic(uint32_t _sensor) const {return topics[_sensor];}
+        double begin() const {return first;}
+        double end() const {return last;}
+        //min/max/mean of the whole recording of _sensor in OVERVIEW_COLUMNS intervals
+        const std::vector<Bucket>& overview(uint32_t _sensor) const {return overviews[_sensor];}
+
+        //moves the cursor, clamped to the recording; the prefetch thread follows it
+        void seek(double _t);
+        double position() const;
+        //orientation of _sensor at _t, interpolated between the samples around it;
+        //false if the current chunk does not reach _t yet
+        bool orientation(uint32_t _sensor, double _t, glm::quat& _q) const;
+        //appends the samples of _sensor in (_from, _to], false if the chunk does not cover the range
+        bool samples(uint32_t _sensor, double _from, double _to, std::vector<Sample>& _out) const;
+
+    private:
+        struct Chunk{
+            double from;
+            double to;
+            std::vector<std::vector<Sample>> sensors;   //fused, in time order
+        };
+
+        std::shared_ptr<const Chunk> current() const;
+        bool stale(double _cursor) const;
+        void prefetch();
+        void load(double _cursor, const Chunk* _previous, Chunk& _chunk);
+
+        SeriesQuery query;      //owned by the prefetch thread once started
+        std::string directory;
+        double behind;
+        float beta;
+        std::vector<std::string> topics;
+        std::vector<std::vector<Bucket>> overviews;
+        double first;
+        double last;
+        std::vector<Sample> scratch;
+
+        mutable std::mutex mx;
+        std::condition_variable wake;
+        std::shared_ptr<const Chunk> chunk;
+        double cursor;
+        bool running;
+        std::thread thread;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef QUAT_KERNELS_H
+#define QUAT_KERNELS_H
+
+#include <cstddef>
+#include "simd.hpp"
+
+//Quaternion and vector arrays stored component by component.
+//Quaternions are (w, x, y, z) like glm::quat's constructor.
+struct QuatSoA{
+    float* w;
+    float* x;
+    float* y;
+    float* z;
+};
+
+struct Vec3SoA{
+    float* x;
+    float* y;
+    float* z;
+};
+
+namespace simd{
+namespace{
+    template<typename V>
+    inline void quatMultiply(V aw, V ax, V ay, V az, V bw, V bx, V by, V bz,
+                            V& w, V& x, V& y, V& z)
+    {
+        w = aw*bw - ax*bx - ay*by - az*bz;
+        x = aw*bx + ax*bw + ay*bz - az*by;
+        y = aw*by - ax*bz + ay*bw + az*bx;
+        z = aw*bz + ax*by - ay*bx + az*bw;
+    }
+
+    template<typename V>
+    inline void quatNormalize(V& w, V& x, V& y, V& z)
+    {
+        const V recipNorm{V(1.0f)/sqrt(w*w + x*x + y*y + z*z)};
+        w = w*recipNorm;
+        x = x*recipNorm;
+        y = y*recipNorm;
+        z = z*recipNorm;
+    }
+
+    //v' = v + w*t + q.xyz x t with t = 2*(q.xyz x v), q unit length
+    template<typename V>
+    inline void rotateVector(V qw, V qx, V qy, V qz, V& vx, V& vy, V& vz)
+    {
+        const V tx{V(2.0f)*(qy*vz - qz*vy)};
+        const V ty{V(2.0f)*(qz*vx - qx*vz)};
+        const V tz{V(2.0f)*(qx*vy - qy*vx)};
+        const V rx{vx + qw*tx + (qy*tz - qz*ty)};
+        const V ry{vy + qw*ty + (qz*tx - qx*tz)};
+        const V rz{vz + qw*tz + (qx*ty - qy*tx)};
+        vx = rx;
+        vy = ry;
+        vz = rz;
+    }
+
+    //acos on [0,1], Abramowitz & Stegun 4.4.46, |error| <= 2e-8
+    template<typename V>
+    inline V acosUnit(V c)
+    {
+        V p{V(-0.0012624911f)};
+        p = p*c + V(0.0066700901f);
+        p = p*c + V(-0.0170881256f);
+        p = p*c + V(0.0308918810f);
+        p = p*c + V(-0.0501743046f);
+        p = p*c + V(0.0889789874f);
+        p = p*c + V(-0.2145988016f);
+        p = p*c + V(1.5707963050f);
+        return sqrt(V(1.0f)-c)*p;
+    }
+
+    //sin on [-pi/2, pi/2], Taylor series up to x^11
+    template<typename V>
+    inline V sinHalfPi(V a)
+    {
+        const V a2{a*a};
+        V p{V(-2.5052108e-8f)};
+        p = p*a2 + V(2.7557319e-6f);
+        p = p*a2 + V(-1.9841270e-4f);
+        p = p*a2 + V(8.3333333e-3f);
+        p = p*a2 + V(-1.6666667e-1f);
+        return a + a*a2*p;
+    }
+
+    //shortest path slerp for unit quaternions and t in [0,1], like glm::slerp;
+    //nearly parallel inputs fall back to a normalized lerp
+    template<typename V>
+    inline void quatSlerp(V aw, V ax, V ay, V az, V bw, V bx, V by, V bz, V t,
+                        V& w, V& x, V& y, V& z)
+    {
+        V c{aw*bw + ax*bx + ay*by + az*bz};
+        const auto flip{greater(V(0.0f), c)};
+        const V sign{select(flip, V(-1.0f), V(1.0f))};
+        c = c*sign;
+        bw = bw*sign; bx = bx*sign; by = by*sign; bz = bz*sign;
+
+        const auto use_slerp{greater(V(0.9995f), c)};
+        const V theta{acosUnit(select(use_slerp, c, V(0.0f)))};
+        const V recipSin{V(1.0f)/sinHalfPi(select(use_slerp, theta, V(1.0f)))};
+        const V ka{select(use_slerp, sinHalfPi((V(1.0f)-t)*theta)*recipSin, V(1.0f)-t)};
+        const V kb{select(use_slerp, sinHalfPi(t*theta)*recipSin, t)};
+        w = ka*aw + kb*bw;
+        x = ka*ax + kb*bx;
+        y = ka*ay + kb*by;
+        z = ka*az + kb*bz;
+        //only the lerp lanes drift off unit length, slerp lanes are unchanged by this
+        const V norm{sqrt(w*w + x*x + y*y + z*z)};
+        const V scale{select(use_slerp, V(1.0f), V(1.0f)/norm)};
+        w = w*scale; x = x*scale; y = y*scale; z = z*scale;
+    }
+
+    //array versions, out may alias an input
+    template<typename V>
+    void quatMultiplyBatch(const QuatSoA& a, const QuatSoA& b, const QuatSoA& out, size_t n)
+    {
+        forLanes<V>(n, [&]<typename W>(size_t i){
+            W w, x, y, z;
+            quatMultiply(W::load(a.w+i), W::load(a.x+i), W::load(a.y+i), W::load(a.z+i),
+                        W::load(b.w+i), W::load(b.x+i), W::load(b.y+i), W::load(b.z+i),
+                        w, x, y, z);
+            w.store(out.w+i); x.store(out.x+i); y.store(out.y+i); z.store(out.z+i);
+        });
+    }
+
+    template<typename V>
+    void quatNormalizeBatch(const QuatSoA& q, size_t n)
+    {
+        forLanes<V>(n, [&]<typename W>(size_t i){
+            W w{W::load(q.w+i)}, x{W::load(q.x+i)}, y{W::load(q.y+i)}, z{W::load(q.z+i)};
+            quatNormalize(w, x, y, z);
+            w.store(q.w+i); x.store(q.x+i); y.store(q.y+i); z.store(q.z+i);
+        });
+    }
+
+    template<typename V>
+    void rotateVectorBatch(const QuatSoA& q, const Vec3SoA& v, const Vec3SoA& out, size_t n)
+    {
+        forLanes<V>(n, [&]<typename W>(size_t i){
+            W x{W::load(v.x+i)}, y{W::load(v.y+i)}, z{W::load(v.z+i)};
+            rotateVector(W::load(q.w+i), W::load(q.x+i), W::load(q.y+i), W::load(q.z+i), x, y, z);
+            x.store(out.x+i); y.store(out.y+i); z.store(out.z+i);
+        });
+    }
+
+    template<typename V>
+    void quatSlerpBatch(const QuatSoA& a, const QuatSoA& b, const float* t, const QuatSoA& out, size_t n)
+    {
+        forLanes<V>(n, [&]<typename W>(size_t i){
+            W w, x, y, z;
+            quatSlerp(W::load(a.w+i), W::load(a.x+i), W::load(a.y+i), W::load(a.z+i),
+                    W::load(b.w+i), W::load(b.x+i), W::load(b.y+i), W::load(b.z+i),
+                    W::load(t+i), w, x, y, z);
+            w.store(out.w+i); x.store(out.x+i); y.store(out.y+i); z.store(out.z+i);
+        });
+    }
+}
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "sample.hpp"
+#include "series_store.hpp"
+#include "tiers.hpp"
+#include "ahrs.hpp"
+
+//Sparse time index of one series file, kept next to it as "<file>.idx".
+//One entry per segment with its offset, time range and per channel min, max and
+//sum of the gyro rates, plus the same summary per whole second of the segment
+//(rollups). Opening the file reads the index instead of touching every segment;
+//segments appended since are decoded once, summarized and added. Entries
+//are kept sorted by start time together with the running maximum of the end times,
+//so the first segment reaching into a range is found in O(log n) even if the file
+//spans several recording runs with overlapping clocks.
+class IndexedSeries{
+    public:
+        static constexpr uint32_t INDEX_MAGIC{0x58495347};     //"GSIX"
+        static constexpr uint32_t INDEX_VERSION{1};
+        //seconds covered by one rollup, rollups start at whole multiples of it
+        static constexpr double ROLLUP{1.0};
+
+        struct Summary{
+            glm::vec3 min;
+            glm::vec3 max;
+            double sum[3];
+            uint32_t count;
+        };
+        struct Entry{
+            uint64_t offset;
+            double t_min;
+            double t_max;
+            uint8_t axes;
+            uint8_t reserved[3];
+            uint32_t rollup_count;
+            uint64_t rollup_first;  //into rollup()
+            Summary summary;
+        };
+        struct Rollup{
+            double start;
+            Summary summary;
+        };
+
+        //false if the series file cannot be read; an unreadable or stale index is rebuilt
+        bool open(const std::string& _path);
+        const std::string& topic() const {return reader.topic();}
+        const std::string& path() const {return file_path;}
+        double begin() const;
+        double end() const;
+        uint64_t sampleCount() const {return samples;}
+        size_t segmentCount() const {return entries.size();}
+        //indices into entry() of the segments overlapping [_from, _to], in start order
+        void overlapping(double _from, double _to, std::vector<uint32_t>& _out) const;
+        const Entry& entry(uint32_t _index) const {return entries[_index];}
+        const Rollup& rollup(uint64_t _index) const {return rollups[_index];}
+        //decompresses one segment
+        size_t decode(uint32_t _index, std::vector<Sample>& _out) const;
+        //decompresses one segment into column buffers, see SeriesReader::decodeColumns
+        size_t decodeColumns(uint32_t _index, const SeriesReader::Columns& _out) const;
+
+    private:
+        bool load(size_t& _indexed_bytes);
+        void save(size_t _indexed_bytes) const;
+        void sort();
+
+        std::string file_path;
+        SeriesReader reader;
+        std::vector<Entry> entries;
+        std::vector<Rollup> rollups;    //grouped by segment, see Entry
+        std::vector<uint32_t> order;    //entries sorted by t_min
+        std::vector<double> reach;      //running maximum of t_max along order
+        uint64_t samples{0};
+};
+
+
+//Time range queries over a directory of series files, one per topic.
+//Raw queries decode the segments overlapping the range and return the samples
+//inside it. Resolution queries return one Bucket per interval of the requested
+//width, intervals start at whole multiples of it like the tiers of a TierStore.
+//Segments inside the range are answered from the index without decoding: from
+//the segment summary if it lies within one interval, else from its rollups if the
+//resolution is a whole number of seconds. Only the segments at the ends of the
+//range, or all of them below 1 s resolution, are decompressed. Orientation queries replay the Madgwick filter over
+//the samples from _warmup seconds before the range, because the orientation at a
+//point depends on the motion before it. Gyro only (3 axis) samples have no gravity
+//or heading reference: integrated from identity at the start of the warmup, their
+//orientation is relative to that point and drifts without bound, so such ranges are
+//refused unless _gyro_only is set.
+class SeriesQuery{
+    public:
+        struct Stats{
+            uint64_t decoded;       //segments decompressed
+            uint64_t summarized;    //segments answered from the index summary
+            uint64_t rolled;        //segments answered from their rollups
+        };
+        struct Orientation{
+            double t;
+            glm::quat q;
+        };
+
+        explicit SeriesQuery(const std::string& _directory);
+
+        //indexes every series file of the directory, false if it cannot be listed
+        bool open();
+        std::vector<std::string> topics() const;
+        //nullptr if no file records _topic
+        const IndexedSeries* find(const std::string& _topic) const;
+
+        size_t samples(const std::string& _topic, double _from, double _to, std::vector<Sample>& _out);
+        size_t buckets(const std::string& _topic, double _from, double _to, double _resolution,
+                    std::vector<Bucket>& _out);
+        //orientation at every sample, or at the last sample of every interval with _resolution>0;
+        //0 if the range holds gyro only segments and _gyro_only is not set
+        size_t orientations(const std::string& _topic, double _from, double _to, double _resolution,
+                    std::vector<Orientation>& _out, double _warmup = 5.0, float _beta = ahrs::DEFAULT_BETA,
+                    bool _gyro_only = false);
+        //true if a segment of _topic overlapping [_from, _to] has gyro rates only
+        bool gyroOnly(const std::string& _topic, double _from, double _to);
+        Stats getStats() const {return stats;}
+
+    private:
+        std::string directory;
+        std::map<std::string, std::unique_ptr<IndexedSeries>> series;
+        std::vector<uint32_t> hits;
+        std::vector<Sample> scratch;
+        Stats stats;
+};
+
+#endif
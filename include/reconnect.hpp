@@ -0,0 +1,117 @@
+#ifndef RECONNECT_H
+#define RECONNECT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mqtt/async_client.h"
+
+//Keeps the subscription alive across one or more redundant brokers.
+//All brokers are connected at start and the one answering fastest gets the
+//subscriptions. The others stay connected without any as warm standbys. A worker
+//thread measures the round trip to every broker each PROBE_INTERVAL (an UNSUBSCRIBE
+//of a filter nobody uses, Paho has no way to send a PINGREQ on demand). When the
+//active broker drops the connection or misses MAX_MISSES probes, the fastest standby
+//is subscribed and takes over: one SUBSCRIBE round trip instead of a reconnect.
+//Only a dropped connection, reported by the callbacks, fails over that fast. A broker
+//that keeps its TCP session but stops answering is noticed after MAX_MISSES probes,
+//MAX_MISSES*PROBE_TIMEOUT to MAX_MISSES*(PROBE_INTERVAL+PROBE_TIMEOUT) plus a timeout
+//for every other unresponsive broker probed in between: 200-600 ms with the values
+//below, well above 100 ms. The timeout cannot go much lower without taking brokers
+//with a longer round trip for degraded ones.
+//Without a standby, the brokers are retried with an exponential backoff starting at
+//MIN_BACKOFF. The active session is persistent (clean start off, MQTT v5 session
+//expiry), so a broker that comes back keeps the subscriptions and queued QoS 1/2
+//messages, and topics are only subscribed again if the session was lost.
+class ReconnectManager{
+    public:
+        static constexpr std::chrono::milliseconds MIN_BACKOFF{50};
+        static constexpr std::chrono::milliseconds MAX_BACKOFF{5000};
+        static constexpr std::chrono::milliseconds PROBE_INTERVAL{200};
+        static constexpr std::chrono::milliseconds PROBE_TIMEOUT{100};
+        static constexpr std::chrono::milliseconds CONNECT_TIMEOUT{2000};
+        static constexpr uint32_t MAX_MISSES{2};
+
+        using MessageHandler = std::function<void(mqtt::const_message_ptr)>;
+
+        struct Stats{
+            uint64_t reconnects;
+            uint64_t resumed;       //reconnects that found the session on the broker
+            uint64_t failovers;     //reconnects that switched to a standby broker
+            double last;            //seconds from losing the connection to being subscribed again
+            double max;
+            double total;
+        };
+
+        ReconnectManager(const std::vector<std::string>& _servers,
+                        const std::string& _client_id,
+                        uint32_t _session_expiry);
+        ~ReconnectManager();
+        ReconnectManager(const ReconnectManager&) = delete;
+        ReconnectManager& operator=(const ReconnectManager&) = delete;
+
+        //topics subscribed on connect and after a lost session
+        void addTopic(const std::string& _topic, int _qos);
+        //installed on every broker connection, must be set before connect()
+        void setMessageCallback(MessageHandler _handler);
+        //first connection, blocking, then starts watching the connections
+        bool connect();
+        //stops watching and disconnects from every broker
+        void stop();
+        //publishes on the active broker, throws mqtt::exception like async_client::publish
+        mqtt::delivery_token_ptr publish(mqtt::message_ptr _msg);
+        Stats getStats() const;
+
+    private:
+        struct Link{
+            std::string uri;
+            std::unique_ptr<mqtt::async_client> cli;
+            bool up;
+            mqtt::token_ptr pending;        //standby connect in flight
+            double rtt;                     //smoothed round trip in seconds, negative until measured
+            uint32_t misses;
+            std::chrono::steady_clock::time_point missed_at;   //first probe of the current run of misses
+            std::chrono::milliseconds backoff;
+            std::chrono::steady_clock::time_point retry_at;
+        };
+
+        //connects every broker at once, true if at least one answered
+        bool connectAll();
+        //connects once and subscribes if the session is gone, true on success
+        bool attempt(Link& _link, bool& _resumed);
+        bool subscribe(Link& _link);
+        //one round trip in seconds, negative if it timed out
+        double probe(Link& _link);
+        //moves the subscriptions to the fastest standby, false if there is none
+        bool failover(size_t _from);
+        //reconnects with backoff when no standby is left, false when stopping
+        bool recover();
+        void maintain();
+        void down(size_t _index, const std::string& _cause);
+        void record(double _duration, bool _resumed, bool _switched);
+        void loop();
+
+        std::vector<Link> links;
+        mqtt::connect_options options;          //the active broker, resumes its session
+        mqtt::connect_options standby_options;  //standbys start without subscriptions
+        std::vector<std::string> topics;
+        mqtt::qos_collection qos;
+        const std::string probe_filter;
+
+        mutable std::mutex mx;
+        std::condition_variable cv;
+        size_t active;
+        bool lost;
+        bool stopping;
+        std::chrono::steady_clock::time_point lost_at;
+        Stats stats;
+        std::thread worker;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <cstdint>
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+//one decoded sensor reading as it travels from the MQTT listener to the renderer
+struct Sample{
+    uint32_t sensor;    //index assigned by MQTTListener per topic
+    double timestamp;   //seconds, sensor clock if the payload is stamped, else Unix time of arrival
+    glm::vec3 value;    //gyro rates in deg/s
+    glm::vec3 accel;    //valid if axes>=6, any unit
+    glm::vec3 mag;      //valid if axes==9, any unit
+    uint8_t axes;       //3: gyro only, 6: gyro+accel, 9: gyro+accel+mag
+    double arrival;     //steady clock seconds when the message was received
+    glm::quat orientation;  //fused orientation after this sample
+};
+
+inline double steadySeconds()
+{
+    return std::chrono::duration<double>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Unix time, for timestamps that have to mean something outside this process
+inline double wallSeconds()
+{
+    return std::chrono::duration<double>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+#endif
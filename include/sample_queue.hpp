@@ -0,0 +1,73 @@
+#ifndef SAMPLE_QUEUE_H
+#define SAMPLE_QUEUE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "sample.hpp"
+
+//what a stream does with a new sample while the consumer is behind
+enum class OverloadPolicy : uint8_t{
+    DROP_OLDEST,    //a full ring overwrites its oldest sample
+    DROP_NEWEST,    //a full ring rejects the new sample, keeps the oldest data
+    COALESCE,       //only the latest sample is kept until the consumer takes it
+    DOWNSAMPLE      //above half capacity only every Nth sample is kept, a full ring drops oldest
+};
+
+//accepts drop_oldest, drop_newest, coalesce and downsample
+bool parsePolicy(std::string_view _name, OverloadPolicy& _policy);
+const char* policyName(OverloadPolicy _policy);
+
+//hands samples over from the listener thread to the render loop.
+//every sensor gets its own ring, which grows with the backlog up to a fixed capacity,
+//so memory stays flat however far the consumer falls behind and a sensor the consumer
+//keeps up with holds only a few slots. both sides touch the mutex once per message /
+//once per frame.
+class SampleQueue{
+    public:
+        struct Stats{
+            uint64_t accepted;  //samples drained or still waiting, accepted+dropped were pushed
+            uint64_t dropped;   //samples discarded or replaced by the policy
+            uint32_t depth;     //samples waiting right now
+            uint32_t max_depth;
+        };
+
+        static constexpr size_t DEFAULT_CAPACITY{4096};
+        //slots of a ring when it first has to grow
+        static constexpr size_t INITIAL_RING{16};
+
+        explicit SampleQueue(size_t _capacity = DEFAULT_CAPACITY,
+                            OverloadPolicy _policy = OverloadPolicy::DROP_OLDEST,
+                            uint32_t _downsample = 4);
+
+        void push(const Sample& _sample);
+        //moves all pending samples into _out (cleared first), oldest first per sensor, returns their count
+        size_t drain(std::vector<Sample>& _out);
+        //overrides the default policy for one sensor
+        void setPolicy(uint32_t _sensor, OverloadPolicy _policy);
+        //copies the counters of every sensor into _out, indexed by sensor
+        void stats(std::vector<Stats>& _out) const;
+        size_t getCapacity() const {return capacity;}
+
+    private:
+        struct Stream{
+            std::vector<Sample> ring;   //grows up to capacity
+            size_t head;    //slot of the oldest pending sample
+            size_t count;
+            OverloadPolicy policy;
+            uint32_t skipped;   //samples seen since the last one DOWNSAMPLE kept
+            Stats stats;
+        };
+
+        Stream& stream(uint32_t _sensor);
+        void insert(Stream& _stream, const Sample& _sample);
+
+        mutable std::mutex mx;
+        size_t capacity;
+        OverloadPolicy policy;
+        uint32_t downsample;
+        std::vector<Stream> streams;
+};
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include "sample.hpp"
+
+//Per sensor sequence tracking.
+//Samples carry a publisher side counter. The tracker releases them in counter order,
+//holds up to WINDOW samples that arrived ahead of a missing one and gives the gap up
+//as lost once the window is full or the oldest held sample waited MAX_HOLD seconds.
+//Redelivered and too late samples are dropped. Storage is a fixed array indexed by
+//sequence number, so every sample costs O(1) and nothing is allocated.
+//A restarted publisher is recognized by a new epoch (a number it picks at startup)
+//or, for publishers without one, by a counter jump of RESTART_DISTANCE or more, or
+//by WINDOW consecutive numbers behind the tracker that were never released. A restart
+//onto numbers already released looks like a redelivery, only the epoch catches it.
+class SequenceTracker{
+    public:
+        //samples held back behind a gap, a power of two up to 64 (one bit each in the mask)
+        static constexpr uint32_t WINDOW{32};
+        //seconds a gap may hold samples back before it is counted as lost
+        static constexpr double MAX_HOLD{0.05};
+        //a jump this far in either direction is taken as a restarted publisher
+        static constexpr uint32_t RESTART_DISTANCE{1024};
+
+        struct Stats{
+            uint64_t received;      //samples with a sequence number
+            uint64_t released;      //samples handed on in order
+            uint64_t lost;          //sequence numbers skipped over
+            uint64_t duplicates;    //sequence numbers seen twice, e.g. QoS 1 redelivery
+            uint64_t late;          //arrived after their gap was given up
+            uint64_t reordered;     //released from the window after a gap closed
+            uint64_t restarts;      //publisher counter jumped, tracking started over
+        };
+
+        SequenceTracker():started{false},
+                        epoch{0},
+                        next{0},
+                        held{0},
+                        released{},
+                        hold_start{0.0},
+                        stale_next{0},
+                        stale_run{0},
+                        stats{}
+        {
+        }
+
+        //_emit(const Sample&) is called for every sample that becomes releasable, in order;
+        //_epoch is 0 for publishers that do not send one
+        template<typename Emit>
+        void accept(uint32_t _seq, uint32_t _epoch, const Sample& _sample, Emit&& _emit)
+        {
+            ++stats.received;
+            expire(_sample.arrival, _emit);
+            if(!started)
+            {
+                started = true;
+                epoch = _epoch;
+                next = _seq;
+            }
+            if(_epoch!=epoch)
+            {
+                restart(_seq, _emit);
+                epoch = _epoch;
+            }
+
+            const int32_t ahead{static_cast<int32_t>(_seq-next)};
+            if(ahead<0 && static_cast<uint32_t>(-static_cast<int64_t>(ahead))<=RESTART_DISTANCE)
+            {
+                //the release history tells redelivered numbers from ones skipped over
+                if(released.test(_seq%RESTART_DISTANCE))
+                {
+                    ++stats.duplicates;
+                    stale_run = 0;
+                    return;
+                }
+                //a run of numbers never released is a publisher that started over close to the old counter
+                stale_run = _seq==stale_next ? stale_run+1 : 1;
+                stale_next = _seq+1;
+                if(stale_run<WINDOW)
+                {
+                    ++stats.late;
+                    return;
+                }
+                restart(_seq, _emit);
+            }
+            else if(ahead<0 || ahead>=static_cast<int32_t>(RESTART_DISTANCE))
+            {
+                restart(_seq, _emit);
+            }
+            else if(ahead>=static_cast<int32_t>(WINDOW))
+            {
+                skipTo(_seq-WINDOW+1, _emit);
+            }
+
+            if(_seq==next)
+            {
+                release(_sample, _emit);
+                drain(_emit);
+                return;
+            }
+            const uint64_t bit{1ull<<(_seq%WINDOW)};
+            if(held&bit)
+            {
+                ++stats.duplicates;
+                return;
+            }
+            if(!held) hold_start = _sample.arrival;
+            slots[_seq%WINDOW] = _sample;
+            held |= bit;
+        }
+
+        //gives up the oldest gap if samples have been waiting behind it for too long
+        template<typename Emit>
+        void expire(double _now, Emit&& _emit)
+        {
+            if(!held || _now-hold_start<MAX_HOLD) return;
+            while(!(held&(1ull<<(next%WINDOW)))) skip();
+            drain(_emit);
+            hold_start = _now;
+        }
+
+        const Stats& getStats() const {return stats;}
+        //number of samples waiting for a gap to close
+        uint32_t pending() const {return static_cast<uint32_t>(__builtin_popcountll(held));}
+
+    private:
+        //releases what is held and starts over at _seq
+        template<typename Emit>
+        void restart(uint32_t _seq, Emit&& _emit)
+        {
+            flush(_emit);
+            ++stats.restarts;
+            next = _seq;
+            released.reset();
+            stale_run = 0;
+        }
+
+        template<typename Emit>
+        void release(const Sample& _sample, Emit&& _emit)
+        {
+            _emit(_sample);
+            ++stats.released;
+            released.set(next%RESTART_DISTANCE);
+            ++next;
+            stale_run = 0;
+        }
+
+        //counts the next number as lost
+        void skip()
+        {
+            ++stats.lost;
+            released.reset(next%RESTART_DISTANCE);
+            ++next;
+        }
+
+        //releases held samples for as long as they are consecutive
+        template<typename Emit>
+        void drain(Emit&& _emit)
+        {
+            uint64_t bit{1ull<<(next%WINDOW)};
+            while(held&bit)
+            {
+                held &= ~bit;
+                ++stats.reordered;
+                release(slots[next%WINDOW], _emit);
+                bit = 1ull<<(next%WINDOW);
+            }
+        }
+
+        //releases everything held, counting the gaps in between as lost
+        template<typename Emit>
+        void flush(Emit&& _emit)
+        {
+            while(held)
+            {
+                if(held&(1ull<<(next%WINDOW))) drain(_emit);
+                else skip();
+            }
+        }
+
+        //moves next forward to _target, releasing what is held on the way and counting the rest as lost
+        template<typename Emit>
+        void skipTo(uint32_t _target, Emit&& _emit)
+        {
+            while(held && static_cast<int32_t>(_target-next)>0)
+            {
+                if(held&(1ull<<(next%WINDOW))) drain(_emit);
+                else skip();
+            }
+            const int32_t gap{static_cast<int32_t>(_target-next)};
+            if(gap<=0) return;
+            stats.lost += static_cast<uint32_t>(gap);
+            if(gap>=static_cast<int32_t>(RESTART_DISTANCE)) released.reset();
+            else for(uint32_t n=next; n!=_target; ++n) released.reset(n%RESTART_DISTANCE);
+            next = _target;
+        }
+
+        bool started;
+        uint32_t epoch;         //of the publisher counting right now
+        uint32_t next;          //sequence number released next
+        uint64_t held;          //bit (seq%WINDOW) set if that slot holds a sample
+        //bit seq%RESTART_DISTANCE set if that number was released, for the numbers up to RESTART_DISTANCE behind next
+        std::bitset<RESTART_DISTANCE> released;
+        double hold_start;      //arrival time since which the current gap holds samples
+        uint32_t stale_next;    //number following the last one dropped as late
+        uint32_t stale_run;     //consecutive numbers dropped as late
+        std::array<Sample, WINDOW> slots;
+        Stats stats;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef SERIES_STORE_H
+#define SERIES_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sample.hpp"
+
+//Columnar, compressed sample history of one sensor on disk.
+//A file is a FileHeader with the sensor topic followed by segments, appended one
+//after the other and never rewritten. A segment holds up to SEGMENT_SAMPLES
+//samples of the same axis layout as one bit stream per column:
+//  timestamps - microseconds, the first one raw, then the delta of the delta in a
+//               variable length code, 1 bit for a regular sample rate
+//  channels   - gyro x, y, z (plus accel and mag if present) as float32, each XORed
+//               with its predecessor and stored as the meaningful bits only (Gorilla)
+//The footer closes a segment with its time range and column sizes, so a reader
+//finds the segments of a time range without decoding the others. A segment cut
+//short by a crash is ignored. Timestamps are rounded to 1 us, values are exact.
+namespace series{
+    constexpr uint32_t FILE_MAGIC{0x53545347};      //"GSTS"
+    constexpr uint32_t SEGMENT_MAGIC{0x47455347};   //"GSEG"
+    constexpr uint32_t FOOTER_MAGIC{0x46455347};    //"GSEF"
+    constexpr uint16_t VERSION{1};
+    //timestamp plus three channels per sensor of a 9-axis sample
+    constexpr size_t MAX_COLUMNS{10};
+
+    struct FileHeader{
+        uint32_t magic;
+        uint16_t version;
+        uint16_t topic_length;  //topic bytes follow the header
+    };
+    struct SegmentHeader{
+        uint32_t magic;
+        uint32_t bytes;         //the whole segment, header and footer included
+    };
+    struct SegmentFooter{
+        double t_min;
+        double t_max;
+        uint32_t count;
+        uint8_t axes;
+        uint8_t columns;
+        uint16_t reserved;
+        uint32_t column_bytes[MAX_COLUMNS];
+        uint32_t magic;
+    };
+
+    //file name of _topic inside _directory, '/' and '%' are percent encoded
+    std::string fileName(const std::string& _directory, const std::string& _topic);
+}
+
+
+//Appends the samples of one sensor to its file, one segment at a time.
+//Samples are encoded into the open segment as they arrive; it is written with a
+//single write() once it holds SEGMENT_SAMPLES samples, spans SEGMENT_SECONDS, the
+//axis layout changes or flush() is called. flushIdle() writes it once its first sample
+//arrived SEGMENT_SECONDS ago, for sensors that stopped sending. An existing file of
+//the same topic is continued.
+class SeriesWriter{
+    public:
+        static constexpr uint32_t SEGMENT_SAMPLES{4096};
+        static constexpr double SEGMENT_SECONDS{10.0};
+
+        struct Stats{
+            uint64_t samples;
+            uint64_t segments;
+            uint64_t bytes;     //written by this writer
+        };
+
+        SeriesWriter(const std::string& _path, const std::string& _topic);
+        ~SeriesWriter();
+        SeriesWriter(const SeriesWriter&) = delete;
+        SeriesWriter& operator=(const SeriesWriter&) = delete;
+
+        //false if the file could not be opened, push() then does nothing
+        bool ok() const {return fd>=0;}
+        void push(const Sample& _sample);
+        //writes the open segment, returns false if the write failed
+        bool flush();
+        //flushes the open segment if its first sample arrived SEGMENT_SECONDS before _now (steadySeconds)
+        bool flushIdle(double _now);
+        Stats getStats() const {return stats;}
+
+    private:
+        //MSB first bit stream of one column
+        struct BitWriter{
+            std::vector<uint8_t> bytes;
+            uint64_t buffer{0};
+            uint32_t bits{0};
+            void write(uint64_t _value, uint32_t _count);
+            void finish();
+            void clear() {bytes.clear(); buffer = 0; bits = 0;}
+        };
+        //XOR state of one float channel
+        struct Channel{
+            uint32_t previous;
+            uint32_t leading;
+            uint32_t trailing;
+        };
+
+        void encodeTimestamp(int64_t _micros);
+        void encodeValue(size_t _column, float _value);
+
+        int fd;
+        std::string path;
+        std::vector<BitWriter> columns;
+        std::vector<Channel> channels;
+        //open segment
+        uint32_t count;
+        uint8_t axes;
+        double t_min;
+        double t_max;
+        double t_first;
+        double opened;  //arrival of the first sample
+        int64_t previous_micros;
+        int64_t previous_delta;
+        std::vector<uint8_t> segment;
+        Stats stats;
+};
+
+
+//Memory mapped read access to one series file.
+//open() maps the file and walks the segment headers to build the index of time
+//ranges from the footers; read() decodes only the segments overlapping the range.
+//map() and scan() split open() for callers keeping their own index, see SeriesQuery.
+class SeriesReader{
+    public:
+        struct Segment{
+            size_t offset;      //of the SegmentHeader
+            double t_min;
+            double t_max;
+            uint32_t count;
+            uint8_t axes;
+        };
+        //destinations of decodeColumns() with room for Segment::count values each,
+        //channels 0-2 gyro, 3-5 accel, 6-8 mag; null pointers and channels the segment
+        //does not have are skipped
+        struct Columns{
+            double* timestamp;
+            float* channel[series::MAX_COLUMNS-1];
+        };
+
+        SeriesReader();
+        ~SeriesReader();
+        SeriesReader(const SeriesReader&) = delete;
+        SeriesReader& operator=(const SeriesReader&) = delete;
+
+        bool open(const std::string& _path);
+        //maps the file and checks its header, no segment is indexed yet
+        bool map(const std::string& _path);
+        //indexes the complete segments from _offset on, returns the offset behind the last one
+        size_t scan(size_t _offset);
+        //offset of the first segment
+        size_t dataOffset() const {return data_offset;}
+        void close();
+        const std::string& topic() const {return topic_name;}
+        const std::vector<Segment>& segments() const {return index;}
+        uint64_t sampleCount() const;
+        size_t fileSize() const {return size;}
+        //appends every sample of _segment to _out with sensor id _sensor, returns their count
+        size_t decode(const Segment& _segment, std::vector<Sample>& _out, uint32_t _sensor = 0) const;
+        //decodes every sample of _segment column by column straight into _out, returns their count
+        size_t decodeColumns(const Segment& _segment, const Columns& _out) const;
+        //appends the samples in [_from, _to] in file order, returns their count
+        size_t read(double _from, double _to, std::vector<Sample>& _out, uint32_t _sensor = 0) const;
+
+    private:
+        const uint8_t* base;
+        size_t size;
+        size_t data_offset;
+        std::string path;
+        std::string topic_name;
+        std::vector<Segment> index;
+};
+
+
+//Streams every sensor of the ingest pipeline into its own series file.
+//Writers are opened with the first sample of a sensor, named after its topic.
+class SeriesRecorder{
+    public:
+        //topic of a sensor id, e.g. ShardedIngest::topic
+        using TopicLookup = std::function<std::string(uint32_t)>;
+
+        SeriesRecorder(const std::string& _directory, TopicLookup _topic);
+        ~SeriesRecorder();
+
+        void push(const Sample& _sample);
+        void flush();
+        //SeriesWriter::flushIdle() of every sensor, call it periodically
+        void flushIdle(double _now);
+        //summed over all sensors
+        SeriesWriter::Stats getStats() const;
+
+    private:
+        std::string directory;
+        TopicLookup topic;
+        //indexed by sensor id
+        std::vector<std::unique_ptr<SeriesWriter>> writers;
+};
+
+#endif
@@ -64,6 +64,8 @@ class FragmentShader : public BaseShader
         void setFloat(const uint& ID,const std::string& name,float value)  override;
 };
 
+//links a vertex and a fragment shader into a program object, exits on link errors
+uint linkProgram(const BaseShader& vertex_shader, const BaseShader& fragment_shader);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,164 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#if defined(__SSE4_2__) || defined(__AVX2__) || defined(__AVX512F__)
+    #include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+#endif
+
+//Thin value wrappers over one SIMD register with the handful of operations the
+//batched kernels need. A kernel is written once as a template over the wrapper
+//and instantiated in a translation unit compiled for the matching ISA; the
+//ISA specific wrappers only exist where the compiler targets that ISA.
+//Everything below Level lives in an unnamed namespace: each unit gets its own
+//copy compiled with its own flags, so the linker can never hand an AVX build of
+//a shared inline function to code running on a CPU without AVX.
+namespace simd{
+
+    enum Level : uint8_t{
+        SCALAR,
+        NEON,
+        SSE42,
+        AVX2,
+        AVX512
+    };
+
+    const char* levelName(Level _level);
+    //best level supported by both this build and the running CPU
+    Level detect();
+
+namespace{
+    //one lane, used as fallback and for the tails of the batches
+    struct Scalar{
+        static constexpr size_t WIDTH{1};
+        using Mask = bool;
+        float v;
+        Scalar() = default;
+        Scalar(float _v):v{_v}{}
+        static Scalar load(const float* _p) {return Scalar{*_p};}
+        void store(float* _p) const {*_p = v;}
+    };
+    inline Scalar operator+(Scalar a, Scalar b) {return a.v+b.v;}
+    inline Scalar operator-(Scalar a, Scalar b) {return a.v-b.v;}
+    inline Scalar operator*(Scalar a, Scalar b) {return a.v*b.v;}
+    inline Scalar operator/(Scalar a, Scalar b) {return a.v/b.v;}
+    inline Scalar operator-(Scalar a) {return -a.v;}
+    inline Scalar sqrt(Scalar a) {return std::sqrt(a.v);}
+    inline bool greater(Scalar a, Scalar b) {return a.v>b.v;}
+    inline Scalar select(bool m, Scalar a, Scalar b) {return m ? a : b;}
+
+#if defined(__SSE4_2__)
+    struct Sse{
+        static constexpr size_t WIDTH{4};
+        struct Mask{
+            __m128 m;
+        };
+        __m128 v;
+        Sse() = default;
+        Sse(__m128 _v):v{_v}{}
+        Sse(float _v):v{_mm_set1_ps(_v)}{}
+        static Sse load(const float* _p) {return _mm_loadu_ps(_p);}
+        void store(float* _p) const {_mm_storeu_ps(_p, v);}
+    };
+    inline Sse operator+(Sse a, Sse b) {return _mm_add_ps(a.v, b.v);}
+    inline Sse operator-(Sse a, Sse b) {return _mm_sub_ps(a.v, b.v);}
+    inline Sse operator*(Sse a, Sse b) {return _mm_mul_ps(a.v, b.v);}
+    inline Sse operator/(Sse a, Sse b) {return _mm_div_ps(a.v, b.v);}
+    inline Sse operator-(Sse a) {return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f));}
+    inline Sse sqrt(Sse a) {return _mm_sqrt_ps(a.v);}
+    inline Sse::Mask greater(Sse a, Sse b) {return {_mm_cmpgt_ps(a.v, b.v)};}
+    inline Sse::Mask operator&(Sse::Mask a, Sse::Mask b) {return {_mm_and_ps(a.m, b.m)};}
+    inline Sse select(Sse::Mask m, Sse a, Sse b) {return _mm_blendv_ps(b.v, a.v, m.m);}
+#endif
+
+#if defined(__AVX2__)
+    struct Avx2{
+        static constexpr size_t WIDTH{8};
+        struct Mask{
+            __m256 m;
+        };
+        __m256 v;
+        Avx2() = default;
+        Avx2(__m256 _v):v{_v}{}
+        Avx2(float _v):v{_mm256_set1_ps(_v)}{}
+        static Avx2 load(const float* _p) {return _mm256_loadu_ps(_p);}
+        void store(float* _p) const {_mm256_storeu_ps(_p, v);}
+    };
+    inline Avx2 operator+(Avx2 a, Avx2 b) {return _mm256_add_ps(a.v, b.v);}
+    inline Avx2 operator-(Avx2 a, Avx2 b) {return _mm256_sub_ps(a.v, b.v);}
+    inline Avx2 operator*(Avx2 a, Avx2 b) {return _mm256_mul_ps(a.v, b.v);}
+    inline Avx2 operator/(Avx2 a, Avx2 b) {return _mm256_div_ps(a.v, b.v);}
+    inline Avx2 operator-(Avx2 a) {return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f));}
+    inline Avx2 sqrt(Avx2 a) {return _mm256_sqrt_ps(a.v);}
+    inline Avx2::Mask greater(Avx2 a, Avx2 b) {return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)};}
+    inline Avx2::Mask operator&(Avx2::Mask a, Avx2::Mask b) {return {_mm256_and_ps(a.m, b.m)};}
+    inline Avx2 select(Avx2::Mask m, Avx2 a, Avx2 b) {return _mm256_blendv_ps(b.v, a.v, m.m);}
+#endif
+
+#if defined(__AVX512F__)
+    struct Avx512{
+        static constexpr size_t WIDTH{16};
+        struct Mask{
+            __mmask16 m;
+        };
+        __m512 v;
+        Avx512() = default;
+        Avx512(__m512 _v):v{_v}{}
+        Avx512(float _v):v{_mm512_set1_ps(_v)}{}
+        static Avx512 load(const float* _p) {return _mm512_loadu_ps(_p);}
+        void store(float* _p) const {_mm512_storeu_ps(_p, v);}
+    };
+    inline Avx512 operator+(Avx512 a, Avx512 b) {return _mm512_add_ps(a.v, b.v);}
+    inline Avx512 operator-(Avx512 a, Avx512 b) {return _mm512_sub_ps(a.v, b.v);}
+    inline Avx512 operator*(Avx512 a, Avx512 b) {return _mm512_mul_ps(a.v, b.v);}
+    inline Avx512 operator/(Avx512 a, Avx512 b) {return _mm512_div_ps(a.v, b.v);}
+    //xor on floats needs AVX512DQ, subtracting from zero only needs F
+    inline Avx512 operator-(Avx512 a) {return _mm512_sub_ps(_mm512_setzero_ps(), a.v);}
+    inline Avx512 sqrt(Avx512 a) {return _mm512_sqrt_ps(a.v);}
+    inline Avx512::Mask greater(Avx512 a, Avx512 b) {return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)};}
+    inline Avx512::Mask operator&(Avx512::Mask a, Avx512::Mask b) {return {static_cast<__mmask16>(a.m & b.m)};}
+    inline Avx512 select(Avx512::Mask m, Avx512 a, Avx512 b) {return _mm512_mask_blend_ps(m.m, b.v, a.v);}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    struct Neon{
+        static constexpr size_t WIDTH{4};
+        struct Mask{
+            uint32x4_t m;
+        };
+        float32x4_t v;
+        Neon() = default;
+        Neon(float32x4_t _v):v{_v}{}
+        Neon(float _v):v{vdupq_n_f32(_v)}{}
+        static Neon load(const float* _p) {return vld1q_f32(_p);}
+        void store(float* _p) const {vst1q_f32(_p, v);}
+    };
+    inline Neon operator+(Neon a, Neon b) {return vaddq_f32(a.v, b.v);}
+    inline Neon operator-(Neon a, Neon b) {return vsubq_f32(a.v, b.v);}
+    inline Neon operator*(Neon a, Neon b) {return vmulq_f32(a.v, b.v);}
+    inline Neon operator/(Neon a, Neon b) {return vdivq_f32(a.v, b.v);}
+    inline Neon operator-(Neon a) {return vnegq_f32(a.v);}
+    inline Neon sqrt(Neon a) {return vsqrtq_f32(a.v);}
+    inline Neon::Mask greater(Neon a, Neon b) {return {vcgtq_f32(a.v, b.v)};}
+    inline Neon::Mask operator&(Neon::Mask a, Neon::Mask b) {return {vandq_u32(a.m, b.m)};}
+    inline Neon select(Neon::Mask m, Neon a, Neon b) {return vbslq_f32(m.m, a.v, b.v);}
+#endif
+
+    //runs op.template operator()<W>(i) over [0, _count), V::WIDTH lanes at a time
+    //and the remaining tail one lane at a time
+    template<typename V, typename Op>
+    inline void forLanes(size_t _count, Op&& op)
+    {
+        size_t i{0};
+        for(; i+V::WIDTH<=_count; i+=V::WIDTH) op.template operator()<V>(i);
+        for(; i<_count; ++i) op.template operator()<Scalar>(i);
+    }
+}
+}
+
+#endif
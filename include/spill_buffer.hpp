@@ -0,0 +1,82 @@
+#ifndef SPILL_BUFFER_H
+#define SPILL_BUFFER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+//Byte ring between the MQTT transport and the ingest pipeline.
+//The transport callback appends every message as one record, the pipeline thread
+//reads them back in order. The ring lives in a memory mapped file of fixed size,
+//so a burst the pipeline cannot keep up with (e.g. the backlog a resumed session
+//delivers after a reconnect) is absorbed by pages the kernel can write back to
+//disk, and memory never grows past the configured capacity. A full ring rejects
+//new records and counts them. One producer and one consumer thread, no locks on
+//the data path.
+class SpillBuffer{
+    public:
+        struct Record{
+            std::string_view topic;
+            std::string_view payload;
+            uint32_t seq;
+            uint32_t epoch;     //of the publisher, 0 if it sends none
+            bool has_seq;
+            double arrival;     //steady clock seconds when the transport received it
+        };
+
+        struct Stats{
+            uint64_t records;       //appended
+            uint64_t rejected;      //dropped because the ring was full
+            uint64_t used;          //bytes waiting right now
+            uint64_t peak;          //most bytes ever waiting
+        };
+
+        //maps _capacity bytes of a new file created (and unlinked) in _directory
+        SpillBuffer(size_t _capacity, const std::string& _directory);
+        ~SpillBuffer();
+        SpillBuffer(const SpillBuffer&) = delete;
+        SpillBuffer& operator=(const SpillBuffer&) = delete;
+
+        //producer side, false if the record does not fit
+        bool push(std::string_view _topic, std::string_view _payload,
+                const uint32_t* _seq, uint32_t _epoch, double _arrival);
+        //consumer side: the oldest record stays valid until pop()
+        bool front(Record& _record);
+        void pop();
+        //waits up to _timeout for a record to arrive
+        bool wait(std::chrono::milliseconds _timeout);
+
+        Stats getStats() const;
+        size_t capacity() const {return size;}
+
+    private:
+        struct Header{
+            uint32_t length;        //whole record incl. header and padding, WRAP to skip the tail
+            uint32_t topic_size;
+            uint32_t payload_size;
+            uint32_t seq;
+            double arrival;
+            uint32_t has_seq;
+            uint32_t epoch;
+        };
+        static constexpr uint32_t WRAP{0xFFFFFFFFu};
+        static constexpr size_t ALIGN{alignof(Header)};
+
+        std::byte* base;
+        size_t size;
+        //monotonic byte positions, the slot is position%size
+        alignas(64) std::atomic<uint64_t> head;     //written by the consumer
+        alignas(64) std::atomic<uint64_t> tail;     //written by the producer
+        std::atomic<uint64_t> records;
+        std::atomic<uint64_t> rejected;
+        std::atomic<uint64_t> peak;
+        std::mutex mx;
+        std::condition_variable cv;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+extern "C"{
+    #include <glad/glad.h>
+}
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gl{
+    //Persistently mapped buffer object used for per-frame vertex streaming.
+    //The storage is allocated once with glBufferStorage and split into REGIONS
+    //equally sized regions. The CPU writes into one region while the GPU may still
+    //read the other ones, and every region is guarded by a fence, so neither side
+    //waits on implicit driver synchronization and nothing is ever reallocated.
+    class StreamBuffer{
+        public:
+            static constexpr uint REGIONS{3};
+
+            StreamBuffer(GLenum target_, GLsizeiptr region_size_);
+            ~StreamBuffer();
+            StreamBuffer(const StreamBuffer&) = delete;
+            StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+            //waits until the GPU released the current region and returns its mapped address
+            void* begin();
+            //fences the current region after the draw calls reading it and moves to the next one
+            void end();
+
+            uint get() const {return buffer;}
+            GLenum getTarget() const {return target;}
+            GLsizeiptr regionSize() const {return region_size;}
+            //byte offset of the current region inside the buffer object
+            GLintptr offset() const {return static_cast<GLintptr>(region)*region_size;}
+            //number of begin() calls which had to block on a fence
+            uint64_t stalls() const {return stall_count;}
+
+        private:
+            GLenum target;
+            GLsizeiptr region_size;
+            uint buffer;
+            std::byte* mapped;
+            uint region;
+            uint64_t stall_count;
+            std::array<GLsync, REGIONS> fences;
+    };
+}
+
+#endif
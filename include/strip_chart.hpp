@@ -0,0 +1,77 @@
+#ifndef STRIP_CHART_H
+#define STRIP_CHART_H
+
+extern "C"{
+    #include <glad/glad.h>
+}
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "sample.hpp"
+#include "decimator.hpp"
+#include "tiers.hpp"
+#include "stream_buffer.hpp"
+
+namespace gl{
+    //Scrolling x/y/z history of one sensor.
+    //Incoming samples are reduced to one min/max pair per pixel column by a
+    //MinMaxDecimator, and the columns live in a ring of vertices (two per slot, min
+    //then max). The GPU copy is a StreamBuffer with one full ring per region: a frame
+    //writes the region the GPU released, copying only the slots touched since that
+    //region was last written (the last REGIONS frames), at most two chunks at the
+    //ring head. The upload cost of a frame depends on the new samples only and the
+    //vertex count on the plot width only, never on the window length or the sample
+    //rate, and the driver never has to synchronize with a draw still in flight.
+    //The ring has one extra slot which mirrors slot 0, which lets a wrapped ring be
+    //drawn as two line strips without a gap at the seam.
+    class StripChart{
+        public:
+            StripChart(uint columns_, float window_length_);
+            ~StripChart();
+            StripChart(const StripChart&) = delete;
+            StripChart& operator=(const StripChart&) = delete;
+
+            //folds a sample into the current column on the CPU side, nothing is sent to the GPU here
+            void append(const Sample& _sample);
+            //the same for a pre-aggregated bucket, used to refill the plot from a TierStore
+            void append(const Bucket& _bucket);
+            //uploads the samples staged since the last frame and draws the three
+            //channels into the currently set viewport
+            void draw(uint _program, float _scale);
+
+            //number of occupied column slots
+            uint size() const {return count;}
+
+        private:
+            struct Vertex{
+                float t;
+                glm::vec3 value;
+            };
+            //slots of the ring from begin on, wrapping
+            struct Range{
+                uint begin;
+                uint count;
+            };
+            //writes the slots changed since the current region was last written, returns its first vertex
+            GLint flush();
+            void upload(std::byte* _region, uint _first, uint _count);
+            void markDirty(uint _slot);
+            void stage(double _timestamp, bool _opened);
+
+            uint capacity;  //column slots, the mirror slot excluded
+            float window_length;
+            MinMaxDecimator decimator;
+            StreamBuffer stream;
+            uint VAO;
+            uint head;  //slot opened next
+            uint count;
+            float latest;   //seconds since the first sample, stored as float near the window
+            uint dirty_begin;   //first slot changed since the last flush
+            uint dirty_count;
+            std::array<Range, StreamBuffer::REGIONS> stale;    //slots each region is missing
+            std::vector<Vertex> staging;  //CPU mirror of the ring (2 vertices per slot), used as upload source
+    };
+}
+
+#endif
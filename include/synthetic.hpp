@@ -0,0 +1,72 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "mqtt/client.h"
+#include "throttle.hpp"
+
+//Publishes generated sensor samples in the payload formats MQTTListener decodes.
+//Every payload is stamped with the wall clock, so a process sharing that clock
+//can measure how long a sample took to reach the screen.
+//  MOTION - smooth rotation about all three axes, optional accel/mag fields
+//  STEPS  - zero rates, except one sample per step interval which turns the
+//           sensor by step_angle about z, alternating direction
+//With a control topic it follows the subscriber's throttle commands.
+class SyntheticPublisher{
+    public:
+        enum Mode : uint8_t{
+            MOTION,
+            STEPS
+        };
+
+        SyntheticPublisher(const std::string _address,
+                        const std::string _client_id,
+                        const std::string _topic_name,
+                        const uint8_t _qos);
+
+        bool connect();
+        //generates samples at _rate Hz until _count were generated (0: no limit) or stop() is called
+        void run(Mode _mode, double _rate, uint8_t _axes, uint64_t _count);
+        void stop() {running = false;}
+        //listens for throttle commands on "<_control_prefix>/<topic>", call before connect()
+        void setControlTopic(const std::string& _control_prefix);
+        //step interval in seconds and rotation per step in degrees
+        void setStep(double _interval, float _angle);
+        uint64_t published() const {return sent;}
+
+        //writes "t,gx,gy,gz[,ax,ay,az[,mx,my,mz]]" into _buffer, returns its length
+        static size_t format(char* _buffer, size_t _size, double _t, uint8_t _axes,
+                            const glm::vec3& _gyro, const glm::vec3& _accel, const glm::vec3& _mag);
+
+    private:
+        const std::string server_address;
+        const std::string client_id;
+        std::string topic_name;
+        uint8_t QOS;
+        mqtt::client cli;
+        std::atomic<bool> running;
+        std::atomic<uint64_t> sent;
+        double step_interval;
+        float step_angle;
+        std::string control_topic;
+        ThrottleCommand throttle;
+        std::chrono::steady_clock::time_point lease_end;
+        uint32_t pending;       //samples in the current batch or rate window
+        uint32_t seq;           //number of the next sample sent
+        uint32_t epoch;         //picked at startup, tells the subscriber the counter started over
+        std::string batch;
+        glm::vec3 gyro_sum;
+        glm::vec3 accel_sum;
+        glm::vec3 mag_sum;
+
+        void poll();
+        void emit(double _t, uint8_t _axes, const glm::vec3& _gyro, const glm::vec3& _accel, const glm::vec3& _mag);
+        void flush();
+        void send(uint32_t _samples);
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "sample_queue.hpp"
+
+//Flow control between the subscriber and the publishers.
+//The subscriber sends commands on "<control prefix>/<sensor topic>":
+//  "throttle,rate,N,L"  - publish one averaged sample per N samples
+//  "throttle,batch,N,L" - pack N samples per message, one per line
+//  "resume"             - back to one message per sample
+//A throttle command holds for L seconds, the subscriber repeats it while the load
+//lasts, so publishers recover on their own if the subscriber goes away.
+struct ThrottleCommand{
+    enum Mode : uint8_t{
+        RESUME,
+        RATE,
+        BATCH
+    };
+    Mode mode;
+    uint32_t factor;
+    double lease;   //seconds
+};
+
+//writes the command text into _buffer, returns its length
+size_t formatCommand(const ThrottleCommand& _command, char* _buffer, size_t _size);
+bool parseCommand(std::string_view _text, ThrottleCommand& _command);
+
+
+//Decides per sensor whether its publisher has to slow down.
+//A sensor is overloaded while its queue drops samples or waits deeper than
+//depth_limit of the queue capacity: its publisher reduces the rate. The listener
+//thread is overloaded while it is busy more than cpu_limit of the time: every
+//publisher batches, which cuts the per message cost but keeps all samples.
+//The factor doubles every evaluation the load lasts and halves after it has
+//been clear for CLEAR_EVALUATIONS evaluations.
+class ThrottleController{
+    public:
+        static constexpr double INTERVAL{1.0};
+        static constexpr uint32_t MAX_FACTOR{16};
+        static constexpr uint32_t CLEAR_EVALUATIONS{3};
+
+        ThrottleController(float _depth_limit, float _cpu_limit);
+
+        //must be called from the thread whose CPU time is measured (the listener).
+        //once per INTERVAL it appends a command for every sensor whose throttle changed
+        //or has to be renewed and returns true if it evaluated.
+        bool evaluate(double _now, const SampleQueue& _queue,
+                    std::vector<std::pair<uint32_t, ThrottleCommand>>& _commands);
+        //busy fraction of the calling thread during the last interval
+        double cpuLoad() const {return cpu_load;}
+
+    private:
+        struct SensorState{
+            uint64_t dropped;   //queue counter at the previous evaluation
+            uint32_t factor;    //1 means not throttled
+            uint32_t clear;     //evaluations without load in a row
+            ThrottleCommand::Mode mode;
+        };
+
+        static double threadCpuSeconds();
+
+        float depth_limit;
+        float cpu_limit;
+        double last_time;
+        double last_cpu;
+        double cpu_load;
+        std::vector<SampleQueue::Stats> stats;
+        std::vector<SensorState> sensors;
+};
+
+#endif
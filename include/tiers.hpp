@@ -0,0 +1,67 @@
+#ifndef TIERS_H
+#define TIERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "sample.hpp"
+
+//min, max and mean of the gyro rates over one time bucket
+struct Bucket{
+    double start;       //seconds, the timestamp itself for a raw sample
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec3 mean;
+    uint32_t count;
+};
+
+//Downsampled history of one sensor at fixed resolutions: raw, 1 s and 1 min.
+//Every sample goes into the raw ring and widens the open 1 s bucket; a closed
+//1 s bucket is stored and folded into the open 1 min bucket the same way, so a
+//sample costs O(1) and nothing is recomputed. Each tier is a fixed ring sized on
+//construction, so the coarser tiers reach back much further than the raw one.
+//A reader asks for a time range at a resolution and gets the coarsest tier that
+//is still fine enough, or a coarser one where the finer tier no longer reaches.
+//Samples are expected in timestamp order; a late one is kept in the open bucket.
+//Only the live strip charts read it. Recordings get their own per second rollups
+//in the sparse index of SeriesQuery, which outlives the process.
+class TierStore{
+    public:
+        static constexpr size_t TIERS{3};
+        //bucket width of every tier in seconds, 0 for raw samples
+        static constexpr std::array<double, TIERS> WIDTHS{0.0, 1.0, 60.0};
+
+        TierStore(size_t _raw_capacity, size_t _second_capacity = 3600, size_t _minute_capacity = 1440);
+
+        void push(const Sample& _sample);
+        //tier read for buckets of _resolution seconds reaching back to _from
+        size_t select(double _from, double _resolution) const;
+        //appends the buckets of tier select() overlapping [_from, _to] in time order, returns their count
+        size_t read(double _from, double _to, double _resolution, std::vector<Bucket>& _out) const;
+        //the same from a given tier, the open bucket included
+        size_t read(size_t _tier, double _from, double _to, std::vector<Bucket>& _out) const;
+        //start of the oldest bucket held by _tier, infinity if it is empty
+        double oldest(size_t _tier) const;
+        double newest() const {return latest;}
+        size_t size(size_t _tier) const {return rings[_tier].count;}
+
+    private:
+        struct Ring{
+            std::vector<Bucket> slots;
+            size_t head;    //oldest bucket
+            size_t count;
+            const Bucket& operator[](size_t _i) const {return slots[(head+_i)%slots.size()];}
+            void push(const Bucket& _bucket);
+        };
+
+        //widens the open bucket of _tier by _bucket, closing it first if _bucket starts a new one
+        void fold(size_t _tier, const Bucket& _bucket);
+
+        std::array<Ring, TIERS> rings;
+        std::array<Bucket, TIERS> open;     //bucket being filled per tier, unused for raw
+        double latest;
+};
+
+#endif
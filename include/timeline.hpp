@@ -0,0 +1,42 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+extern "C"{
+    #include <glad/glad.h>
+}
+#include <vector>
+#include <glm/glm.hpp>
+#include "tiers.hpp"
+
+namespace gl{
+    //Overview of a whole recording with the playback cursor on top.
+    //The min/max buckets of the recording are uploaded once as x/y/z line strips
+    //spanning the viewport; only the two vertices of the cursor line are rewritten
+    //per frame. Drawn with the plot program of the StripChart.
+    class Timeline{
+        public:
+            Timeline(const std::vector<Bucket>& _overview, double _begin, double _end);
+            ~Timeline();
+            Timeline(const Timeline&) = delete;
+            Timeline& operator=(const Timeline&) = delete;
+
+            //recording time at a fraction of the viewport width
+            double time(float _fraction) const {return begin+static_cast<double>(_fraction)*(end-begin);}
+            //draws into the currently set viewport
+            void draw(uint _program, float _scale, double _cursor);
+
+        private:
+            struct Vertex{
+                float t;
+                glm::vec3 value;
+            };
+
+            double begin;
+            double end;
+            uint columns;
+            uint VAO;
+            uint VBO;
+    };
+}
+
+#endif
@@ -5,13 +5,15 @@ extern "C"{
     #include <glad/glad.h>
 }
 #include <GLFW/glfw3.h>
+#include <string>
 #include <string_view>
 #include "camera.hpp"
 
 namespace gl{
     class Window: public Camera{
         public:
-            Window(GLFWwindow*, const uint,const uint, const std::string);
+            //an invisible window still owns a full context and default framebuffer, used by headless tools
+            Window(GLFWwindow*, const uint,const uint, const std::string, const bool _visible = true);
             ~Window();
             void init();
             void createWindow(const std::string window_name);
@@ -20,8 +22,21 @@ namespace gl{
             static void error_callback(int error, const char* description);
             static void mouse_callback(GLFWwindow* window, double xpos, double ypos);
             static void processInput(GLFWwindow *window);
+            //title bar doubles as a small HUD for text the scene does not draw
+            void setTitle(const std::string& _title) {glfwSetWindowTitle(window, _title.c_str());}
             GLFWwindow* get() const {return window;} 
 
+            //playback controls: pressing the left button inside the bottom _area of the
+            //window height scrubs the timeline, space toggles play, the arrow keys step
+            void enableTimeline(float _area);
+            //cursor position as a fraction of the window width while the button is held
+            bool scrubbing(float& _fraction) const;
+            //play toggles and arrow steps (right positive) since the last call
+            static bool takePlayToggle();
+            static int takeSteps();
+            static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+            static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
 
         private:
             uint height;
@@ -31,6 +46,10 @@ namespace gl{
             static inline bool  firstMouse;
             static inline float lastMouseX;
             static inline float lastMouseY;
+            static inline float timeline_area;
+            static inline bool scrub_active;
+            static inline int play_toggles;
+            static inline int steps;
             
     };
 }
@@ -0,0 +1,64 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads with one task deque each.
+//A worker runs the newest task of its own deque and, once that is empty, steals the
+//oldest task of another worker, so a worker left with long tasks hands the rest to
+//idle ones. Tasks submitted from inside a task go to the deque of the worker running
+//it, which keeps follow-up work on the same core; submits from outside are dealt
+//round robin. The deques are locked: a task here is a whole segment, milliseconds
+//of work, and the locks never show up next to it.
+class WorkStealingPool{
+    public:
+        using Task = std::function<void()>;
+
+        struct Stats{
+            uint64_t executed;
+            uint64_t stolen;    //run by another worker than the one it was queued on
+        };
+
+        //one worker per core with _threads==0
+        explicit WorkStealingPool(unsigned _threads = 0);
+        ~WorkStealingPool();
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        void submit(Task _task);
+        //blocks until every task, including the ones submitted by tasks, has run
+        void wait();
+        unsigned threadCount() const {return static_cast<unsigned>(workers.size());}
+        Stats getStats() const {return Stats{executed.load(), stolen.load()};}
+
+    private:
+        struct Queue{
+            std::mutex mx;
+            std::deque<Task> tasks;
+        };
+
+        void run(unsigned _index);
+        bool take(unsigned _index, Task& _task);
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<uint64_t> queued;       //waiting in a deque
+        std::atomic<uint64_t> pending;      //submitted and not finished
+        std::atomic<uint64_t> executed;
+        std::atomic<uint64_t> stolen;
+        std::atomic<unsigned> next;         //round robin for outside submits
+        bool stopping;
+        std::mutex mx;
+        std::condition_variable work;       //a task was queued or the pool stops
+        std::condition_variable finished;   //pending reached 0
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include "aggregate.hpp"
+
+static constexpr double INF{std::numeric_limits<double>::infinity()};
+
+//fewest removals between two resyncs, keeps short windows from resyncing every sample
+static constexpr uint64_t MIN_RESYNC{64};
+
+
+void WindowAggregate::Ring::push_back(const Entry& entry)
+{
+    if(count==entries.size())
+    {
+        std::vector<Entry> grown(std::max<size_t>(16, 2*entries.size()));
+        for(size_t i=0; i<count; ++i) grown[i] = (*this)[i];
+        entries.swap(grown);
+        head = 0;
+    }
+    entries[(head+count)&(entries.size()-1)] = entry;
+    ++count;
+}
+
+
+WindowAggregate::WindowAggregate(double _length, Mode _mode):window_length{_length},
+                                                            mode{_mode},
+                                                            newest{-INF},
+                                                            removed{0},
+                                                            interval{std::numeric_limits<int64_t>::min()},
+                                                            closed{0, 0.0, 0.0, 0.0, 0.0, 0.0}
+{
+    reset();
+}
+
+void WindowAggregate::reset()
+{
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    sum_squares = 0.0;
+    min = INF;
+    max = -INF;
+}
+
+void WindowAggregate::push(double t, double value)
+{
+    if(t<newest) return;
+    newest = t;
+    if(mode==TUMBLING)
+    {
+        const int64_t index{static_cast<int64_t>(std::floor(t/window_length))};
+        if(index!=interval)
+        {
+            //a gap of several intervals leaves the last one with samples as result
+            if(count) closed = current();
+            reset();
+            interval = index;
+        }
+    }
+    else
+    {
+        expire(t-window_length);
+        values.push_back({t, value});
+        while(!mins.empty() && mins.back().value>=value) mins.pop_back();
+        mins.push_back({t, value});
+        while(!maxs.empty() && maxs.back().value<=value) maxs.pop_back();
+        maxs.push_back({t, value});
+    }
+    ++count;
+    const double delta{value-mean};
+    mean += delta/static_cast<double>(count);
+    m2 += delta*(value-mean);
+    sum_squares += value*value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+}
+
+void WindowAggregate::expire(double cutoff)
+{
+    bool expired{false};
+    while(!values.empty() && values.front().t<=cutoff)
+    {
+        const double value{values.front().value};
+        values.pop_front();
+        expired = true;
+        if(--count==0)
+        {
+            reset();
+            continue;
+        }
+        //Welford in reverse
+        const double delta{value-mean};
+        mean -= delta/static_cast<double>(count);
+        m2 -= delta*(value-mean);
+        sum_squares -= value*value;
+        ++removed;
+    }
+    if(!expired) return;
+    while(!mins.empty() && mins.front().t<=cutoff) mins.pop_front();
+    while(!maxs.empty() && maxs.front().t<=cutoff) maxs.pop_front();
+    if(removed>=std::max<uint64_t>(MIN_RESYNC, count)) resync();
+}
+
+void WindowAggregate::resync()
+{
+    removed = 0;
+    double sum{0.0};
+    for(size_t i=0; i<values.count; ++i) sum += values[i].value;
+    mean = values.count ? sum/static_cast<double>(values.count) : 0.0;
+    m2 = 0.0;
+    sum_squares = 0.0;
+    for(size_t i=0; i<values.count; ++i)
+    {
+        const double value{values[i].value};
+        m2 += (value-mean)*(value-mean);
+        sum_squares += value*value;
+    }
+}
+
+Aggregate WindowAggregate::get() const
+{
+    return mode==TUMBLING ? closed : current();
+}
+
+Aggregate WindowAggregate::current() const
+{
+    if(!count) return Aggregate{0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    const double n{static_cast<double>(count)};
+    return Aggregate{count,
+                    mode==SLIDING ? mins.front().value : min,
+                    mode==SLIDING ? maxs.front().value : max,
+                    mean,
+                    std::max(0.0, m2/n),
+                    std::sqrt(std::max(0.0, sum_squares/n))};
+}
+
+
+AggregateEngine::AggregateEngine(const std::vector<double>& _lengths, WindowAggregate::Mode _mode):
+                                                            window_lengths{_lengths},
+                                                            mode{_mode}
+{
+}
+
+void AggregateEngine::push(const Sample& sample)
+{
+    if(sample.sensor>=sensors.size()) sensors.resize(sample.sensor+1);
+    std::vector<WindowAggregate>& windows{sensors[sample.sensor]};
+    if(windows.empty())
+    {
+        windows.reserve(window_lengths.size()*CHANNELS);
+        for(double length : window_lengths)
+        {
+            for(size_t c=0; c<CHANNELS; ++c) windows.emplace_back(length, mode);
+        }
+    }
+    for(size_t w=0; w<window_lengths.size(); ++w)
+    {
+        for(size_t c=0; c<CHANNELS; ++c)
+        {
+            windows[w*CHANNELS+c].push(sample.timestamp, static_cast<double>(sample.value[static_cast<int>(c)]));
+        }
+    }
+}
+
+Aggregate AggregateEngine::get(uint32_t sensor, size_t window, size_t channel) const
+{
+    if(!known(sensor) || window>=window_lengths.size() || channel>=CHANNELS)
+    {
+        return Aggregate{0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    }
+    return sensors[sensor][window*CHANNELS+channel].get();
+}
+
+void AggregateEngine::format(uint32_t sensor, std::string& out) const
+{
+    static constexpr char AXES[CHANNELS]{'x', 'y', 'z'};
+    char line[192];
+    for(size_t w=0; w<window_lengths.size(); ++w)
+    {
+        for(size_t c=0; c<CHANNELS; ++c)
+        {
+            const Aggregate a{get(sensor, w, c)};
+            if(!a.count) continue;
+            const int length{std::snprintf(line, sizeof(line), "%g,%c,%llu,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                                        window_lengths[w], AXES[c], static_cast<unsigned long long>(a.count),
+                                        a.min, a.max, a.mean, a.variance, a.rms)};
+            if(length>0) out.append(line, std::min(static_cast<size_t>(length), sizeof(line)-1));
+        }
+    }
+}
+
+
+bool parseWindowMode(std::string_view name, WindowAggregate::Mode& mode)
+{
+    if(name=="sliding") mode = WindowAggregate::SLIDING;
+    else if(name=="tumbling") mode = WindowAggregate::TUMBLING;
+    else return false;
+    return true;
+}
+
+bool parseWindowLengths(std::string_view list, std::vector<double>& lengths)
+{
+    lengths.clear();
+    while(!list.empty())
+    {
+        const size_t comma{std::min(list.find(','), list.size())};
+        const std::string item{list.substr(0, comma)};
+        list.remove_prefix(std::min(comma+1, list.size()));
+        if(item.empty()) continue;
+        char* end{nullptr};
+        const double length{std::strtod(item.c_str(), &end)};
+        if(end==item.c_str() || *end!='\0' || !(length>0.0)) return false;
+        lengths.push_back(length);
+    }
+    return true;
+}
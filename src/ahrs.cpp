@@ -0,0 +1,208 @@
+#include <cmath>
+#include "ahrs.hpp"
+
+static inline float invSqrt(float x)
+{
+    return 1.0f/std::sqrt(x);
+}
+
+static inline void normalizeQuat(AhrsState& s)
+{
+    const float recipNorm{invSqrt(s.q0*s.q0 + s.q1*s.q1 + s.q2*s.q2 + s.q3*s.q3)};
+    s.q0 *= recipNorm;
+    s.q1 *= recipNorm;
+    s.q2 *= recipNorm;
+    s.q3 *= recipNorm;
+}
+
+void ahrs::integrateGyro(AhrsState& s, float gx, float gy, float gz, float dt)
+{
+    const float rate{std::sqrt(gx*gx + gy*gy + gz*gz)};
+    if(rate<1e-9f) return;
+    const float half_angle{0.5f*rate*dt};
+    const float k{std::sin(half_angle)/rate};
+    const float c{std::cos(half_angle)};
+    const float dx{gx*k}, dy{gy*k}, dz{gz*k};
+    //q <- q * (c, dx, dy, dz)
+    const float q0{s.q0}, q1{s.q1}, q2{s.q2}, q3{s.q3};
+    s.q0 = q0*c - q1*dx - q2*dy - q3*dz;
+    s.q1 = q0*dx + q1*c + q2*dz - q3*dy;
+    s.q2 = q0*dy - q1*dz + q2*c + q3*dx;
+    s.q3 = q0*dz + q1*dy - q2*dx + q3*c;
+    normalizeQuat(s);
+}
+
+void ahrs::madgwickIMU(AhrsState& s, float gx, float gy, float gz,
+                    float ax, float ay, float az, float dt, float beta)
+{
+    float q0{s.q0}, q1{s.q1}, q2{s.q2}, q3{s.q3};
+    //rate of change of quaternion from gyroscope
+    float qDot1{0.5f*(-q1*gx - q2*gy - q3*gz)};
+    float qDot2{0.5f*(q0*gx + q2*gz - q3*gy)};
+    float qDot3{0.5f*(q0*gy - q1*gz + q3*gx)};
+    float qDot4{0.5f*(q0*gz + q1*gy - q2*gx)};
+
+    //feedback only if the accelerometer measurement is valid (avoids NaN in normalization)
+    if(!(ax==0.0f && ay==0.0f && az==0.0f))
+    {
+        float recipNorm{invSqrt(ax*ax + ay*ay + az*az)};
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        const float _2q0{2.0f*q0}, _2q1{2.0f*q1}, _2q2{2.0f*q2}, _2q3{2.0f*q3};
+        const float _4q0{4.0f*q0}, _4q1{4.0f*q1}, _4q2{4.0f*q2};
+        const float _8q1{8.0f*q1}, _8q2{8.0f*q2};
+        const float q0q0{q0*q0}, q1q1{q1*q1}, q2q2{q2*q2}, q3q3{q3*q3};
+
+        //gradient descent corrective step
+        float s0{_4q0*q2q2 + _2q2*ax + _4q0*q1q1 - _2q1*ay};
+        float s1{_4q1*q3q3 - _2q3*ax + 4.0f*q0q0*q1 - _2q0*ay - _4q1 + _8q1*q1q1 + _8q1*q2q2 + _4q1*az};
+        float s2{4.0f*q0q0*q2 + _2q0*ax + _4q2*q3q3 - _2q3*ay - _4q2 + _8q2*q1q1 + _8q2*q2q2 + _4q2*az};
+        float s3{4.0f*q1q1*q3 - _2q1*ax + 4.0f*q2q2*q3 - _2q2*ay};
+        const float step_norm{s0*s0 + s1*s1 + s2*s2 + s3*s3};
+        if(step_norm>0.0f)
+        {
+            recipNorm = invSqrt(step_norm);
+            qDot1 -= beta*s0*recipNorm;
+            qDot2 -= beta*s1*recipNorm;
+            qDot3 -= beta*s2*recipNorm;
+            qDot4 -= beta*s3*recipNorm;
+        }
+    }
+
+    s.q0 = q0 + qDot1*dt;
+    s.q1 = q1 + qDot2*dt;
+    s.q2 = q2 + qDot3*dt;
+    s.q3 = q3 + qDot4*dt;
+    normalizeQuat(s);
+}
+
+void ahrs::madgwickMARG(AhrsState& s, float gx, float gy, float gz,
+                    float ax, float ay, float az,
+                    float mx, float my, float mz, float dt, float beta)
+{
+    //invalid magnetometer measurement, fall back to the IMU update
+    if(mx==0.0f && my==0.0f && mz==0.0f)
+    {
+        madgwickIMU(s, gx, gy, gz, ax, ay, az, dt, beta);
+        return;
+    }
+
+    float q0{s.q0}, q1{s.q1}, q2{s.q2}, q3{s.q3};
+    float qDot1{0.5f*(-q1*gx - q2*gy - q3*gz)};
+    float qDot2{0.5f*(q0*gx + q2*gz - q3*gy)};
+    float qDot3{0.5f*(q0*gy - q1*gz + q3*gx)};
+    float qDot4{0.5f*(q0*gz + q1*gy - q2*gx)};
+
+    if(!(ax==0.0f && ay==0.0f && az==0.0f))
+    {
+        float recipNorm{invSqrt(ax*ax + ay*ay + az*az)};
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+        recipNorm = invSqrt(mx*mx + my*my + mz*mz);
+        mx *= recipNorm;
+        my *= recipNorm;
+        mz *= recipNorm;
+
+        const float _2q0mx{2.0f*q0*mx}, _2q0my{2.0f*q0*my}, _2q0mz{2.0f*q0*mz}, _2q1mx{2.0f*q1*mx};
+        const float _2q0{2.0f*q0}, _2q1{2.0f*q1}, _2q2{2.0f*q2}, _2q3{2.0f*q3};
+        const float _2q0q2{2.0f*q0*q2}, _2q2q3{2.0f*q2*q3};
+        const float q0q0{q0*q0}, q0q1{q0*q1}, q0q2{q0*q2}, q0q3{q0*q3};
+        const float q1q1{q1*q1}, q1q2{q1*q2}, q1q3{q1*q3};
+        const float q2q2{q2*q2}, q2q3{q2*q3}, q3q3{q3*q3};
+
+        //reference direction of earth's magnetic field
+        const float hx{mx*q0q0 - _2q0my*q3 + _2q0mz*q2 + mx*q1q1 + _2q1*my*q2 + _2q1*mz*q3 - mx*q2q2 - mx*q3q3};
+        const float hy{_2q0mx*q3 + my*q0q0 - _2q0mz*q1 + _2q1mx*q2 - my*q1q1 + my*q2q2 + _2q2*mz*q3 - my*q3q3};
+        const float _2bx{std::sqrt(hx*hx + hy*hy)};
+        const float _2bz{-_2q0mx*q2 + _2q0my*q1 + mz*q0q0 + _2q1mx*q3 - mz*q1q1 + _2q2*my*q3 - mz*q2q2 + mz*q3q3};
+        const float _4bx{2.0f*_2bx}, _4bz{2.0f*_2bz};
+
+        //objective function terms shared by the four gradient components
+        const float fa1{2.0f*q1q3 - _2q0q2 - ax};
+        const float fa2{2.0f*q0q1 + _2q2q3 - ay};
+        const float fa3{1.0f - 2.0f*q1q1 - 2.0f*q2q2 - az};
+        const float fm1{_2bx*(0.5f - q2q2 - q3q3) + _2bz*(q1q3 - q0q2) - mx};
+        const float fm2{_2bx*(q1q2 - q0q3) + _2bz*(q0q1 + q2q3) - my};
+        const float fm3{_2bx*(q0q2 + q1q3) + _2bz*(0.5f - q1q1 - q2q2) - mz};
+
+        //gradient descent corrective step
+        float s0{-_2q2*fa1 + _2q1*fa2 - _2bz*q2*fm1 + (-_2bx*q3 + _2bz*q1)*fm2 + _2bx*q2*fm3};
+        float s1{_2q3*fa1 + _2q0*fa2 - 4.0f*q1*fa3 + _2bz*q3*fm1 + (_2bx*q2 + _2bz*q0)*fm2 + (_2bx*q3 - _4bz*q1)*fm3};
+        float s2{-_2q0*fa1 + _2q3*fa2 - 4.0f*q2*fa3 + (-_4bx*q2 - _2bz*q0)*fm1 + (_2bx*q1 + _2bz*q3)*fm2 + (_2bx*q0 - _4bz*q2)*fm3};
+        float s3{_2q1*fa1 + _2q2*fa2 + (-_4bx*q3 + _2bz*q1)*fm1 + (-_2bx*q0 + _2bz*q2)*fm2 + _2bx*q1*fm3};
+        const float step_norm{s0*s0 + s1*s1 + s2*s2 + s3*s3};
+        if(step_norm>0.0f)
+        {
+            recipNorm = invSqrt(step_norm);
+            qDot1 -= beta*s0*recipNorm;
+            qDot2 -= beta*s1*recipNorm;
+            qDot3 -= beta*s2*recipNorm;
+            qDot4 -= beta*s3*recipNorm;
+        }
+    }
+
+    s.q0 = q0 + qDot1*dt;
+    s.q1 = q1 + qDot2*dt;
+    s.q2 = q2 + qDot3*dt;
+    s.q3 = q3 + qDot4*dt;
+    normalizeQuat(s);
+}
+
+
+FusionStage::FusionStage(float beta_):beta{beta_}
+{
+}
+
+void FusionStage::update(AhrsState& state, const Sample& sample, float beta)
+{
+    if(!state.initialized)
+    {
+        state = AhrsState{1.0f, 0.0f, 0.0f, 0.0f, sample.timestamp, true};
+        return;
+    }
+    const double dt{sample.timestamp-state.last_timestamp};
+    state.last_timestamp = sample.timestamp;
+    if(dt<=0.0 || dt>MAX_STEP) return;
+
+    const float deg2rad{static_cast<float>(M_PI/180.0)};
+    const float gx{sample.value.x*deg2rad}, gy{sample.value.y*deg2rad}, gz{sample.value.z*deg2rad};
+    const float fdt{static_cast<float>(dt)};
+    switch(sample.axes)
+    {
+        case 9:
+            ahrs::madgwickMARG(state, gx, gy, gz,
+                            sample.accel.x, sample.accel.y, sample.accel.z,
+                            sample.mag.x, sample.mag.y, sample.mag.z, fdt, beta);
+            break;
+        case 6:
+            ahrs::madgwickIMU(state, gx, gy, gz,
+                            sample.accel.x, sample.accel.y, sample.accel.z, fdt, beta);
+            break;
+        default:
+            ahrs::integrateGyro(state, gx, gy, gz, fdt);
+            break;
+    }
+}
+
+glm::quat FusionStage::process(const Sample& sample)
+{
+    std::lock_guard<std::mutex> lc_{mx};
+    if(sample.sensor>=states.size())
+    {
+        states.resize(sample.sensor+1, AhrsState{1.0f, 0.0f, 0.0f, 0.0f, 0.0, false});
+    }
+    AhrsState& s{states[sample.sensor]};
+    update(s, sample, beta);
+    return glm::quat(s.q0, s.q1, s.q2, s.q3);
+}
+
+glm::quat FusionStage::orientation(uint32_t sensor) const
+{
+    std::lock_guard<std::mutex> lc_{mx};
+    if(sensor>=states.size()) return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    const AhrsState& s{states[sensor]};
+    return glm::quat(s.q0, s.q1, s.q2, s.q3);
+}
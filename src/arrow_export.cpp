@@ -0,0 +1,538 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "arrow_export.hpp"
+#include "spdlog/spdlog.h"
+
+static constexpr float NaN{std::numeric_limits<float>::quiet_NaN()};
+static constexpr uint8_t MAGIC[8]{'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+static constexpr uint8_t ZEROS[ArrowWriter::ALIGNMENT]{};
+static constexpr uint32_t CONTINUATION{0xffffffff};
+
+//values of the Arrow format, Schema.fbs and Message.fbs
+namespace arrow{
+    constexpr int16_t METADATA_V5{4};
+    constexpr int16_t ENDIANNESS_LITTLE{0};
+    constexpr uint8_t HEADER_SCHEMA{1};
+    constexpr uint8_t HEADER_RECORD_BATCH{3};
+    constexpr uint8_t TYPE_INT{2};
+    constexpr uint8_t TYPE_FLOATING_POINT{3};
+    constexpr int16_t PRECISION_SINGLE{1};
+    constexpr int16_t PRECISION_DOUBLE{2};
+
+    struct FieldNode{
+        int64_t length;
+        int64_t null_count;
+    };
+    struct Buffer{
+        int64_t offset;
+        int64_t length;
+    };
+}
+
+static size_t width(ArrowWriter::Type type)
+{
+    return type==ArrowWriter::Type::FLOAT64 ? 8 : 4;
+}
+
+static size_t padded(size_t bytes, size_t alignment)
+{
+    return (bytes+alignment-1)/alignment*alignment;
+}
+
+
+//Minimal FlatBuffers builder for the few tables of the Arrow metadata.
+//Like the reference implementation it grows from the back: children are written
+//before their parents and objects are referred to by their distance from the end.
+class FlatBuilder{
+    public:
+        FlatBuilder():bytes(1024), head{bytes.size()}, alignment{1}, table{0} {}
+
+        uint32_t size() const {return static_cast<uint32_t>(bytes.size()-head);}
+
+        template<typename T>
+        void push(T value)
+        {
+            align(sizeof(T));
+            raw(&value, sizeof(T));
+        }
+
+        uint32_t string(std::string_view text)
+        {
+            prealign(text.size()+1, 4);
+            raw(ZEROS, 1);
+            raw(text.data(), text.size());
+            push(static_cast<uint32_t>(text.size()));
+            return size();
+        }
+
+        //vector of _count structs of _stride bytes
+        uint32_t structs(const void* data, size_t count, size_t stride, size_t struct_alignment)
+        {
+            prealign(count*stride, 4);
+            prealign(count*stride, struct_alignment);
+            raw(data, count*stride);
+            push(static_cast<uint32_t>(count));
+            return size();
+        }
+
+        uint32_t offsets(const std::vector<uint32_t>& targets)
+        {
+            prealign(targets.size()*4, 4);
+            for(size_t i=targets.size(); i-->0;) offset(targets[i]);
+            push(static_cast<uint32_t>(targets.size()));
+            return size();
+        }
+
+        void start()
+        {
+            fields.clear();
+            table = size();
+        }
+
+        template<typename T>
+        void add(uint16_t id, T value)
+        {
+            push(value);
+            fields.emplace_back(id, size());
+        }
+
+        void addOffset(uint16_t id, uint32_t target)
+        {
+            offset(target);
+            fields.emplace_back(id, size());
+        }
+
+        //writes the table and its vtable right before it
+        uint32_t end()
+        {
+            push<int32_t>(0);
+            const uint32_t object{size()};
+            uint16_t count{0};
+            for(const auto& [id, at] : fields) count = std::max<uint16_t>(count, id+1);
+            std::vector<uint16_t> slots(count, 0);
+            for(const auto& [id, at] : fields) slots[id] = static_cast<uint16_t>(object-at);
+            for(size_t i=count; i-->0;) push(slots[i]);
+            push(static_cast<uint16_t>(object-table));
+            push(static_cast<uint16_t>(4+2*count));
+            //the table points back to its vtable, which lies before it
+            const int32_t vtable{static_cast<int32_t>(size()-object)};
+            std::memcpy(bytes.data()+bytes.size()-object, &vtable, sizeof(vtable));
+            return object;
+        }
+
+        //root offset, the finished buffer is a multiple of its largest alignment
+        std::string_view finish(uint32_t root)
+        {
+            prealign(4, alignment);
+            offset(root);
+            return std::string_view(reinterpret_cast<const char*>(bytes.data()+head), size());
+        }
+
+    private:
+        void raw(const void* data, size_t count)
+        {
+            if(count>head)
+            {
+                const size_t used{size()};
+                std::vector<uint8_t> grown(std::max(2*bytes.size(), used+count));
+                std::memcpy(grown.data()+grown.size()-used, bytes.data()+head, used);
+                bytes.swap(grown);
+                head = bytes.size()-used;
+            }
+            head -= count;
+            if(count) std::memcpy(bytes.data()+head, data, count);
+        }
+
+        void align(size_t n)
+        {
+            alignment = std::max(alignment, n);
+            while(size()%n) raw(ZEROS, 1);
+        }
+
+        //aligns so that _n divides the size after _count more bytes
+        void prealign(size_t count, size_t n)
+        {
+            alignment = std::max(alignment, n);
+            while((size()+count)%n) raw(ZEROS, 1);
+        }
+
+        void offset(uint32_t target)
+        {
+            align(4);
+            push(size()+4-target);
+        }
+
+        std::vector<uint8_t> bytes;
+        size_t head;
+        size_t alignment;
+        uint32_t table;
+        std::vector<std::pair<uint16_t, uint32_t>> fields;
+};
+
+static uint32_t buildSchema(FlatBuilder& fb, const std::vector<ArrowWriter::Field>& fields,
+                            const std::vector<std::pair<std::string, std::string>>& metadata)
+{
+    std::vector<uint32_t> built;
+    for(const ArrowWriter::Field& field : fields)
+    {
+        const uint32_t name{fb.string(field.name)};
+        fb.start();
+        if(field.type==ArrowWriter::Type::UINT32)
+        {
+            fb.add<int32_t>(0, 32);
+            fb.add<uint8_t>(1, 0);
+        }
+        else
+        {
+            fb.add<int16_t>(0, field.type==ArrowWriter::Type::FLOAT32 ? arrow::PRECISION_SINGLE
+                                                                        : arrow::PRECISION_DOUBLE);
+        }
+        const uint32_t type{fb.end()};
+        //readers insist on the children vector even if it is empty
+        const uint32_t children{fb.offsets({})};
+        fb.start();
+        fb.addOffset(0, name);
+        fb.add<uint8_t>(1, 0);
+        fb.add<uint8_t>(2, field.type==ArrowWriter::Type::UINT32 ? arrow::TYPE_INT : arrow::TYPE_FLOATING_POINT);
+        fb.addOffset(3, type);
+        fb.addOffset(5, children);
+        built.push_back(fb.end());
+    }
+    const uint32_t vector{fb.offsets(built)};
+    std::vector<uint32_t> pairs;
+    for(const auto& [key, value] : metadata)
+    {
+        const uint32_t k{fb.string(key)};
+        const uint32_t v{fb.string(value)};
+        fb.start();
+        fb.addOffset(0, k);
+        fb.addOffset(1, v);
+        pairs.push_back(fb.end());
+    }
+    const uint32_t custom{pairs.empty() ? 0 : fb.offsets(pairs)};
+    fb.start();
+    fb.add<int16_t>(0, arrow::ENDIANNESS_LITTLE);
+    fb.addOffset(1, vector);
+    if(custom) fb.addOffset(2, custom);
+    return fb.end();
+}
+
+//encapsulated message at file offset _at: continuation marker, metadata size and the
+//flatbuffer, padded so that the body behind it starts at a multiple of _alignment
+static void frame(std::string_view flatbuffer, size_t at, size_t alignment, std::vector<uint8_t>& out)
+{
+    const int32_t size{static_cast<int32_t>(padded(at+8+flatbuffer.size(), alignment)-at-8)};
+    const size_t first{out.size()};
+    out.resize(first+8+static_cast<size_t>(size), 0);
+    std::memcpy(out.data()+first, &CONTINUATION, 4);
+    std::memcpy(out.data()+first+4, &size, 4);
+    std::memcpy(out.data()+first+8, flatbuffer.data(), flatbuffer.size());
+}
+
+static uint32_t buildMessage(FlatBuilder& fb, uint8_t type, uint32_t header, int64_t body)
+{
+    fb.start();
+    fb.add<int16_t>(0, arrow::METADATA_V5);
+    fb.add<uint8_t>(1, type);
+    fb.addOffset(2, header);
+    fb.add<int64_t>(3, body);
+    return fb.end();
+}
+
+//writes all of _parts, resuming after short writes
+static bool writeAll(int fd, std::vector<iovec>& parts)
+{
+    size_t index{0};
+    while(index<parts.size())
+    {
+        const int count{static_cast<int>(std::min<size_t>(parts.size()-index, IOV_MAX))};
+        const ssize_t n{::writev(fd, parts.data()+index, count)};
+        if(n<0 && errno==EINTR) continue;
+        if(n<=0) return false;
+        size_t done{static_cast<size_t>(n)};
+        while(index<parts.size() && done>=parts[index].iov_len)
+        {
+            done -= parts[index].iov_len;
+            ++index;
+        }
+        if(done)
+        {
+            parts[index].iov_base = static_cast<uint8_t*>(parts[index].iov_base)+done;
+            parts[index].iov_len -= done;
+        }
+    }
+    return true;
+}
+
+
+ArrowWriter::ArrowWriter(const std::string& _path, const std::vector<Field>& _fields,
+                        const std::vector<std::pair<std::string, std::string>>& _metadata):fd{-1},
+                                                                                            file_path{_path},
+                                                                                            fields{_fields},
+                                                                                            metadata{_metadata},
+                                                                                            end{0},
+                                                                                            stats{0, 0, 0}
+{
+    fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd<0)
+    {
+        spdlog::error("ArrowWriter: Could not open {}: {}", file_path, std::strerror(errno));
+        return;
+    }
+    FlatBuilder fb;
+    const uint32_t schema{buildSchema(fb, fields, metadata)};
+    std::vector<uint8_t> head{MAGIC, MAGIC+sizeof(MAGIC)};
+    frame(fb.finish(buildMessage(fb, arrow::HEADER_SCHEMA, schema, 0)), head.size(), 8, head);
+    std::vector<iovec> parts{iovec{head.data(), head.size()}};
+    if(!writeAll(fd, parts))
+    {
+        spdlog::error("ArrowWriter: Writing {} failed: {}", file_path, std::strerror(errno));
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+    end = head.size();
+    //no batch yet, the footer alone makes it an empty but valid file
+    write(0, {});
+}
+
+ArrowWriter::~ArrowWriter()
+{
+    if(fd>=0) ::close(fd);
+}
+
+void ArrowWriter::setMetadata(const std::string& key, const std::string& value)
+{
+    for(auto& [k, v] : metadata)
+    {
+        if(k!=key) continue;
+        v = value;
+        return;
+    }
+    metadata.emplace_back(key, value);
+}
+
+bool ArrowWriter::write(size_t rows, const std::vector<const void*>& columns)
+{
+    if(fd<0) return false;
+    if(rows && columns.size()!=fields.size())
+    {
+        spdlog::error("ArrowWriter: {} columns for {} fields of {}", columns.size(), fields.size(), file_path);
+        return false;
+    }
+    std::vector<uint8_t> message;
+    std::vector<iovec> parts;
+    Block block{static_cast<int64_t>(end), 0, 0, 0};
+    if(rows)
+    {
+        //a validity buffer of length 0 per column, no nulls
+        std::vector<arrow::FieldNode> nodes;
+        std::vector<arrow::Buffer> buffers;
+        for(const Field& field : fields)
+        {
+            const size_t bytes{rows*width(field.type)};
+            nodes.push_back(arrow::FieldNode{static_cast<int64_t>(rows), 0});
+            buffers.push_back(arrow::Buffer{block.body, 0});
+            buffers.push_back(arrow::Buffer{block.body, static_cast<int64_t>(bytes)});
+            block.body += static_cast<int64_t>(padded(bytes, ALIGNMENT));
+        }
+        FlatBuilder fb;
+        const uint32_t node_vector{fb.structs(nodes.data(), nodes.size(), sizeof(arrow::FieldNode), 8)};
+        const uint32_t buffer_vector{fb.structs(buffers.data(), buffers.size(), sizeof(arrow::Buffer), 8)};
+        fb.start();
+        fb.add<int64_t>(0, static_cast<int64_t>(rows));
+        fb.addOffset(1, node_vector);
+        fb.addOffset(2, buffer_vector);
+        const uint32_t batch{fb.end()};
+        frame(fb.finish(buildMessage(fb, arrow::HEADER_RECORD_BATCH, batch, block.body)), end, ALIGNMENT, message);
+        block.metadata = static_cast<int32_t>(message.size());
+        parts.push_back(iovec{message.data(), message.size()});
+        for(size_t c=0; c<fields.size(); ++c)
+        {
+            const size_t bytes{rows*width(fields[c].type)};
+            parts.push_back(iovec{const_cast<void*>(columns[c]), bytes});
+            if(padded(bytes, ALIGNMENT)>bytes)
+            {
+                parts.push_back(iovec{const_cast<uint8_t*>(ZEROS), padded(bytes, ALIGNMENT)-bytes});
+            }
+        }
+        blocks.push_back(block);
+    }
+
+    //end of stream marker, footer, its size and the magic again
+    FlatBuilder fb;
+    const uint32_t schema{buildSchema(fb, fields, metadata)};
+    const uint32_t dictionaries{fb.structs(nullptr, 0, sizeof(Block), 8)};
+    const uint32_t batches{fb.structs(blocks.data(), blocks.size(), sizeof(Block), 8)};
+    fb.start();
+    fb.add<int16_t>(0, arrow::METADATA_V5);
+    fb.addOffset(1, schema);
+    fb.addOffset(2, dictionaries);
+    fb.addOffset(3, batches);
+    const std::string_view footer{fb.finish(fb.end())};
+    std::vector<uint8_t> tail(8, 0);
+    std::memcpy(tail.data(), &CONTINUATION, 4);
+    tail.insert(tail.end(), footer.begin(), footer.end());
+    const int32_t footer_size{static_cast<int32_t>(footer.size())};
+    tail.insert(tail.end(), reinterpret_cast<const uint8_t*>(&footer_size),
+                reinterpret_cast<const uint8_t*>(&footer_size)+4);
+    tail.insert(tail.end(), MAGIC, MAGIC+6);
+    parts.push_back(iovec{tail.data(), tail.size()});
+
+    //the new batch replaces the previous footer
+    if(lseek(fd, static_cast<off_t>(end), SEEK_SET)!=static_cast<off_t>(end) || !writeAll(fd, parts))
+    {
+        spdlog::error("ArrowWriter: Writing {} failed: {}", file_path, std::strerror(errno));
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    end += message.size()+static_cast<size_t>(block.body);
+    if(rows) ++stats.batches;
+    stats.rows += rows;
+    stats.bytes = end+tail.size();
+    return true;
+}
+
+
+static const char* const CHANNEL_NAMES[]{"gx", "gy", "gz", "ax", "ay", "az", "mx", "my", "mz",
+                                            "qw", "qx", "qy", "qz"};
+
+static std::vector<ArrowWriter::Field> liveFields()
+{
+    std::vector<ArrowWriter::Field> fields{{"sensor", ArrowWriter::Type::UINT32}, {"t", ArrowWriter::Type::FLOAT64}};
+    for(const char* name : CHANNEL_NAMES) fields.push_back({name, ArrowWriter::Type::FLOAT32});
+    return fields;
+}
+
+ArrowRecorder::ArrowRecorder(const std::string& _path, SeriesRecorder::TopicLookup _topic):writer{_path, liveFields()},
+                                                                                    topic{std::move(_topic)},
+                                                                                    opened{0.0}
+{
+    sensors.reserve(ArrowWriter::BATCH_ROWS);
+    timestamps.reserve(ArrowWriter::BATCH_ROWS);
+    for(std::vector<float>& channel : channels) channel.reserve(ArrowWriter::BATCH_ROWS);
+}
+
+ArrowRecorder::~ArrowRecorder()
+{
+    flush();
+}
+
+void ArrowRecorder::push(const Sample& sample)
+{
+    if(!writer.ok()) return;
+    if(sample.sensor>=named.size()) named.resize(sample.sensor+1, false);
+    if(!named[sample.sensor])
+    {
+        named[sample.sensor] = true;
+        std::string name{topic ? topic(sample.sensor) : std::string{}};
+        if(!name.empty()) writer.setMetadata("sensor."+std::to_string(sample.sensor), name);
+    }
+    if(sensors.empty()) opened = sample.arrival;
+    sensors.push_back(sample.sensor);
+    timestamps.push_back(sample.timestamp);
+    for(int i=0; i<3; ++i)
+    {
+        channels[i].push_back(sample.value[i]);
+        channels[3+i].push_back(sample.axes>=6 ? sample.accel[i] : NaN);
+        channels[6+i].push_back(sample.axes>=9 ? sample.mag[i] : NaN);
+    }
+    channels[9].push_back(sample.orientation.w);
+    channels[10].push_back(sample.orientation.x);
+    channels[11].push_back(sample.orientation.y);
+    channels[12].push_back(sample.orientation.z);
+    if(sensors.size()>=ArrowWriter::BATCH_ROWS || sample.arrival-opened>=FLUSH_SECONDS) flush();
+}
+
+bool ArrowRecorder::flushIdle(double now)
+{
+    if(sensors.empty() || now-opened<FLUSH_SECONDS) return true;
+    return flush();
+}
+
+bool ArrowRecorder::flush()
+{
+    if(sensors.empty()) return true;
+    std::vector<const void*> columns{sensors.data(), timestamps.data()};
+    for(const std::vector<float>& channel : channels) columns.push_back(channel.data());
+    const bool written{writer.write(sensors.size(), columns)};
+    sensors.clear();
+    timestamps.clear();
+    for(std::vector<float>& channel : channels) channel.clear();
+    return written;
+}
+
+
+bool exportArrow(const IndexedSeries& series, double from, double to, const std::string& path,
+                ArrowWriter::Stats& stats)
+{
+    std::vector<uint32_t> hits;
+    series.overlapping(from, to, hits);
+    uint8_t axes{3};
+    for(uint32_t hit : hits) axes = std::max(axes, series.entry(hit).axes);
+    const size_t used{3*std::clamp<size_t>(axes/3, 1, 3)};
+
+    std::vector<ArrowWriter::Field> fields{{"t", ArrowWriter::Type::FLOAT64}};
+    for(size_t c=0; c<used; ++c) fields.push_back({CHANNEL_NAMES[c], ArrowWriter::Type::FLOAT32});
+    ArrowWriter writer{path, fields, {{"topic", series.topic()}}};
+    if(!writer.ok()) return false;
+
+    //batch buffers, segments are decoded into their tail
+    const size_t capacity{ArrowWriter::BATCH_ROWS+SeriesWriter::SEGMENT_SAMPLES};
+    std::vector<double> timestamps(capacity);
+    std::vector<std::vector<float>> channels(used, std::vector<float>(capacity));
+    size_t rows{0};
+    auto write = [&](){
+        std::vector<const void*> columns{timestamps.data()};
+        for(const std::vector<float>& channel : channels) columns.push_back(channel.data());
+        const bool written{writer.write(rows, columns)};
+        rows = 0;
+        return written;
+    };
+
+    for(uint32_t hit : hits)
+    {
+        const IndexedSeries::Entry& entry{series.entry(hit)};
+        const size_t count{entry.summary.count};
+        //fits behind the rows of an unfinished batch, which never reach BATCH_ROWS
+        if(count>SeriesWriter::SEGMENT_SAMPLES)
+        {
+            spdlog::warn("exportArrow: segment of {} samples in {} skipped", count, series.path());
+            continue;
+        }
+        SeriesReader::Columns columns{timestamps.data()+rows, {}};
+        for(size_t c=0; c<used; ++c)
+        {
+            if(c<3*std::clamp<size_t>(entry.axes/3, 1, 3)) columns.channel[c] = channels[c].data()+rows;
+            else std::fill_n(channels[c].data()+rows, count, NaN);
+        }
+        const size_t decoded{series.decodeColumns(hit, columns)};
+        //only segments straddling the range are filtered, in place and in order
+        size_t kept{decoded};
+        if(entry.t_min<from || entry.t_max>to)
+        {
+            kept = 0;
+            for(size_t i=rows; i<rows+decoded; ++i)
+            {
+                if(timestamps[i]<from || timestamps[i]>to) continue;
+                timestamps[rows+kept] = timestamps[i];
+                for(std::vector<float>& channel : channels) channel[rows+kept] = channel[i];
+                ++kept;
+            }
+        }
+        rows += kept;
+        if(rows>=ArrowWriter::BATCH_ROWS && !write()) return false;
+    }
+    if(rows && !write()) return false;
+    stats = writer.getStats();
+    return true;
+}
@@ -0,0 +1,74 @@
+#include "axes.hpp"
+#include <glm/gtc/type_ptr.hpp>
+using namespace gl;
+
+
+static const float vertices[] = {
+        //positions             //colors
+        0.0f,  0.0f, 0.0f, 1.0f, 0.0f, 0.0f, // origin
+        0.0f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, // origin
+        0.0f,  0.0f, 0.0f, 0.0f, 0.0f, 1.0f, // origin
+        0.0f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, // x
+        0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,  // y
+        0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 1.0f //z
+};
+
+static const uint indices[] = {
+        0, 3, //first axis
+        1, 4, //second axis
+        2, 5 //third axis
+};
+
+
+Axes::Axes():VAO{0},
+            VBO{0},
+            EBO{0}
+{
+    //generate VAO object and bind it first of all
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
+    //create element buffer object EBO
+    glGenBuffers(1, &EBO);
+    glGenBuffers(1, &VBO);
+    //then bind and set EBO and VBOs
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    //we have to specify how OpenGL should interpret vertex data.
+    //it stores vertex data attributes including vertex buffer array in VAO object currently bound.
+    //position attribute
+    glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,6*sizeof(float),(void*)0);
+    glEnableVertexAttribArray(0); //enable vertex position attribute array- arg is an attribute index
+    //color attribute, starts after the 3 position values of each vertex
+    glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,6*sizeof(float),(void*)(3*sizeof(float))); //last arg is an offset
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0); //unbind VBO after glVertexAttribPointer function.
+    glBindVertexArray(0);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glEnable(GL_DEPTH_TEST);
+}
+
+Axes::~Axes()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+void Axes::draw(uint program, const glm::mat4& model,
+                const glm::mat4& view, const glm::mat4& projection) const
+{
+    glUseProgram(program);
+    glBindVertexArray(VAO);
+    glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+    //draw axis lines
+    glLineWidth(3);
+    glDrawElements(GL_LINES, 6, GL_UNSIGNED_INT, 0);  //indices are taken from the EBO
+}
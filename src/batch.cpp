@@ -0,0 +1,244 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include "batch.hpp"
+#include "series_store.hpp"
+#include "spdlog/spdlog.h"
+
+static constexpr double INF{std::numeric_limits<double>::infinity()};
+static constexpr int64_t NO_INTERVAL{std::numeric_limits<int64_t>::min()};
+
+
+BatchJob::BatchJob(const SeriesQuery& _query, const Options& _options):query{_query},
+                                                                    options{_options},
+                                                                    pool{nullptr},
+                                                                    samples{0},
+                                                                    segments{0},
+                                                                    bytes{0}
+{
+}
+
+BatchJob::~BatchJob()
+{
+    for(const std::unique_ptr<Chain>& chain : chains)
+    {
+        if(chain->orientations) std::fclose(chain->orientations);
+        if(chain->summary) std::fclose(chain->summary);
+    }
+}
+
+bool BatchJob::run(WorkStealingPool& _pool)
+{
+    pool = &_pool;
+    for(const std::string& topic : query.topics())
+    {
+        auto chain{std::make_unique<Chain>()};
+        chain->series = query.find(topic);
+        chain->series->overlapping(-INF, INF, chain->segments);
+        if(chain->segments.empty()) continue;
+        chain->links = std::make_unique<Link[]>(chain->segments.size());
+        for(size_t i=0; i<chain->segments.size(); ++i)
+        {
+            //the first link has no predecessor to wait for
+            chain->links[i].fuse_waiting = i ? 2 : 1;
+            chain->links[i].write_waiting = i ? 2 : 1;
+        }
+        chain->state = AhrsState{1.0f, 0.0f, 0.0f, 0.0f, 0.0, false};
+        for(double length : options.windows)
+        {
+            for(int c=0; c<3; ++c) chain->windows.emplace_back(length, WindowAggregate::TUMBLING);
+        }
+        chain->intervals.assign(options.windows.size(), NO_INTERVAL);
+        chain->exported = 0;
+        chain->orientations = nullptr;
+        chain->summary = nullptr;
+        chain->failed = false;
+
+        //results are named after the series file, "<file>.orientation.csv" and "<file>.statistics.csv"
+        std::string base{series::fileName(options.output, topic)};
+        base.resize(base.size()-std::strlen(".gts"));
+        if(options.decimate)
+        {
+            chain->orientations = std::fopen((base+".orientation.csv").c_str(), "wb");
+            if(!chain->orientations)
+            {
+                spdlog::error("BatchJob: Could not create {}.orientation.csv: {}", base, std::strerror(errno));
+                return false;
+            }
+            std::fputs("t,w,x,y,z\n", chain->orientations);
+        }
+        if(!options.windows.empty())
+        {
+            chain->summary = std::fopen((base+".statistics.csv").c_str(), "wb");
+            if(!chain->summary)
+            {
+                spdlog::error("BatchJob: Could not create {}.statistics.csv: {}", base, std::strerror(errno));
+                return false;
+            }
+            std::fputs("start,window,channel,count,min,max,mean,variance,rms\n", chain->summary);
+        }
+        chains.push_back(std::move(chain));
+    }
+
+    for(const std::unique_ptr<Chain>& chain : chains)
+    {
+        Chain* c{chain.get()};
+        for(size_t i=0; i<std::min(LOOKAHEAD, c->segments.size()); ++i)
+        {
+            pool->submit([this, c, i]{decode(*c, i);});
+        }
+    }
+    pool->wait();
+
+    bool ok{true};
+    for(const std::unique_ptr<Chain>& chain : chains)
+    {
+        if(chain->failed)
+        {
+            spdlog::error("BatchJob: Writing the results of {} failed", chain->series->topic());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void BatchJob::decode(Chain& chain, size_t index)
+{
+    Link& link{chain.links[index]};
+    chain.series->decode(chain.segments[index], link.samples);
+    for(Sample& s : link.samples) s.value = (s.value-options.bias)*options.scale;
+    samples += link.samples.size();
+    ++segments;
+    arriveFuse(chain, index);
+}
+
+void BatchJob::arriveFuse(Chain& chain, size_t index)
+{
+    //the second of decode and the previous fuse to finish hands the link on
+    if(chain.links[index].fuse_waiting.fetch_sub(1)==1)
+    {
+        Chain* c{&chain};
+        pool->submit([this, c, index]{fuse(*c, index);});
+    }
+}
+
+void BatchJob::arriveWrite(Chain& chain, size_t index)
+{
+    if(chain.links[index].write_waiting.fetch_sub(1)==1)
+    {
+        Chain* c{&chain};
+        pool->submit([this, c, index]{write(*c, index);});
+    }
+}
+
+void BatchJob::fuse(Chain& chain, size_t index)
+{
+    static constexpr char AXES[3]{'x', 'y', 'z'};
+    Link& link{chain.links[index]};
+    const size_t windows{options.windows.size()};
+    for(Sample& s : link.samples)
+    {
+        FusionStage::update(chain.state, s, options.beta);
+        s.orientation = glm::quat(chain.state.q0, chain.state.q1, chain.state.q2, chain.state.q3);
+        for(size_t w=0; w<windows; ++w)
+        {
+            const int64_t interval{static_cast<int64_t>(std::floor(s.timestamp/options.windows[w]))};
+            for(int c=0; c<3; ++c) chain.windows[w*3+c].push(s.timestamp, static_cast<double>(s.value[c]));
+            //the push closed the previous interval
+            if(interval!=chain.intervals[w] && chain.intervals[w]!=NO_INTERVAL)
+            {
+                for(int c=0; c<3; ++c)
+                {
+                    const Aggregate a{chain.windows[w*3+c].get()};
+                    fmt::format_to(std::back_inserter(link.statistics), "{:.6f},{},{},{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}\n",
+                                chain.intervals[w]*options.windows[w], options.windows[w], AXES[c], a.count,
+                                a.min, a.max, a.mean, a.variance, a.rms);
+                }
+            }
+            chain.intervals[w] = interval;
+        }
+    }
+    //the intervals still open at the end of the recording
+    if(index+1==chain.segments.size())
+    {
+        for(size_t w=0; w<windows; ++w)
+        {
+            for(int c=0; c<3 && chain.intervals[w]!=NO_INTERVAL; ++c)
+            {
+                const Aggregate a{chain.windows[w*3+c].current()};
+                fmt::format_to(std::back_inserter(link.statistics), "{:.6f},{},{},{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}\n",
+                            chain.intervals[w]*options.windows[w], options.windows[w], AXES[c], a.count,
+                            a.min, a.max, a.mean, a.variance, a.rms);
+            }
+        }
+    }
+    //decimation continues across segments, the format task only needs the offset
+    if(options.decimate)
+    {
+        link.first = (options.decimate-chain.exported%options.decimate)%options.decimate;
+        chain.exported += link.samples.size();
+    }
+    Chain* c{&chain};
+    pool->submit([this, c, index]{format(*c, index);});
+    if(index+1<chain.segments.size()) arriveFuse(chain, index+1);
+}
+
+void BatchJob::format(Chain& chain, size_t index)
+{
+    Link& link{chain.links[index]};
+    if(options.decimate)
+    {
+        link.text.reserve(64*(link.samples.size()/options.decimate+1));
+        for(size_t i=link.first; i<link.samples.size(); i+=options.decimate)
+        {
+            const Sample& s{link.samples[i]};
+            fmt::format_to(std::back_inserter(link.text), "{:.6f},{:.6f},{:.6f},{:.6f},{:.6f}\n",
+                        s.timestamp, s.orientation.w, s.orientation.x, s.orientation.y, s.orientation.z);
+        }
+    }
+    std::vector<Sample>().swap(link.samples);
+    arriveWrite(chain, index);
+}
+
+void BatchJob::write(Chain& chain, size_t index)
+{
+    Link& link{chain.links[index]};
+    if(chain.orientations && !link.text.empty() &&
+        std::fwrite(link.text.data(), 1, link.text.size(), chain.orientations)!=link.text.size())
+    {
+        chain.failed = true;
+    }
+    if(chain.summary && !link.statistics.empty() &&
+        std::fwrite(link.statistics.data(), 1, link.statistics.size(), chain.summary)!=link.statistics.size())
+    {
+        chain.failed = true;
+    }
+    bytes += link.text.size()+link.statistics.size();
+    std::string().swap(link.text);
+    std::string().swap(link.statistics);
+    //a link left the pipeline, the next one may start decoding
+    if(index+LOOKAHEAD<chain.segments.size())
+    {
+        Chain* c{&chain};
+        const size_t next{index+LOOKAHEAD};
+        pool->submit([this, c, next]{decode(*c, next);});
+    }
+    if(index+1<chain.segments.size()) arriveWrite(chain, index+1);
+}
+
+
+bool parseVector(const std::string& text, glm::vec3& out)
+{
+    const char* begin{text.c_str()};
+    char* end{nullptr};
+    for(int c=0; c<3; ++c)
+    {
+        out[c] = std::strtof(begin, &end);
+        if(end==begin || (c<2 && *end!=',') || (c==2 && *end!='\0')) return false;
+        begin = end+1;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cmath>
+#include "filter_bank.hpp"
+#include "spdlog/spdlog.h"
+
+
+FilterBank::FilterBank(size_t sensors_, float beta_):beta{beta_},
+                                                    level{simd::detect()},
+                                                    pending{0}
+{
+    resize(sensors_);
+    spdlog::info("FilterBank: using {} kernel", simd::levelName(simd::kernels(level).level));
+}
+
+void FilterBank::resize(size_t sensors)
+{
+    const size_t old_size{size()};
+    for(std::vector<float>* v : {&q1, &q2, &q3, &gx, &gy, &gz, &ax, &ay, &az, &dt})
+    {
+        v->resize(sensors, 0.0f);
+    }
+    q0.resize(sensors, 1.0f);
+    last_timestamp.resize(sensors, 0.0);
+    initialized.resize(sensors, 0);
+    if(sensors>old_size)
+    {
+        spdlog::debug("FilterBank: grown to {} sensors", sensors);
+    }
+}
+
+void FilterBank::setLevel(simd::Level _level)
+{
+    level = simd::kernels(_level).level;
+}
+
+void FilterBank::stage(const Sample& sample)
+{
+    if(sample.sensor>=size())
+    {
+        resize(sample.sensor+1);
+    }
+    const size_t i{sample.sensor};
+    if(!initialized[i])
+    {
+        last_timestamp[i] = sample.timestamp;
+        initialized[i] = 1;
+        return;
+    }
+    const double step{sample.timestamp-last_timestamp[i]};
+    last_timestamp[i] = sample.timestamp;
+    if(step<=0.0 || step>FusionStage::MAX_STEP) return;
+
+    //one sample per sensor and batch, a second one closes the batch
+    if(dt[i]!=0.0f) advance();
+    const float deg2rad{static_cast<float>(M_PI/180.0)};
+    setInput(i, sample.value*deg2rad,
+            sample.axes>=6 ? sample.accel : glm::vec3(0.0f),
+            static_cast<float>(step));
+    ++pending;
+}
+
+void FilterBank::advance()
+{
+    const ImuBatchView batch{q0.data(), q1.data(), q2.data(), q3.data(),
+                            gx.data(), gy.data(), gz.data(),
+                            ax.data(), ay.data(), az.data(),
+                            dt.data(), size(), beta};
+    simd::kernels(level).madgwickIMU(batch);
+
+    std::fill(dt.begin(), dt.end(), 0.0f);
+    pending = 0;
+}
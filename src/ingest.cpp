@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include "ingest.hpp"
+#include "spdlog/spdlog.h"
+
+
+ShardedIngest::ShardedIngest(const IngestOptions& options, uint32_t count):tier_capacities{0, 0, 0}
+{
+    if(options.topics.empty())
+    {
+        spdlog::critical("ShardedIngest: No topic to subscribe");
+        std::exit(EXIT_FAILURE);
+    }
+    const bool shared{!options.share_group.empty()};
+    //a member of a round robin group fuses every sensor from a fraction of its samples
+    if(shared && !options.share_by_topic)
+    {
+        if(!options.result_topic.empty())
+        {
+            spdlog::critical("ShardedIngest: Results of share group {} would be fused from partial streams, "
+                            "set --share_by_topic if the broker dispatches by topic", options.share_group);
+            std::exit(EXIT_FAILURE);
+        }
+        spdlog::warn("ShardedIngest: Share group {} may split a sensor between members, "
+                    "orientations are only right if the broker dispatches by topic", options.share_group);
+    }
+    //without a share group a shard with no filter would sit idle
+    if(!shared && count>options.topics.size())
+    {
+        spdlog::warn("ShardedIngest: {} topic filters for {} shards, using {}",
+                    options.topics.size(), count, options.topics.size());
+        count = static_cast<uint32_t>(options.topics.size());
+    }
+    count = std::max(1u, count);
+    const unsigned cores{std::max(1u, std::thread::hardware_concurrency())};
+
+    for(uint32_t k=0; k<count; ++k)
+    {
+        std::vector<std::string> filters;
+        for(size_t i=0; i<options.topics.size(); ++i)
+        {
+            if(shared || i%count==k) filters.push_back(options.topics[i]);
+        }
+        //a single shard keeps the plain client id, and with it the broker session
+        const std::string client_id{count==1 ? options.client_id : options.client_id+"_"+std::to_string(k)};
+
+        Shard shard;
+        shard.fusion = std::make_unique<FusionStage>(options.beta);
+        shard.queue = std::make_unique<SampleQueue>(options.queue_capacity, options.policy, options.downsample);
+        shard.listener = std::make_unique<MQTTListener>(options.servers, client_id, filters[0], options.qos,
+                                                        options.session_expiry, options.spill_capacity/count,
+                                                        options.spill_directory);
+        for(size_t i=1; i<filters.size(); ++i) shard.listener->addTopic(filters[i]);
+        shard.listener->setShard(k, count, options.pin ? static_cast<int>(k%cores) : -1);
+        if(shared) shard.listener->setShareGroup(options.share_group);
+        if(!options.result_topic.empty()) shard.listener->setResultTopic(options.result_topic);
+        if(options.throttle)
+        {
+            shard.throttle = std::make_unique<ThrottleController>(options.throttle_depth, options.throttle_cpu);
+            shard.listener->setThrottle(shard.throttle.get(), options.control_topic);
+        }
+        spdlog::info("ShardedIngest: shard {} subscribes {} filters as {}", k, filters.size(), client_id);
+        shards.push_back(std::move(shard));
+    }
+}
+
+ShardedIngest::~ShardedIngest()
+{
+    stop();
+}
+
+void ShardedIngest::start()
+{
+    for(Shard& shard : shards)
+    {
+        shard.setup = std::async(std::launch::async, &MQTTListener::setupMQTT, shard.listener.get());
+        shard.listen = std::async(std::launch::async, &MQTTListener::listen, shard.listener.get(),
+                                std::ref(*shard.queue), std::ref(*shard.fusion));
+    }
+}
+
+void ShardedIngest::stop()
+{
+    for(Shard& shard : shards) shard.listener->stop();
+    for(Shard& shard : shards)
+    {
+        if(shard.setup.valid()) shard.setup.wait();
+        if(shard.listen.valid()) shard.listen.wait();
+    }
+}
+
+void ShardedIngest::setOrdered(double lateness, double idle)
+{
+    merge = std::make_unique<WatermarkMerge>(lateness, idle);
+}
+
+void ShardedIngest::setTiers(size_t raw_capacity, size_t second_capacity, size_t minute_capacity)
+{
+    tier_capacities = {raw_capacity, second_capacity, minute_capacity};
+}
+
+size_t ShardedIngest::drain(std::vector<Sample>& out)
+{
+    //shard by shard, samples of one sensor stay in order
+    out.clear();
+    const uint32_t count{static_cast<uint32_t>(shards.size())};
+    for(uint32_t k=0; k<count; ++k)
+    {
+        shards[k].queue->drain(scratch);
+        //queues hold shard local sensor ids
+        for(Sample& sample : scratch) sample.sensor = sample.sensor*count+k;
+        if(merge)
+        {
+            for(const Sample& sample : scratch) merge->push(sample);
+        }
+        else
+        {
+            out.insert(out.end(), scratch.begin(), scratch.end());
+        }
+    }
+    if(merge) merge->pop(steadySeconds(), out);
+    if(tier_capacities[0])
+    {
+        for(const Sample& sample : out)
+        {
+            if(sample.sensor>=tier_stores.size()) tier_stores.resize(sample.sensor+1);
+            std::unique_ptr<TierStore>& store{tier_stores[sample.sensor]};
+            if(!store) store = std::make_unique<TierStore>(tier_capacities[0], tier_capacities[1], tier_capacities[2]);
+            store->push(sample);
+        }
+    }
+    return out.size();
+}
+
+void ShardedIngest::stats(std::vector<SampleQueue::Stats>& out)
+{
+    //a sensor lives in exactly one shard, under its local id there
+    out.clear();
+    const size_t count{shards.size()};
+    for(size_t k=0; k<count; ++k)
+    {
+        shards[k].queue->stats(scratch_stats);
+        if(scratch_stats.empty()) continue;
+        out.resize(std::max(out.size(), (scratch_stats.size()-1)*count+k+1), SampleQueue::Stats{});
+        for(size_t i=0; i<scratch_stats.size(); ++i) out[i*count+k] = scratch_stats[i];
+    }
+}
+
+std::string ShardedIngest::topic(uint32_t sensor)
+{
+    std::string name;
+    shards[sensor%shards.size()].listener->sensorTopic(sensor, name);
+    return name;
+}
+
+bool ShardedIngest::publish(uint32_t sensor, const std::string& prefix, const std::string& payload)
+{
+    return shards[sensor%shards.size()].listener->publishSensor(sensor, prefix, payload);
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include "jitter_buffer.hpp"
+#include "kernels.hpp"
+
+//the offset may grow by this many seconds per second to follow clock drift
+constexpr double OFFSET_RELAX{1e-3};
+//smoothing of the transit statistics, 1/16 like RFC 3550's jitter estimate
+constexpr double TRANSIT_GAIN{1.0/16.0};
+//how fast the delay follows its target per sample
+constexpr double DELAY_GAIN{0.05};
+
+
+JitterBuffer::JitterBuffer():head{0},
+                            count{0},
+                            offset{0.0},
+                            last_arrival{0.0},
+                            transit_mean{0.0},
+                            transit_dev{0.0},
+                            period{0.0},
+                            target_delay{0.0}
+{
+}
+
+void JitterBuffer::push(double timestamp, double arrival, const glm::quat& q)
+{
+    if(count>0 && timestamp<=at(0).t) return;
+
+    const double transit{arrival-timestamp};
+    if(count==0)
+    {
+        offset = transit;
+    }
+    else
+    {
+        offset = std::min(offset+OFFSET_RELAX*(arrival-last_arrival), transit);
+        const double excess{transit-offset};
+        transit_mean += TRANSIT_GAIN*(excess-transit_mean);
+        transit_dev += TRANSIT_GAIN*(std::fabs(excess-transit_mean)-transit_dev);
+        period += TRANSIT_GAIN*((timestamp-at(0).t)-period);
+        const double target{std::min(MAX_DELAY, transit_mean+4.0*transit_dev+period)};
+        target_delay += DELAY_GAIN*(target-target_delay);
+    }
+    last_arrival = arrival;
+
+    entries[head] = Entry{timestamp, q};
+    head = (head+1)%CAPACITY;
+    count = std::min(count+1, CAPACITY);
+}
+
+JitterBuffer::Result JitterBuffer::bracket(double now, bool extrapolate,
+                                        glm::quat& a, glm::quat& b, float& t) const
+{
+    if(count==0) return EMPTY;
+
+    const double render_time{now-offset-(extrapolate ? 0.0 : target_delay)};
+    const Entry& newest{at(0)};
+    if(render_time>=newest.t)
+    {
+        a = newest.q;
+        if(!extrapolate || count<2) return DIRECT;
+        //keep turning with the rotation rate between the last two samples
+        const Entry& previous{at(1)};
+        const glm::quat delta{glm::inverse(previous.q)*newest.q};
+        const float angle{2.0f*std::acos(std::clamp(std::fabs(delta.w), 0.0f, 1.0f))};
+        if(angle<1e-6f) return DIRECT;
+        const glm::vec3 axis{glm::normalize(glm::vec3(delta.x, delta.y, delta.z)*(delta.w<0.0f ? -1.0f : 1.0f))};
+        const double ahead{std::min(render_time-newest.t, MAX_EXTRAPOLATION)};
+        const float fraction{static_cast<float>(ahead/(newest.t-previous.t))};
+        a = glm::normalize(newest.q*glm::angleAxis(angle*fraction, axis));
+        return DIRECT;
+    }
+
+    //newest samples first, the render time is normally a few entries behind the head
+    for(size_t age=1; age<count; ++age)
+    {
+        const Entry& older{at(age)};
+        if(older.t<=render_time)
+        {
+            const Entry& newer{at(age-1)};
+            a = older.q;
+            b = newer.q;
+            t = static_cast<float>((render_time-older.t)/(newer.t-older.t));
+            return INTERPOLATE;
+        }
+    }
+    a = at(count-1).q;
+    return DIRECT;
+}
+
+
+void OrientationJitter::push(const Sample& sample)
+{
+    if(sample.sensor>=buffers.size())
+    {
+        buffers.resize(sample.sensor+1);
+    }
+    buffers[sample.sensor].push(sample.timestamp, sample.arrival, sample.orientation);
+}
+
+void OrientationJitter::sample(double now, std::vector<glm::quat>& out)
+{
+    out.assign(buffers.size(), glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    lanes.clear();
+    for(std::vector<float>* v : {&a_w, &a_x, &a_y, &a_z, &b_w, &b_x, &b_y, &b_z, &t})
+    {
+        v->clear();
+    }
+
+    for(uint32_t sensor=0; sensor<buffers.size(); ++sensor)
+    {
+        glm::quat qa, qb;
+        float ratio{0.0f};
+        switch(buffers[sensor].bracket(now, extrapolate, qa, qb, ratio))
+        {
+            case JitterBuffer::INTERPOLATE:
+                lanes.push_back(sensor);
+                a_w.push_back(qa.w); a_x.push_back(qa.x); a_y.push_back(qa.y); a_z.push_back(qa.z);
+                b_w.push_back(qb.w); b_x.push_back(qb.x); b_y.push_back(qb.y); b_z.push_back(qb.z);
+                t.push_back(ratio);
+                break;
+            case JitterBuffer::DIRECT:
+                out[sensor] = qa;
+                break;
+            default:
+                break;
+        }
+    }
+    if(lanes.empty()) return;
+
+    const size_t n{lanes.size()};
+    for(std::vector<float>* v : {&o_w, &o_x, &o_y, &o_z})
+    {
+        v->resize(n);
+    }
+    simd::kernels().quatSlerp(QuatSoA{a_w.data(), a_x.data(), a_y.data(), a_z.data()},
+                            QuatSoA{b_w.data(), b_x.data(), b_y.data(), b_z.data()},
+                            t.data(),
+                            QuatSoA{o_w.data(), o_x.data(), o_y.data(), o_z.data()},
+                            n);
+    for(size_t i=0; i<n; ++i)
+    {
+        out[lanes[i]] = glm::quat(o_w[i], o_x[i], o_y[i], o_z[i]);
+    }
+}
@@ -1,19 +1,37 @@
 #include "listener.hpp"
 #include "spdlog/spdlog.h"
 #include <exception>
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <iterator>
+#include <pthread.h>
+#include <sched.h>
 
 
-MQTTListener::MQTTListener(const std::string _address,
+MQTTListener::MQTTListener(const std::vector<std::string> _servers,
                     const std::string _client_id,
                     const std::string _topic_name,
-                    const uint8_t _qos):server_address{_address},
+                    const uint8_t _qos,
+                    const uint32_t _session_expiry,
+                    const size_t _spill_capacity,
+                    const std::string _spill_directory):ready{false},
+                                        servers{_servers},
                                         client_id{_client_id},
-                                        topic_name{_topic_name},
+                                        topic_names{_topic_name},
                                         QOS{_qos},
-                                        cli{
-                                            mqtt::client(server_address, 
-                                                        client_id,
-                                                        mqtt::create_options(MQTTVERSION_5))}
+                                        reconnect{servers, client_id, _session_expiry},
+                                        spill{_spill_capacity, _spill_directory},
+                                        spill_rejected{0},
+                                        stats_time{0.0},
+                                        throttle{nullptr},
+                                        result_time{0.0},
+                                        shard_index{0},
+                                        shard_count{1},
+                                        core{-1},
+                                        stopping{false}
 {            
     spdlog::info("MQTTListener instance created successfully!");
 }
@@ -30,62 +48,69 @@ bool MQTTListener::setupMQTT()
     std::unique_lock<std::mutex> lc_{mx};
     spdlog::info("MQTTListener client connecting to the MQTT server!");
 
-    connOpts = mqtt::connect_options_builder()
-                            .keep_alive_interval(20s)
-                            .automatic_reconnect(2s, 30s)
-                            .clean_session(true)
-                            .finalize();
-    
-    mqtt::connect_response rsp{cli.connect(connOpts)};
-    
-    if(!rsp.is_session_present()){
-        spdlog::info("Subscribing to topics...");            
-        cli.subscribe(topic_name, QOS);
-        spdlog::info("OK");
+    //the session outlives the connection, so the client id has to stay the same across runs.
+    //the callback only copies the message into the spill buffer, the transport never waits for the pipeline
+    //a shared subscription hands every worker only part of each sensor's stream,
+    //so the reorder window would see nothing but gaps
+    const bool shared{!share_group.empty()};
+    reconnect.setMessageCallback([this, shared](mqtt::const_message_ptr msg){
+        const mqtt::binary& payload{msg->get_payload()};
+        uint32_t seq;
+        uint32_t epoch;
+        const bool sequenced{!shared && sequenceNumber(*msg, seq, epoch)};
+        spill.push(msg->get_topic(), std::string_view(payload.data(), payload.size()),
+                sequenced ? &seq : nullptr, sequenced ? epoch : 0u, steadySeconds());
+    });
+    for(const std::string& topic : topic_names)
+    {
+        reconnect.addTopic(shared ? "$share/"+share_group+"/"+topic : topic, QOS);
     }
-    else
+    if(!reconnect.connect())
     {
-        spdlog::warn("Session already established!");
+        return false;
     }
+    ready = true;
     lc_.unlock();   
     cv.notify_one();
-    ready = true;          
     return ready;
 }
 
-bool MQTTListener::listen(glm::vec3& view_angles)
+bool MQTTListener::listen(SampleQueue& queue, FusionStage& fusion)
 {
+    if(core>=0) pinThread(core);
     try
     {     
-        while(true)
+        while(!stopping)
         {
             std::unique_lock<std::mutex> lc_{mx};          
-            cv.wait(lc_, [&](){return ready;});
+            //stop() does not take the lock, so the wait is bounded
+            if(!cv.wait_for(lc_, 100ms, [&](){return ready;})) continue;
 
-            auto msg = cli.consume_message();
-
-            if(msg)            
-            {               
-                if(!data_handler(*msg, view_angles))
-                {
-                    throw std::runtime_error("MQTTListener::listen: Payload is empty!!!\n");
-                }                
-            }
-            else if(!cli.is_connected())
+            //bounded wait, so samples held behind a sequence gap are released in time
+            SpillBuffer::Record record;
+            if(spill.wait(10ms))
             {
-                spdlog::critical("MQTTListener::listen: Lost connection...");
-                while(!cli.is_connected())
+                for(size_t i=0; i<DRAIN_BATCH && spill.front(record); ++i)
                 {
-                    std::this_thread::sleep_for(250ms);
+                    const bool handled{data_handler(record, queue, fusion)};
+                    spill.pop();
+                    if(!handled)
+                    {
+                        throw std::runtime_error("MQTTListener::listen: Payload is empty!!!\n");
+                    }
                 }
-                spdlog::info("Re-established connection!");
             }
+            const double now{steadySeconds()};
+            expireSequences(now, queue, fusion);
+            logSequenceStats(now);
+            throttleSensors(now, queue);
+            publishResults(now);
             lc_.unlock();
         }
 
         // disconnect the connection 
         spdlog::warn("Disconnection from the MQTT server...");
-        cli.disconnect();
+        reconnect.stop();
         spdlog::info("Connection closed!");
     }
     catch(const mqtt::exception& e)
@@ -97,29 +122,90 @@ bool MQTTListener::listen(glm::vec3& view_angles)
     return true;
 }
 
-glm::vec3 MQTTListener::decodeBuffer(const char* _str)
+size_t MQTTListener::decodeBuffer(const char* _str, size_t _len, std::array<double, MAX_FIELDS>& _fields)
 {
-    std::vector<float> vec;   
-    std::stringstream ss(_str);
-    std::string value_str;
-    char delimiter{','};     
-    while(!ss.eof())
+    //parsed in place, no intermediate strings or streams per message
+    const char* ptr{_str};
+    const char* last{_str+_len};
+    //publishers may terminate the text with a newline or a null character
+    while(last>ptr && (last[-1]=='\0' || last[-1]=='\n' || last[-1]=='\r' || last[-1]==' ')) --last;
+
+    size_t count{0};
+    while(ptr<last)
     {
-        getline(ss, value_str, delimiter);
-        vec.push_back(stof(value_str));       
+        if(count==MAX_FIELDS) return 0;
+        while(ptr<last && *ptr==' ') ++ptr;
+        auto [end, ec] = std::from_chars(ptr, last, _fields[count]);
+        if(ec!=std::errc()) return 0;
+        //nan and inf parse fine but would poison the filter state for good, and so would
+        //values beyond the float range of the sample; the comparison is false for nan
+        if(!(std::fabs(_fields[count])<=std::numeric_limits<float>::max())) return 0;
+        ++count;
+        ptr = end;
+        while(ptr<last && *ptr==' ') ++ptr;
+        if(ptr==last) break;
+        if(*ptr++!=',') return 0;
     }
-    
-    return glm::vec3(vec[0],
-                        vec[1],
-                        vec[2]);
+    return count;
 }
 
-bool MQTTListener::data_handler(const mqtt::message& msg, glm::vec3& angles)
+uint32_t MQTTListener::sensorId(std::string_view topic)
 {
-    const auto now {std::chrono::system_clock::now()};
-    const auto t_c = std::chrono::system_clock::to_time_t(now);
+    auto it = sensor_ids.find(topic);
+    if(it!=sensor_ids.end()) return it->second;
+    //shards number their sensors in steps of the shard count, so ids stay unique across shards
+    const uint32_t id{static_cast<uint32_t>(sensor_ids.size())*shard_count+shard_index};
+    it = sensor_ids.emplace(std::string(topic), id).first;
+    {
+        std::lock_guard<std::mutex> lock{topics_mx};
+        sensor_topics.emplace_back(topic);
+    }
+    spdlog::info("New sensor {} on topic {}", it->second, topic);
+    return it->second;
+}
 
-    mqtt::binary payload = msg.get_payload();
+bool MQTTListener::decodeSample(const char* line, size_t len, Sample& sample)
+{
+    //payload layouts: "gx,gy,gz" stamped on arrival, or stamped by the sensor
+    //"t,gx,gy,gz", "t,gx,gy,gz,ax,ay,az" and "t,gx,gy,gz,ax,ay,az,mx,my,mz"
+    std::array<double, MAX_FIELDS> fields;
+    const size_t count{decodeBuffer(line, len, fields)};
+    sample.accel = glm::vec3(0.0f);
+    sample.mag = glm::vec3(0.0f);
+    if(count==3)
+    {
+        sample.value = glm::vec3(fields[0], fields[1], fields[2]);
+        sample.axes = 3;
+    }
+    else if(count==4 || count==7 || count==10)
+    {
+        sample.timestamp = fields[0];
+        sample.value = glm::vec3(fields[1], fields[2], fields[3]);
+        sample.axes = static_cast<uint8_t>(count-1);
+        if(count>=7) sample.accel = glm::vec3(fields[4], fields[5], fields[6]);
+        if(count==10) sample.mag = glm::vec3(fields[7], fields[8], fields[9]);
+    }
+    else
+    {
+        spdlog::error("MQTTListener::data_handler: Input is not suitable for the vector format!");
+        return false;
+    }
+    spdlog::debug("INPUT: {},{},{}", sample.value[0],
+                                     sample.value[1],
+                                     sample.value[2]);
+    return true;
+}
+
+bool MQTTListener::data_handler(const SpillBuffer::Record& record, SampleQueue& queue, FusionStage& fusion)
+{
+    //stamped by the transport callback, time spent in the spill buffer counts as latency
+    const double arrival{record.arrival};
+    //unstamped samples get the wall clock time of their arrival, so recordings and exports
+    //carry real dates; arrival stays on the steady clock for latencies and idle timeouts
+    const double stamp{arrival+(wallSeconds()-steadySeconds())};
+    const uint32_t sensor{sensorId(record.topic)};
+
+    const std::string_view payload{record.payload};
     
     if(payload.empty()) 
     {
@@ -127,21 +213,250 @@ bool MQTTListener::data_handler(const mqtt::message& msg, glm::vec3& angles)
       return false;      
     } 
 
-    const char* input = payload.c_str();
-    
+    uint32_t seq{record.seq};
+    const bool sequenced{record.has_seq};
+    const uint32_t local{sensor/shard_count};
+    if(sequenced && local>=sequences.size()) sequences.resize(local+1);
+
+    //a batched message carries one sample per line, numbered from seq on
+    const char* line{payload.data()};
+    const char* const end{line+payload.size()};
+    while(line<end)
+    {
+        const char* eol{static_cast<const char*>(std::memchr(line, '\n', end-line))};
+        if(!eol) eol = end;
+        const bool blank{std::all_of(line, eol, [](char c){return c==' ' || c=='\r' || c=='\0';})};
+        Sample sample;
+        sample.arrival = arrival;
+        sample.timestamp = stamp;
+        sample.sensor = sensor;
+        if(!blank && decodeSample(line, eol-line, sample))
+        {
+            if(!sequenced)
+            {
+                deliver(sample, queue, fusion);
+            }
+            else
+            {
+                //fusion has to see the samples in publisher order, so it runs on release
+                sequences[local].accept(seq, record.epoch, sample, [&](const Sample& _released){
+                    Sample released{_released};
+                    deliver(released, queue, fusion);
+                });
+            }
+        }
+        if(sequenced && !blank) ++seq;
+        line = eol+1;
+    }
+    return true;
+}
+
+void MQTTListener::deliver(Sample& sample, SampleQueue& queue, FusionStage& fusion)
+{
+    //the queue and filter states of a shard are indexed by its local sensor id,
+    //ShardedIngest::drain translates back to the global one
+    const uint32_t sensor{sample.sensor};
+    const uint32_t local{sensor/shard_count};
+    sample.sensor = local;
+    sample.orientation = fusion.process(sample);
+    queue.push(sample);
+    sample.sensor = sensor;
+    if(result_prefix.empty()) return;
+    if(local>=results.size()) results.resize(local+1);
+    std::string& lines{results[local]};
+    if(!lines.empty()) lines.push_back('\n');
+    fmt::format_to(std::back_inserter(lines), "{:.6f},{:.6f},{:.6f},{:.6f},{:.6f}", sample.timestamp,
+                sample.orientation.w, sample.orientation.x, sample.orientation.y, sample.orientation.z);
+}
+
+bool MQTTListener::sequenceNumber(const mqtt::message& msg, uint32_t& seq, uint32_t& epoch)
+{
+    const mqtt::properties& props{msg.get_properties()};
+    const size_t count{props.count(mqtt::property::USER_PROPERTY)};
+    bool found{false};
+    epoch = 0;
+    for(size_t i=0; i<count; ++i)
+    {
+        const auto [key, value] = mqtt::get<mqtt::string_pair>(props.get(mqtt::property::USER_PROPERTY, i));
+        if(key!="seq" && key!="epoch") continue;
+        uint32_t number;
+        const char* last{value.data()+value.size()};
+        auto [end, ec] = std::from_chars(value.data(), last, number);
+        if(ec!=std::errc() || end!=last) return false;
+        if(key=="seq")
+        {
+            seq = number;
+            found = true;
+        }
+        else epoch = number;
+    }
+    return found;
+}
+
+void MQTTListener::expireSequences(double now, SampleQueue& queue, FusionStage& fusion)
+{
+    for(SequenceTracker& tracker : sequences)
+    {
+        tracker.expire(now, [&](const Sample& _released){
+            Sample released{_released};
+            deliver(released, queue, fusion);
+        });
+    }
+}
+
+void MQTTListener::logSequenceStats(double now)
+{
+    //cumulative counters, reported only for sensors that saw loss or disorder
+    if(now-stats_time<STATS_INTERVAL) return;
+    stats_time = now;
+    const SpillBuffer::Stats spilled{spill.getStats()};
+    if(spilled.rejected!=spill_rejected)
+    {
+        spdlog::warn("Spill buffer full: {} messages rejected, peak {} of {} KiB",
+                    spilled.rejected-spill_rejected, spilled.peak>>10, spill.capacity()>>10);
+        spill_rejected = spilled.rejected;
+    }
+    for(size_t sensor=0; sensor<sequences.size(); ++sensor)
+    {
+        const SequenceTracker::Stats& stats{sequences[sensor].getStats()};
+        if(stats.lost+stats.duplicates+stats.late+stats.reordered+stats.restarts==0) continue;
+        spdlog::info("Sensor {}: {} received, {} lost, {} duplicates, {} late, {} reordered, {} restarts",
+                    sensor*shard_count+shard_index, stats.received, stats.lost, stats.duplicates,
+                    stats.late, stats.reordered, stats.restarts);
+    }
+}
+
+void MQTTListener::setThrottle(ThrottleController* _throttle, const std::string& _control_prefix)
+{
+    throttle = _throttle;
+    control_prefix = _control_prefix;
+}
+
+void MQTTListener::throttleSensors(double now, const SampleQueue& queue)
+{
+    if(!throttle) return;
+    commands.clear();
+    if(!throttle->evaluate(now, queue, commands)) return;
+
+    char text[64];
+    for(const auto& [sensor, command] : commands)
+    {
+        //the queue counts the sensors of this shard by their local id
+        if(sensor>=sensor_topics.size()) continue;
+        const size_t length{formatCommand(command, text, sizeof(text))};
+        const std::string control_topic{control_prefix+"/"+sensor_topics[sensor]};
+        try
+        {
+            reconnect.publish(mqtt::make_message(control_topic, std::string(text, length), 1, false));
+        }
+        catch(const mqtt::exception& e)
+        {
+            spdlog::warn("MQTTListener::throttleSensors: {} not sent: {}", control_topic, e.what());
+            continue;
+        }
+        //renewals are not worth a log line
+        if(sensor>=throttled.size()) throttled.resize(sensor+1, ThrottleCommand{ThrottleCommand::RESUME, 1, 0.0});
+        const bool changed{throttled[sensor].mode!=command.mode || throttled[sensor].factor!=command.factor};
+        throttled[sensor] = command;
+        if(!changed) continue;
+        if(command.mode==ThrottleCommand::RESUME)
+        {
+            spdlog::info("Sensor {} resumed full rate", sensor*shard_count+shard_index);
+        }
+        else
+        {
+            spdlog::info("Sensor {} throttled: {} x{} (listener busy {:.0f}%)", sensor*shard_count+shard_index,
+                        command.mode==ThrottleCommand::RATE ? "rate" : "batch",
+                        command.factor, 100.0*throttle->cpuLoad());
+        }
+    }
+}
+
+void MQTTListener::addTopic(const std::string& _topic_name)
+{
+    topic_names.push_back(_topic_name);
+}
+
+void MQTTListener::setShard(uint32_t _index, uint32_t _count, int _core)
+{
+    shard_index = _index;
+    shard_count = std::max(1u, _count);
+    core = _core;
+}
+
+void MQTTListener::stop()
+{
+    stopping = true;
+    cv.notify_all();
+    reconnect.stop();
+}
+
+bool MQTTListener::pinThread(int _core)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(_core, &cpus);
+    const int error{pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)};
+    if(error!=0)
+    {
+        spdlog::warn("MQTTListener: Could not pin the ingest thread to core {}: {}", _core, std::strerror(error));
+        return false;
+    }
+    return true;
+}
+
+void MQTTListener::setShareGroup(const std::string& _group)
+{
+    share_group = _group;
+}
+
+void MQTTListener::setResultTopic(const std::string& _result_prefix)
+{
+    result_prefix = _result_prefix;
+}
+
+bool MQTTListener::sensorTopic(uint32_t sensor, std::string& topic)
+{
+    std::lock_guard<std::mutex> lock{topics_mx};
+    const uint32_t local{sensor/shard_count};
+    if(sensor%shard_count!=shard_index || local>=sensor_topics.size()) return false;
+    topic = sensor_topics[local];
+    return true;
+}
+
+bool MQTTListener::publishSensor(uint32_t sensor, const std::string& prefix, const std::string& payload)
+{
+    std::string topic;
+    if(!sensorTopic(sensor, topic)) return false;
+    topic = prefix+"/"+topic;
     try
     {
-        angles = decodeBuffer(input);
-        spdlog::info("INPUT: {},{},{}", angles[0],
-                                        angles[1],
-                                        angles[2]);
-        
+        reconnect.publish(mqtt::make_message(topic, payload, 0, false));
     }
-    catch(const std::exception e)    
+    catch(const mqtt::exception& e)
     {
-       spdlog::error("MQTTListener::data_handler: Input is not suitable for the vector format!");
+        spdlog::warn("MQTTListener::publishSensor: {} dropped: {}", topic, e.what());
+        return false;
     }
- 
-    
     return true;
 }
+
+void MQTTListener::publishResults(double now)
+{
+    //one message per sensor and interval, the same newline separated layout publishers batch with
+    if(result_prefix.empty() || now-result_time<RESULT_INTERVAL) return;
+    result_time = now;
+    for(size_t sensor=0; sensor<results.size(); ++sensor)
+    {
+        if(results[sensor].empty()) continue;
+        try
+        {
+            reconnect.publish(mqtt::make_message(result_prefix+"/"+sensor_topics[sensor], results[sensor], 0, false));
+        }
+        catch(const mqtt::exception& e)
+        {
+            spdlog::warn("MQTTListener::publishResults: {} results dropped: {}", sensor_topics[sensor], e.what());
+        }
+        results[sensor].clear();
+    }
+}
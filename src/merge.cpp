@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <limits>
+#include "merge.hpp"
+
+//key of a leaf whose source has nothing waiting
+static constexpr double EMPTY{std::numeric_limits<double>::infinity()};
+
+
+WatermarkMerge::WatermarkMerge(double _lateness, double _idle):lateness{_lateness},
+                                                                idle{_idle},
+                                                                leaves{0},
+                                                                newest{-EMPTY},
+                                                                released{-EMPTY},
+                                                                stats{0, 0, 0, -EMPTY}
+{
+}
+
+void WatermarkMerge::push(const Sample& sample)
+{
+    if(sample.sensor>=sources.size()) addSources(sample.sensor+1);
+    Source& source{sources[sample.sensor]};
+    //older than what was released, or out of order within its own stream
+    if(sample.timestamp<released || sample.timestamp<source.newest)
+    {
+        ++stats.late;
+        return;
+    }
+    if(source.count==source.ring.size())
+    {
+        //doubles, so a source stops allocating once it reached its burst size
+        std::vector<Sample> ring(std::max<size_t>(16, 2*source.ring.size()));
+        for(size_t i=0; i<source.count; ++i) ring[i] = source.ring[(source.head+i)&(source.ring.size()-1)];
+        source.ring.swap(ring);
+        source.head = 0;
+    }
+    source.ring[(source.head+source.count)&(source.ring.size()-1)] = sample;
+    source.newest = sample.timestamp;
+    source.arrival = sample.arrival;
+    newest = std::max(newest, sample.timestamp);
+    ++stats.waiting;
+    //only a new head changes the tree
+    if(++source.count==1) update(sample.sensor);
+}
+
+size_t WatermarkMerge::pop(double now, std::vector<Sample>& out)
+{
+    //the slowest active source bounds what can be released
+    double watermark{EMPTY};
+    for(const Source& source : sources)
+    {
+        if(source.newest==-EMPTY || now-source.arrival>idle) continue;
+        watermark = std::min(watermark, source.newest);
+    }
+    //unless it lags the others by more than the lateness
+    watermark = std::max(watermark==EMPTY ? newest : watermark, newest-lateness);
+    return release(watermark, out);
+}
+
+size_t WatermarkMerge::flush(std::vector<Sample>& out)
+{
+    return release(EMPTY, out);
+}
+
+WatermarkMerge::Stats WatermarkMerge::getStats() const
+{
+    return stats;
+}
+
+void WatermarkMerge::addSources(uint32_t count)
+{
+    sources.resize(count, Source{{}, 0, 0, -EMPTY, 0.0});
+    if(count<=leaves) return;
+    uint32_t size{std::max(leaves, 1u)};
+    while(size<count) size *= 2;
+    leaves = size;
+    keys.assign(leaves, EMPTY);
+    tree.assign(2*leaves, 0);
+    for(uint32_t i=0; i<leaves; ++i) tree[leaves+i] = i;
+    for(uint32_t i=0; i<sources.size(); ++i)
+    {
+        if(sources[i].count) keys[i] = sources[i].ring[sources[i].head].timestamp;
+    }
+    for(uint32_t node=leaves-1; node>=1; --node)
+    {
+        const uint32_t left{tree[2*node]}, right{tree[2*node+1]};
+        tree[node] = keys[left]<=keys[right] ? left : right;
+    }
+}
+
+void WatermarkMerge::update(uint32_t index)
+{
+    const Source& source{sources[index]};
+    keys[index] = source.count ? source.ring[source.head].timestamp : EMPTY;
+    //one leaf only: tree[1] is the leaf itself
+    for(uint32_t node=(leaves+index)/2; node>=1; node/=2)
+    {
+        const uint32_t left{tree[2*node]}, right{tree[2*node+1]};
+        tree[node] = keys[left]<=keys[right] ? left : right;
+    }
+}
+
+size_t WatermarkMerge::release(double watermark, std::vector<Sample>& out)
+{
+    size_t count{0};
+    while(leaves)
+    {
+        const uint32_t index{tree[1]};
+        const double key{keys[index]};
+        if(key==EMPTY || key>watermark) break;
+        Source& source{sources[index]};
+        out.push_back(source.ring[source.head]);
+        released = key;
+        source.head = (source.head+1)&(source.ring.size()-1);
+        --source.count;
+        update(index);
+        ++count;
+    }
+    stats.merged += count;
+    stats.waiting -= count;
+    stats.watermark = released;
+    return count;
+}
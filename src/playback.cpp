@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include "playback.hpp"
+#include "spdlog/spdlog.h"
+
+static constexpr double INF{std::numeric_limits<double>::infinity()};
+
+static bool earlier(const Sample& a, const Sample& b)
+{
+    return a.timestamp<b.timestamp;
+}
+
+static bool before(const Sample& s, double t)
+{
+    return s.timestamp<t;
+}
+
+static bool after(double t, const Sample& s)
+{
+    return t<s.timestamp;
+}
+
+
+Playback::Playback(const std::string& _directory, double _behind, float _beta):query{_directory},
+                                                                            directory{_directory},
+                                                                            behind{_behind},
+                                                                            beta{_beta},
+                                                                            first{INF},
+                                                                            last{-INF},
+                                                                            cursor{0.0},
+                                                                            running{false}
+{
+}
+
+Playback::~Playback()
+{
+    {
+        std::lock_guard<std::mutex> lock{mx};
+        running = false;
+    }
+    wake.notify_one();
+    if(thread.joinable()) thread.join();
+}
+
+bool Playback::open()
+{
+    if(!query.open()) return false;
+    topics = query.topics();
+    if(topics.empty())
+    {
+        spdlog::error("Playback: Nothing recorded in {}", directory);
+        return false;
+    }
+    for(const std::string& topic : topics)
+    {
+        first = std::min(first, query.find(topic)->begin());
+        last = std::max(last, query.find(topic)->end());
+    }
+    //whole seconds, so the overview comes from the index rollups without decoding
+    const double resolution{std::max(IndexedSeries::ROLLUP,
+                                    std::ceil((last-first)/static_cast<double>(OVERVIEW_COLUMNS)))};
+    overviews.resize(topics.size());
+    for(size_t k=0; k<topics.size(); ++k)
+    {
+        query.buckets(topics[k], first, last, resolution, overviews[k]);
+    }
+    spdlog::info("Playback: {} sensors over {:.1f} s", topics.size(), last-first);
+
+    cursor = first;
+    running = true;
+    thread = std::thread(&Playback::prefetch, this);
+    return true;
+}
+
+void Playback::seek(double t)
+{
+    std::lock_guard<std::mutex> lock{mx};
+    cursor = std::clamp(t, first, last);
+    if(stale(cursor)) wake.notify_one();
+}
+
+double Playback::position() const
+{
+    std::lock_guard<std::mutex> lock{mx};
+    return cursor;
+}
+
+std::shared_ptr<const Playback::Chunk> Playback::current() const
+{
+    std::lock_guard<std::mutex> lock{mx};
+    return chunk;
+}
+
+bool Playback::stale(double target) const
+{
+    if(!chunk) return true;
+    //reloaded before the cursor runs out of samples on either side, not at the ends of the recording
+    const bool short_behind{chunk->from>first && target-behind<chunk->from};
+    const bool short_ahead{chunk->to<last && target+0.5*PREFETCH_AHEAD>chunk->to};
+    return short_behind || short_ahead;
+}
+
+void Playback::prefetch()
+{
+    std::unique_lock<std::mutex> lock{mx};
+    while(true)
+    {
+        wake.wait(lock, [this]{return !running || stale(cursor);});
+        if(!running) break;
+        const double target{cursor};
+        std::shared_ptr<const Chunk> previous{chunk};
+        lock.unlock();
+        auto loaded{std::make_shared<Chunk>()};
+        load(target, previous.get(), *loaded);
+        std::shared_ptr<const Chunk> swapped{loaded};
+        lock.lock();
+        chunk.swap(swapped);
+        lock.unlock();
+        //the replaced chunk is freed outside the lock, the renderer may be waiting for it
+        swapped.reset();
+        previous.reset();
+        lock.lock();
+    }
+}
+
+void Playback::load(double target, const Chunk* previous, Chunk& out)
+{
+    out.from = std::max(first, target-behind);
+    out.to = std::min(last, target+PREFETCH_AHEAD);
+    out.sensors.resize(topics.size());
+    for(size_t k=0; k<topics.size(); ++k)
+    {
+        AhrsState state{1.0f, 0.0f, 0.0f, 0.0f, 0.0, false};
+        double start{out.from-WARMUP};
+        //continuing the previous chunk: its filter state at the new start replaces the warmup
+        if(previous && previous->from<=out.from && previous->to>=out.from)
+        {
+            const std::vector<Sample>& fused{previous->sensors[k]};
+            const auto it{std::upper_bound(fused.begin(), fused.end(), out.from, after)};
+            if(it!=fused.begin())
+            {
+                const Sample& s{*std::prev(it)};
+                state = AhrsState{s.orientation.w, s.orientation.x, s.orientation.y, s.orientation.z,
+                                s.timestamp, true};
+                start = s.timestamp;
+            }
+        }
+        scratch.clear();
+        query.samples(topics[k], start, out.to, scratch);
+        //runs with overlapping clocks come back in segment order
+        if(!std::is_sorted(scratch.begin(), scratch.end(), earlier))
+        {
+            std::stable_sort(scratch.begin(), scratch.end(), earlier);
+        }
+        std::vector<Sample>& fused{out.sensors[k]};
+        fused.clear();
+        fused.reserve(scratch.size());
+        for(Sample& s : scratch)
+        {
+            FusionStage::update(state, s, beta);
+            if(s.timestamp<out.from) continue;
+            s.sensor = static_cast<uint32_t>(k);
+            s.orientation = glm::quat(state.q0, state.q1, state.q2, state.q3);
+            fused.push_back(s);
+        }
+    }
+}
+
+bool Playback::orientation(uint32_t sensor, double t, glm::quat& q) const
+{
+    const std::shared_ptr<const Chunk> loaded{current()};
+    if(!loaded || sensor>=loaded->sensors.size() || t<loaded->from || t>loaded->to) return false;
+    const std::vector<Sample>& fused{loaded->sensors[sensor]};
+    if(fused.empty()) return false;
+    const auto it{std::lower_bound(fused.begin(), fused.end(), t, before)};
+    if(it==fused.begin()) q = fused.front().orientation;
+    else if(it==fused.end()) q = fused.back().orientation;
+    else
+    {
+        const Sample& a{*std::prev(it)};
+        const Sample& b{*it};
+        const double span{b.timestamp-a.timestamp};
+        q = glm::slerp(a.orientation, b.orientation, span>0.0 ? static_cast<float>((t-a.timestamp)/span) : 1.0f);
+    }
+    return true;
+}
+
+bool Playback::samples(uint32_t sensor, double from, double to, std::vector<Sample>& out) const
+{
+    const std::shared_ptr<const Chunk> loaded{current()};
+    if(!loaded || sensor>=loaded->sensors.size()) return false;
+    if((from<loaded->from && loaded->from>first) || (to>loaded->to && loaded->to<last)) return false;
+    const std::vector<Sample>& fused{loaded->sensors[sensor]};
+    out.insert(out.end(), std::upper_bound(fused.begin(), fused.end(), from, after),
+                std::upper_bound(fused.begin(), fused.end(), to, after));
+    return true;
+}
@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <cxxopts.hpp>
+#include "spdlog/spdlog.h"
+#include "synthetic.hpp"
+
+//synthetic sensor for testing the subscriber without hardware
+//usage: sensor_mqtt_publisher --topic coords/imu0 --rate 200 --axes 6
+//       sensor_mqtt_publisher --mode steps --step_interval 0.5 --step_angle 30
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options{"publisher", "Publishes synthetic sensor samples"};
+    options.add_options()
+    ("t, type", "type of the MQTT connection, i.e tcp, ssl, ws, wsl",
+    cxxopts::value<std::string>()->default_value("tcp"))
+    ("server", "IP address of the broker",
+    cxxopts::value<std::string>()->default_value("127.0.0.1"))
+    ("server_port", "port number of the broker",
+    cxxopts::value<uint16_t>()->default_value("1883"))
+    ("q, qos", "Quality of service level",
+    cxxopts::value<uint8_t>()->default_value("0"))
+    ("topic", "topic the samples are published on",
+    cxxopts::value<std::string>()->default_value("coords"))
+    ("client_id", "name of the client project",
+    cxxopts::value<std::string>()->default_value("sensor_publisher"))
+    ("mode", "motion or steps",
+    cxxopts::value<std::string>()->default_value("motion"))
+    ("rate", "samples per second",
+    cxxopts::value<double>()->default_value("100"))
+    ("axes", "3, 6 or 9 fields after the timestamp (motion mode only)",
+    cxxopts::value<uint16_t>()->default_value("3"))
+    ("count", "number of samples to publish, 0 runs forever",
+    cxxopts::value<uint64_t>()->default_value("0"))
+    ("step_interval", "seconds between two steps",
+    cxxopts::value<double>()->default_value("0.5"))
+    ("step_angle", "rotation per step in degrees",
+    cxxopts::value<float>()->default_value("30"))
+    ("control_topic", "prefix of the topic throttle requests arrive on, empty to ignore them",
+    cxxopts::value<std::string>()->default_value("control"))
+    ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if(result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    const std::string mode_name{result["mode"].as<std::string>()};
+    const uint16_t axes{result["axes"].as<uint16_t>()};
+    const double rate{result["rate"].as<double>()};
+    if((mode_name!="motion" && mode_name!="steps") || (axes!=3 && axes!=6 && axes!=9) || rate<=0.0)
+    {
+        std::cout << options.help() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string server{result["type"].as<std::string>()+"://"+
+                            result["server"].as<std::string>()+":"+
+                            std::to_string(result["server_port"].as<uint16_t>())};
+    SyntheticPublisher publisher{server,
+                                result["client_id"].as<std::string>(),
+                                result["topic"].as<std::string>(),
+                                result["qos"].as<uint8_t>()};
+    publisher.setStep(result["step_interval"].as<double>(), result["step_angle"].as<float>());
+    if(!result["control_topic"].as<std::string>().empty())
+    {
+        publisher.setControlTopic(result["control_topic"].as<std::string>());
+    }
+    if(!publisher.connect()) return EXIT_FAILURE;
+
+    publisher.run(mode_name=="steps" ? SyntheticPublisher::STEPS : SyntheticPublisher::MOTION,
+                rate, static_cast<uint8_t>(axes), result["count"].as<uint64_t>());
+    return EXIT_SUCCESS;
+}
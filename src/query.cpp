@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+#include "query.hpp"
+#include "spdlog/spdlog.h"
+
+static constexpr double INF{std::numeric_limits<double>::infinity()};
+
+//most intervals a resolution query may ask for
+static constexpr size_t MAX_BUCKETS{size_t{1}<<26};
+
+namespace{
+    struct IndexHeader{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entry_size;    //guard against a changed layout
+        uint32_t rollup_size;
+        uint64_t indexed_bytes; //of the series file covered by the entries
+        uint64_t count;
+        uint64_t rollup_count;  //rollups follow the entries
+    };
+
+    //running min, max and sum of one interval
+    struct Accumulator{
+        glm::vec3 min;
+        glm::vec3 max;
+        std::array<double, 3> sum;
+        uint32_t count;
+    };
+
+    void fold(Accumulator& a, const glm::vec3& min, const glm::vec3& max, const double* sum, uint32_t count)
+    {
+        if(!count) return;
+        a.min = a.count ? glm::min(a.min, min) : min;
+        a.max = a.count ? glm::max(a.max, max) : max;
+        for(size_t c=0; c<3; ++c) a.sum[c] += sum[c];
+        a.count += count;
+    }
+
+    void fold(Accumulator& a, const IndexedSeries::Summary& summary)
+    {
+        fold(a, summary.min, summary.max, summary.sum, summary.count);
+    }
+
+    void add(IndexedSeries::Summary& summary, const glm::vec3& value)
+    {
+        summary.min = summary.count ? glm::min(summary.min, value) : value;
+        summary.max = summary.count ? glm::max(summary.max, value) : value;
+        for(int c=0; c<3; ++c) summary.sum[c] += value[c];
+        ++summary.count;
+    }
+}
+
+
+bool IndexedSeries::open(const std::string& path)
+{
+    file_path = path;
+    entries.clear();
+    rollups.clear();
+    if(!reader.map(path)) return false;
+    size_t indexed{reader.dataOffset()};
+    if(!load(indexed))
+    {
+        entries.clear();
+        rollups.clear();
+        indexed = reader.dataOffset();
+    }
+
+    //segments appended since the index was written are summarized once
+    const size_t end{reader.scan(indexed)};
+    std::vector<Sample> decoded;
+    for(const SeriesReader::Segment& segment : reader.segments())
+    {
+        decoded.clear();
+        reader.decode(segment, decoded);
+        Entry entry{segment.offset, segment.t_min, segment.t_max, segment.axes, {0, 0, 0}, 0, rollups.size(),
+                    Summary{glm::vec3(0.0f), glm::vec3(0.0f), {0.0, 0.0, 0.0}, 0}};
+        double second{-INF};
+        for(const Sample& s : decoded)
+        {
+            add(entry.summary, s.value);
+            //samples arrive in time order, a new second starts a new rollup
+            const double start{std::floor(s.timestamp/ROLLUP)*ROLLUP};
+            if(start!=second)
+            {
+                rollups.push_back(Rollup{start, Summary{s.value, s.value, {0.0, 0.0, 0.0}, 0}});
+                ++entry.rollup_count;
+                second = start;
+            }
+            add(rollups.back().summary, s.value);
+        }
+        entries.push_back(entry);
+    }
+    if(!reader.segments().empty() || end!=indexed) save(end);
+    sort();
+    samples = 0;
+    for(const Entry& entry : entries) samples += entry.summary.count;
+    return true;
+}
+
+bool IndexedSeries::load(size_t& indexed_bytes)
+{
+    std::FILE* file{std::fopen((file_path+".idx").c_str(), "rb")};
+    if(!file) return false;
+    IndexHeader header;
+    bool valid{std::fread(&header, sizeof(header), 1, file)==1 && header.magic==INDEX_MAGIC &&
+                header.version==INDEX_VERSION && header.entry_size==sizeof(Entry) &&
+                header.rollup_size==sizeof(Rollup) &&
+                header.indexed_bytes>=reader.dataOffset() && header.indexed_bytes<=reader.fileSize()};
+    if(valid)
+    {
+        entries.resize(header.count);
+        rollups.resize(header.rollup_count);
+        valid = std::fread(entries.data(), sizeof(Entry), entries.size(), file)==entries.size() &&
+                std::fread(rollups.data(), sizeof(Rollup), rollups.size(), file)==rollups.size();
+    }
+    std::fclose(file);
+    if(!valid)
+    {
+        spdlog::warn("IndexedSeries: index of {} is stale, rebuilding", file_path);
+        return false;
+    }
+    indexed_bytes = header.indexed_bytes;
+    return true;
+}
+
+void IndexedSeries::save(size_t indexed_bytes) const
+{
+    //written aside and renamed, a reader never sees a half written index
+    const std::string path{file_path+".idx"};
+    const std::string temporary{path+".tmp"};
+    std::FILE* file{std::fopen(temporary.c_str(), "wb")};
+    if(!file)
+    {
+        spdlog::warn("IndexedSeries: Could not write {}: {}", path, std::strerror(errno));
+        return;
+    }
+    const IndexHeader header{INDEX_MAGIC, INDEX_VERSION, sizeof(Entry), sizeof(Rollup), indexed_bytes,
+                            entries.size(), rollups.size()};
+    const bool written{std::fwrite(&header, sizeof(header), 1, file)==1 &&
+                        std::fwrite(entries.data(), sizeof(Entry), entries.size(), file)==entries.size() &&
+                        std::fwrite(rollups.data(), sizeof(Rollup), rollups.size(), file)==rollups.size()};
+    if(std::fclose(file)!=0 || !written || std::rename(temporary.c_str(), path.c_str())!=0)
+    {
+        spdlog::warn("IndexedSeries: Could not write {}: {}", path, std::strerror(errno));
+        std::remove(temporary.c_str());
+    }
+}
+
+void IndexedSeries::sort()
+{
+    order.resize(entries.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                    [this](uint32_t a, uint32_t b){return entries[a].t_min<entries[b].t_min;});
+    reach.resize(order.size());
+    double furthest{-INF};
+    for(size_t i=0; i<order.size(); ++i)
+    {
+        furthest = std::max(furthest, entries[order[i]].t_max);
+        reach[i] = furthest;
+    }
+}
+
+double IndexedSeries::begin() const
+{
+    return order.empty() ? INF : entries[order.front()].t_min;
+}
+
+double IndexedSeries::end() const
+{
+    return reach.empty() ? -INF : reach.back();
+}
+
+void IndexedSeries::overlapping(double from, double to, std::vector<uint32_t>& out) const
+{
+    out.clear();
+    //reach is sorted, before this position every segment ended ahead of the range
+    size_t i{static_cast<size_t>(std::lower_bound(reach.begin(), reach.end(), from)-reach.begin())};
+    for(; i<order.size() && entries[order[i]].t_min<=to; ++i)
+    {
+        if(entries[order[i]].t_max>=from) out.push_back(order[i]);
+    }
+}
+
+size_t IndexedSeries::decode(uint32_t index, std::vector<Sample>& out) const
+{
+    const Entry& entry{entries[index]};
+    return reader.decode(SeriesReader::Segment{entry.offset, entry.t_min, entry.t_max, entry.summary.count,
+                                                    entry.axes}, out);
+}
+
+size_t IndexedSeries::decodeColumns(uint32_t index, const SeriesReader::Columns& out) const
+{
+    const Entry& entry{entries[index]};
+    return reader.decodeColumns(SeriesReader::Segment{entry.offset, entry.t_min, entry.t_max, entry.summary.count,
+                                                    entry.axes}, out);
+}
+
+
+SeriesQuery::SeriesQuery(const std::string& _directory):directory{_directory}, stats{0, 0, 0}
+{
+}
+
+bool SeriesQuery::open()
+{
+    std::error_code error;
+    std::filesystem::directory_iterator it{directory, error};
+    if(error)
+    {
+        spdlog::error("SeriesQuery: Could not list {}: {}", directory, error.message());
+        return false;
+    }
+    for(const std::filesystem::directory_entry& file : it)
+    {
+        if(file.path().extension()!=".gts") continue;
+        auto indexed{std::make_unique<IndexedSeries>()};
+        if(!indexed->open(file.path().string())) continue;
+        const std::string topic{indexed->topic()};
+        series[topic] = std::move(indexed);
+    }
+    return true;
+}
+
+std::vector<std::string> SeriesQuery::topics() const
+{
+    std::vector<std::string> names;
+    for(const auto& [topic, indexed] : series) names.push_back(topic);
+    return names;
+}
+
+const IndexedSeries* SeriesQuery::find(const std::string& topic) const
+{
+    const auto it{series.find(topic)};
+    return it==series.end() ? nullptr : it->second.get();
+}
+
+size_t SeriesQuery::samples(const std::string& topic, double from, double to, std::vector<Sample>& out)
+{
+    const IndexedSeries* indexed{find(topic)};
+    if(!indexed) return 0;
+    indexed->overlapping(from, to, hits);
+    const size_t before{out.size()};
+    size_t total{before};
+    for(uint32_t hit : hits) total += indexed->entry(hit).summary.count;
+    out.reserve(total);
+    for(uint32_t hit : hits)
+    {
+        const size_t first{out.size()};
+        indexed->decode(hit, out);
+        ++stats.decoded;
+        const IndexedSeries::Entry& entry{indexed->entry(hit)};
+        if(entry.t_min<from || entry.t_max>to)
+        {
+            const auto outside{std::remove_if(out.begin()+static_cast<std::ptrdiff_t>(first), out.end(),
+                                [&](const Sample& s){return s.timestamp<from || s.timestamp>to;})};
+            out.erase(outside, out.end());
+        }
+    }
+    return out.size()-before;
+}
+
+size_t SeriesQuery::buckets(const std::string& topic, double from, double to, double resolution,
+                            std::vector<Bucket>& out)
+{
+    const IndexedSeries* indexed{find(topic)};
+    if(!indexed) return 0;
+    from = std::max(from, indexed->begin());
+    to = std::min(to, indexed->end());
+    if(from>to) return 0;
+    if(resolution<=0.0)
+    {
+        scratch.clear();
+        samples(topic, from, to, scratch);
+        for(const Sample& s : scratch) out.push_back(Bucket{s.timestamp, s.value, s.value, s.value, 1});
+        return scratch.size();
+    }
+    //intervals start at whole multiples of the resolution
+    const double origin{std::floor(from/resolution)*resolution};
+    const double span{std::floor((to-origin)/resolution)+1.0};
+    if(span>static_cast<double>(MAX_BUCKETS))
+    {
+        spdlog::error("SeriesQuery: {:.0f} intervals of {} s requested, at most {}", span, resolution, MAX_BUCKETS);
+        return 0;
+    }
+    std::vector<Accumulator> grid(static_cast<size_t>(span),
+                                Accumulator{glm::vec3(0.0f), glm::vec3(0.0f), {0.0, 0.0, 0.0}, 0});
+    auto interval = [&](double t){
+        return std::min(grid.size()-1, static_cast<size_t>(std::max(0.0, std::floor((t-origin)/resolution))));
+    };
+    //every rollup then lies within one interval
+    const bool rolled{resolution>=IndexedSeries::ROLLUP &&
+                    std::fmod(resolution, IndexedSeries::ROLLUP)==0.0};
+
+    indexed->overlapping(from, to, hits);
+    for(uint32_t hit : hits)
+    {
+        const IndexedSeries::Entry& entry{indexed->entry(hit)};
+        if(entry.t_min>=from && entry.t_max<=to)
+        {
+            //inside the range and one interval: the index entry is the answer
+            if(interval(entry.t_min)==interval(entry.t_max))
+            {
+                fold(grid[interval(entry.t_min)], entry.summary);
+                ++stats.summarized;
+                continue;
+            }
+            if(rolled)
+            {
+                for(uint64_t r=entry.rollup_first; r<entry.rollup_first+entry.rollup_count; ++r)
+                {
+                    const IndexedSeries::Rollup& rollup{indexed->rollup(r)};
+                    fold(grid[interval(rollup.start)], rollup.summary);
+                }
+                ++stats.rolled;
+                continue;
+            }
+        }
+        scratch.clear();
+        indexed->decode(hit, scratch);
+        ++stats.decoded;
+        for(const Sample& s : scratch)
+        {
+            if(s.timestamp<from || s.timestamp>to) continue;
+            const double sum[3]{s.value.x, s.value.y, s.value.z};
+            fold(grid[interval(s.timestamp)], s.value, s.value, sum, 1);
+        }
+    }
+
+    const size_t before{out.size()};
+    for(size_t k=0; k<grid.size(); ++k)
+    {
+        const Accumulator& a{grid[k]};
+        if(!a.count) continue;
+        const double n{static_cast<double>(a.count)};
+        out.push_back(Bucket{origin+static_cast<double>(k)*resolution, a.min, a.max,
+                            glm::vec3(static_cast<float>(a.sum[0]/n), static_cast<float>(a.sum[1]/n),
+                                    static_cast<float>(a.sum[2]/n)),
+                            a.count});
+    }
+    return out.size()-before;
+}
+
+bool SeriesQuery::gyroOnly(const std::string& topic, double from, double to)
+{
+    const IndexedSeries* indexed{find(topic)};
+    if(!indexed) return false;
+    indexed->overlapping(from, to, hits);
+    return std::any_of(hits.begin(), hits.end(), [indexed](uint32_t hit){return indexed->entry(hit).axes<6;});
+}
+
+size_t SeriesQuery::orientations(const std::string& topic, double from, double to, double resolution,
+                                std::vector<Orientation>& out, double warmup, float beta, bool gyro_only)
+{
+    const IndexedSeries* indexed{find(topic)};
+    if(!indexed) return 0;
+    if(gyroOnly(topic, from-warmup, to))
+    {
+        if(!gyro_only)
+        {
+            spdlog::error("SeriesQuery: {} has gyro only samples in the range, its orientation would drift "
+                        "from an arbitrary start; refused without gyro_only", topic);
+            return 0;
+        }
+        spdlog::warn("SeriesQuery: {} has gyro only samples in the range, orientations are relative to "
+                    "the start of the warmup and drift", topic);
+    }
+    indexed->overlapping(from-warmup, to, hits);
+    AhrsState state{1.0f, 0.0f, 0.0f, 0.0f, 0.0, false};
+    const size_t before{out.size()};
+    int64_t last_interval{-1};
+    for(uint32_t hit : hits)
+    {
+        scratch.clear();
+        indexed->decode(hit, scratch);
+        ++stats.decoded;
+        for(const Sample& s : scratch)
+        {
+            if(s.timestamp<from-warmup || s.timestamp>to) continue;
+            FusionStage::update(state, s, beta);
+            if(s.timestamp<from) continue;
+            const Orientation current{s.timestamp, glm::quat(state.q0, state.q1, state.q2, state.q3)};
+            //one orientation per interval: the last one inside it
+            const int64_t k{resolution>0.0 ? static_cast<int64_t>(std::floor((s.timestamp-from)/resolution)) : -1};
+            if(resolution>0.0 && k==last_interval && out.size()>before) out.back() = current;
+            else out.push_back(current);
+            last_interval = k;
+        }
+    }
+    return out.size()-before;
+}
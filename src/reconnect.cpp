@@ -0,0 +1,472 @@
+#include <algorithm>
+#include <limits>
+#include "reconnect.hpp"
+#include "spdlog/spdlog.h"
+
+using namespace std::chrono_literals;
+
+
+ReconnectManager::ReconnectManager(const std::vector<std::string>& _servers,
+                                const std::string& _client_id,
+                                uint32_t _session_expiry):
+                                                    options{mqtt::connect_options_builder()
+                                                            .mqtt_version(MQTTVERSION_5)
+                                                            .keep_alive_interval(20s)
+                                                            .connect_timeout(CONNECT_TIMEOUT)
+                                                            .clean_start(false)
+                                                            .properties(mqtt::properties{
+                                                                {mqtt::property::SESSION_EXPIRY_INTERVAL,
+                                                                static_cast<int>(_session_expiry)}})
+                                                            .automatic_reconnect(false)
+                                                            .finalize()},
+                                                    standby_options{mqtt::connect_options_builder()
+                                                            .mqtt_version(MQTTVERSION_5)
+                                                            .keep_alive_interval(20s)
+                                                            .connect_timeout(CONNECT_TIMEOUT)
+                                                            .clean_start(true)
+                                                            .properties(mqtt::properties{
+                                                                {mqtt::property::SESSION_EXPIRY_INTERVAL,
+                                                                static_cast<int>(_session_expiry)}})
+                                                            .automatic_reconnect(false)
+                                                            .finalize()},
+                                                    probe_filter{_client_id+"/probe"},
+                                                    active{0},
+                                                    lost{false},
+                                                    stopping{false},
+                                                    stats{}
+{
+    for(const std::string& server : _servers)
+    {
+        //the same client id on every broker, each keeps its own session
+        links.push_back(Link{server,
+                            std::make_unique<mqtt::async_client>(server, _client_id,
+                                                                mqtt::create_options(MQTTVERSION_5)),
+                            false,
+                            nullptr,
+                            -1.0,
+                            0,
+                            std::chrono::steady_clock::time_point{},
+                            MIN_BACKOFF,
+                            std::chrono::steady_clock::time_point{}});
+    }
+    for(size_t i=0; i<links.size(); ++i)
+    {
+        links[i].cli->set_connection_lost_handler([this, i](const std::string& cause){
+            down(i, cause);
+        });
+        //MQTT v5 brokers announce a shutdown with a DISCONNECT packet instead of dropping the socket
+        links[i].cli->set_disconnected_handler([this, i](const mqtt::properties&, auto reason){
+            down(i, "disconnected by the broker, reason code "+std::to_string(static_cast<int>(reason)));
+        });
+    }
+}
+
+ReconnectManager::~ReconnectManager()
+{
+    stop();
+}
+
+void ReconnectManager::addTopic(const std::string& topic, int topic_qos)
+{
+    std::lock_guard<std::mutex> lc_{mx};
+    topics.push_back(topic);
+    qos.push_back(topic_qos);
+}
+
+void ReconnectManager::setMessageCallback(MessageHandler handler)
+{
+    for(Link& link : links) link.cli->set_message_callback(handler);
+}
+
+bool ReconnectManager::connect()
+{
+    auto backoff{MIN_BACKOFF};
+    while(!connectAll())
+    {
+        std::unique_lock<std::mutex> lc_{mx};
+        if(cv.wait_for(lc_, backoff, [&](){return stopping;})) return false;
+        backoff = std::min(backoff*2, MAX_BACKOFF);
+    }
+    //stop() may have run meanwhile, it must not miss the worker
+    std::lock_guard<std::mutex> lc_{mx};
+    if(stopping) return false;
+    worker = std::thread{&ReconnectManager::loop, this};
+    return true;
+}
+
+void ReconnectManager::stop()
+{
+    {
+        std::lock_guard<std::mutex> lc_{mx};
+        stopping = true;
+    }
+    cv.notify_one();
+    if(worker.joinable()) worker.join();
+    for(Link& link : links)
+    {
+        try
+        {
+            if(link.cli->is_connected()) link.cli->disconnect()->wait_for(CONNECT_TIMEOUT);
+        }
+        catch(const mqtt::exception&) {}
+    }
+}
+
+mqtt::delivery_token_ptr ReconnectManager::publish(mqtt::message_ptr msg)
+{
+    size_t current;
+    {
+        std::lock_guard<std::mutex> lc_{mx};
+        current = active;
+    }
+    return links[current].cli->publish(msg);
+}
+
+ReconnectManager::Stats ReconnectManager::getStats() const
+{
+    std::lock_guard<std::mutex> lc_{mx};
+    return stats;
+}
+
+bool ReconnectManager::connectAll()
+{
+    //every broker at once, so an unreachable one costs one timeout and not one each
+    std::vector<mqtt::token_ptr> tokens(links.size());
+    for(size_t i=0; i<links.size(); ++i)
+    {
+        if(links[i].cli->is_connected()) continue;
+        try
+        {
+            tokens[i] = links[i].cli->connect(options);
+        }
+        catch(const mqtt::exception& e)
+        {
+            spdlog::warn("ReconnectManager: Connecting to {} failed: {}", links[i].uri, e.what());
+        }
+    }
+    std::vector<bool> resumed(links.size(), false);
+    for(size_t i=0; i<links.size(); ++i)
+    {
+        if(!tokens[i]) continue;
+        try
+        {
+            if(!tokens[i]->wait_for(CONNECT_TIMEOUT))
+            {
+                spdlog::warn("ReconnectManager: {} did not answer", links[i].uri);
+                continue;
+            }
+            resumed[i] = tokens[i]->get_connect_response().is_session_present();
+            std::lock_guard<std::mutex> lc_{mx};
+            links[i].up = true;
+        }
+        catch(const mqtt::exception& e)
+        {
+            spdlog::warn("ReconnectManager: Connecting to {} failed: {}", links[i].uri, e.what());
+        }
+    }
+
+    //a few round trips each, the fastest broker gets the subscriptions
+    size_t best{links.size()};
+    for(size_t i=0; i<links.size(); ++i)
+    {
+        if(!links[i].cli->is_connected()) continue;
+        for(int k=0; k<3; ++k) probe(links[i]);
+        const double rtt{links[i].rtt<0.0 ? std::numeric_limits<double>::max() : links[i].rtt};
+        if(best==links.size() || rtt<(links[best].rtt<0.0 ? std::numeric_limits<double>::max() : links[best].rtt))
+        {
+            best = i;
+        }
+    }
+    if(best==links.size()) return false;
+    if(!resumed[best] && !subscribe(links[best])) return false;
+
+    //standbys left over from an earlier run may still hold our subscriptions
+    for(size_t i=0; i<links.size(); ++i)
+    {
+        if(i==best || !resumed[i] || topics.empty()) continue;
+        try
+        {
+            links[i].cli->unsubscribe(mqtt::string_collection::create(topics))->wait_for(CONNECT_TIMEOUT);
+        }
+        catch(const mqtt::exception& e)
+        {
+            spdlog::warn("ReconnectManager: Could not clear the old session on {}: {}", links[i].uri, e.what());
+        }
+    }
+
+    std::lock_guard<std::mutex> lc_{mx};
+    active = best;
+    spdlog::info("ReconnectManager: Connected to {} ({:.2f} ms round trip), {}, {} of {} brokers up",
+                links[best].uri, links[best].rtt*1e3, resumed[best] ? "session resumed" : "new session",
+                std::count_if(links.begin(), links.end(), [](const Link& link){return link.up;}), links.size());
+    return true;
+}
+
+bool ReconnectManager::attempt(Link& link, bool& resumed)
+{
+    try
+    {
+        mqtt::token_ptr conntok{link.cli->connect(options)};
+        if(!conntok->wait_for(CONNECT_TIMEOUT)) return false;
+        resumed = conntok->get_connect_response().is_session_present();
+        if(!resumed && !subscribe(link)) return false;
+    }
+    catch(const mqtt::exception& e)
+    {
+        spdlog::warn("ReconnectManager: Connection attempt to {} failed: {}", link.uri, e.what());
+        return false;
+    }
+    return true;
+}
+
+bool ReconnectManager::subscribe(Link& link)
+{
+    std::unique_lock<std::mutex> lc_{mx};
+    if(topics.empty()) return true;
+    try
+    {
+        //every filter in one SUBSCRIBE packet, one round trip however many there are
+        mqtt::token_ptr subtok{link.cli->subscribe(mqtt::string_collection::create(topics), qos)};
+        lc_.unlock();
+        return subtok->wait_for(CONNECT_TIMEOUT);
+    }
+    catch(const mqtt::exception& e)
+    {
+        spdlog::warn("ReconnectManager: Subscribing on {} failed: {}", link.uri, e.what());
+        return false;
+    }
+}
+
+double ReconnectManager::probe(Link& link)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    try
+    {
+        if(!link.cli->unsubscribe(probe_filter)->wait_for(PROBE_TIMEOUT)) return -1.0;
+    }
+    catch(const mqtt::exception&)
+    {
+        return -1.0;
+    }
+    const double rtt{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+    link.rtt = link.rtt<0.0 ? rtt : 0.8*link.rtt+0.2*rtt;
+    return rtt;
+}
+
+bool ReconnectManager::failover(size_t from)
+{
+    size_t best;
+    while(true)
+    {
+        best = links.size();
+        {
+            std::lock_guard<std::mutex> lc_{mx};
+            for(size_t i=0; i<links.size(); ++i)
+            {
+                if(i==from || !links[i].up || links[i].misses>=MAX_MISSES) continue;
+                if(best==links.size() || (links[i].rtt>=0.0 && (links[best].rtt<0.0 || links[i].rtt<links[best].rtt)))
+                {
+                    best = i;
+                }
+            }
+        }
+        if(best==links.size()) return false;
+        if(subscribe(links[best])) break;
+        down(best, "subscribe failed");
+    }
+
+    //the old broker comes back as a standby once it answers again
+    {
+        std::lock_guard<std::mutex> lc_{mx};
+        links[from].up = false;
+    }
+    links[from].misses = 0;
+    try
+    {
+        if(links[from].cli->is_connected()) links[from].cli->disconnect(0ms);
+    }
+    catch(const mqtt::exception&) {}
+
+    std::lock_guard<std::mutex> lc_{mx};
+    const double duration{std::chrono::duration<double>(std::chrono::steady_clock::now()-lost_at).count()};
+    active = best;
+    lost = false;
+    record(duration, false, true);
+    spdlog::warn("ReconnectManager: Failed over from {} to {} in {:.1f} ms ({} failovers)",
+                links[from].uri, links[best].uri, duration*1e3, stats.failovers);
+    return true;
+}
+
+bool ReconnectManager::recover()
+{
+    size_t start;
+    {
+        std::lock_guard<std::mutex> lc_{mx};
+        start = active;
+    }
+    auto backoff{MIN_BACKOFF};
+    while(true)
+    {
+        //the broker we lost first, it may still hold the session
+        for(size_t i=0; i<links.size(); ++i)
+        {
+            const size_t index{(start+i)%links.size()};
+            Link& link{links[index]};
+            if(link.pending)
+            {
+                try {link.pending->wait();} catch(const mqtt::exception&) {}
+                link.pending.reset();
+            }
+            bool resumed{false};
+            //a standby connected meanwhile only lacks the subscriptions
+            const bool ok{link.cli->is_connected() ? subscribe(link) : attempt(link, resumed)};
+            if(!ok) continue;
+
+            std::lock_guard<std::mutex> lc_{mx};
+            const double duration{std::chrono::duration<double>(std::chrono::steady_clock::now()-lost_at).count()};
+            link.up = true;
+            link.misses = 0;
+            active = index;
+            //the connection may have dropped again while we were subscribing
+            lost = !link.cli->is_connected();
+            record(duration, resumed, index!=start);
+            spdlog::info("ReconnectManager: Reconnected to {} after {:.0f} ms, {} (mean {:.0f} ms over {} reconnects)",
+                        link.uri, duration*1e3, resumed ? "session resumed" : "subscriptions restored",
+                        stats.total/stats.reconnects*1e3, stats.reconnects);
+            return true;
+        }
+        std::unique_lock<std::mutex> lc_{mx};
+        if(cv.wait_for(lc_, backoff, [&](){return stopping;})) return false;
+        backoff = std::min(backoff*2, MAX_BACKOFF);
+    }
+}
+
+void ReconnectManager::maintain()
+{
+    const auto now{std::chrono::steady_clock::now()};
+    size_t current;
+    bool degraded{false};
+    for(size_t i=0; i<links.size(); ++i)
+    {
+        Link& link{links[i]};
+        bool up;
+        {
+            std::lock_guard<std::mutex> lc_{mx};
+            up = link.up;
+            current = active;
+        }
+        if(link.pending)
+        {
+            if(!link.pending->is_complete()) continue;
+            mqtt::token_ptr conntok{std::move(link.pending)};
+            link.pending.reset();
+            try
+            {
+                conntok->wait();
+                {
+                    std::lock_guard<std::mutex> lc_{mx};
+                    link.up = true;
+                }
+                link.backoff = MIN_BACKOFF;
+                link.misses = 0;
+                link.rtt = -1.0;
+                spdlog::info("ReconnectManager: Standby {} connected", link.uri);
+            }
+            catch(const mqtt::exception&)
+            {
+                link.retry_at = now+link.backoff;
+                link.backoff = std::min(link.backoff*2, MAX_BACKOFF);
+            }
+            continue;
+        }
+        if(!up)
+        {
+            //a lost active broker is handled by failover() and recover()
+            if(i==current || now<link.retry_at) continue;
+            try
+            {
+                link.pending = link.cli->connect(standby_options);
+            }
+            catch(const mqtt::exception&)
+            {
+                link.retry_at = now+link.backoff;
+                link.backoff = std::min(link.backoff*2, MAX_BACKOFF);
+            }
+            continue;
+        }
+        const auto probed{std::chrono::steady_clock::now()};
+        if(probe(link)>=0.0)
+        {
+            link.misses = 0;
+            continue;
+        }
+        if(link.misses==0) link.missed_at = probed;
+        if(++link.misses==MAX_MISSES)
+        {
+            spdlog::warn("ReconnectManager: {} missed {} probes in a row", link.uri, link.misses);
+        }
+        if(i==current && link.misses>=MAX_MISSES) degraded = true;
+    }
+
+    //a slow broker that is still connected is only left for a standby; the failover
+    //time counts from its first missed probe, so the logged duration includes detection
+    if(!degraded) return;
+    {
+        std::lock_guard<std::mutex> lc_{mx};
+        lost_at = links[current].missed_at;
+    }
+    failover(current);
+}
+
+void ReconnectManager::down(size_t index, const std::string& cause)
+{
+    bool standby;
+    {
+        std::lock_guard<std::mutex> lc_{mx};
+        if(!links[index].up) return;
+        links[index].up = false;
+        standby = index!=active;
+        if(!standby && !lost)
+        {
+            lost = true;
+            lost_at = std::chrono::steady_clock::now();
+        }
+    }
+    if(standby) spdlog::warn("ReconnectManager: Lost standby {}: {}", links[index].uri, cause);
+    else spdlog::critical("ReconnectManager: Lost connection to {}: {}", links[index].uri, cause);
+    cv.notify_one();
+}
+
+void ReconnectManager::record(double duration, bool resumed, bool switched)
+{
+    ++stats.reconnects;
+    stats.resumed += resumed;
+    stats.failovers += switched;
+    stats.last = duration;
+    stats.max = std::max(stats.max, duration);
+    stats.total += duration;
+}
+
+void ReconnectManager::loop()
+{
+    std::unique_lock<std::mutex> lc_{mx};
+    while(true)
+    {
+        //the callbacks wake us up at once, the timeout paces the probes
+        cv.wait_for(lc_, PROBE_INTERVAL, [&](){return lost || stopping;});
+        if(stopping) return;
+
+        const bool was_lost{lost};
+        const size_t from{active};
+        lc_.unlock();
+        if(was_lost)
+        {
+            if(!failover(from) && !recover()) return;
+        }
+        else
+        {
+            maintain();
+        }
+        lc_.lock();
+    }
+}
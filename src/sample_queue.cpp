@@ -0,0 +1,134 @@
+#include <algorithm>
+#include "sample_queue.hpp"
+
+
+bool parsePolicy(std::string_view name, OverloadPolicy& policy)
+{
+    if(name=="drop_oldest") policy = OverloadPolicy::DROP_OLDEST;
+    else if(name=="drop_newest") policy = OverloadPolicy::DROP_NEWEST;
+    else if(name=="coalesce") policy = OverloadPolicy::COALESCE;
+    else if(name=="downsample") policy = OverloadPolicy::DOWNSAMPLE;
+    else return false;
+    return true;
+}
+
+const char* policyName(OverloadPolicy policy)
+{
+    switch(policy)
+    {
+        case OverloadPolicy::DROP_OLDEST: return "drop_oldest";
+        case OverloadPolicy::DROP_NEWEST: return "drop_newest";
+        case OverloadPolicy::COALESCE: return "coalesce";
+        case OverloadPolicy::DOWNSAMPLE: return "downsample";
+    }
+    return "unknown";
+}
+
+
+SampleQueue::SampleQueue(size_t _capacity, OverloadPolicy _policy, uint32_t _downsample):
+                                                    capacity{std::max<size_t>(_capacity, 2)},
+                                                    policy{_policy},
+                                                    downsample{std::max<uint32_t>(_downsample, 1)}
+{
+}
+
+SampleQueue::Stream& SampleQueue::stream(uint32_t sensor)
+{
+    while(streams.size()<=sensor)
+    {
+        streams.push_back(Stream{std::vector<Sample>{}, 0, 0, policy, 0, Stats{}});
+    }
+    return streams[sensor];
+}
+
+void SampleQueue::insert(Stream& s, const Sample& sample)
+{
+    if(s.count==capacity)
+    {
+        //ring full: the oldest slot becomes the newest, the evicted sample was counted as accepted
+        s.ring[s.head] = sample;
+        s.head = (s.head+1)%s.ring.size();
+        ++s.stats.dropped;
+        return;
+    }
+    if(s.count==s.ring.size())
+    {
+        //unrolled to start at slot 0 so the new slots follow the newest sample
+        std::rotate(s.ring.begin(), s.ring.begin()+s.head, s.ring.end());
+        s.head = 0;
+        s.ring.resize(std::min(capacity, std::max(INITIAL_RING, 2*s.ring.size())));
+    }
+    s.ring[(s.head+s.count)%s.ring.size()] = sample;
+    ++s.count;
+    ++s.stats.accepted;
+}
+
+void SampleQueue::push(const Sample& sample)
+{
+    std::lock_guard<std::mutex> lc_{mx};
+    Stream& s{stream(sample.sensor)};
+    switch(s.policy)
+    {
+        case OverloadPolicy::DROP_OLDEST:
+            insert(s, sample);
+            break;
+        case OverloadPolicy::DROP_NEWEST:
+            if(s.count==capacity)
+            {
+                ++s.stats.dropped;
+                return;
+            }
+            insert(s, sample);
+            break;
+        case OverloadPolicy::COALESCE:
+            if(s.count>0)
+            {
+                //the newest sample already carries the orientation fused from all the others
+                s.ring[(s.head+s.count-1)%s.ring.size()] = sample;
+                ++s.stats.dropped;
+                return;
+            }
+            insert(s, sample);
+            break;
+        case OverloadPolicy::DOWNSAMPLE:
+            if(s.count>=capacity/2 && ++s.skipped<downsample)
+            {
+                ++s.stats.dropped;
+                return;
+            }
+            s.skipped = 0;
+            insert(s, sample);
+            break;
+    }
+    s.stats.depth = static_cast<uint32_t>(s.count);
+    s.stats.max_depth = std::max(s.stats.max_depth, s.stats.depth);
+}
+
+size_t SampleQueue::drain(std::vector<Sample>& out)
+{
+    out.clear();
+    std::lock_guard<std::mutex> lc_{mx};
+    for(Stream& s : streams)
+    {
+        const size_t first{std::min(s.count, s.ring.size()-s.head)};
+        out.insert(out.end(), s.ring.begin()+s.head, s.ring.begin()+s.head+first);
+        out.insert(out.end(), s.ring.begin(), s.ring.begin()+(s.count-first));
+        s.head = 0;
+        s.count = 0;
+        s.stats.depth = 0;
+    }
+    return out.size();
+}
+
+void SampleQueue::setPolicy(uint32_t sensor, OverloadPolicy _policy)
+{
+    std::lock_guard<std::mutex> lc_{mx};
+    stream(sensor).policy = _policy;
+}
+
+void SampleQueue::stats(std::vector<Stats>& out) const
+{
+    std::lock_guard<std::mutex> lc_{mx};
+    out.resize(streams.size());
+    for(size_t i=0; i<streams.size(); ++i) out[i] = streams[i].stats;
+}
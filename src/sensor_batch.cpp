@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cxxopts.hpp>
+#include "spdlog/spdlog.h"
+#include "query.hpp"
+#include "aggregate.hpp"
+#include "batch.hpp"
+#include "work_pool.hpp"
+
+//reprocesses the files written by sensor_mqtt_subscriber --record with a new filter or calibration
+//usage: sensor_batch --dir rec --out results --beta 0.05 --bias 0.1,-0.2,0.05 --aggregate 1,60
+//writes <topic>.orientation.csv and <topic>.statistics.csv per sensor into --out
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options{"sensor_batch", "Reprocesses recorded sensor data on all cores"};
+    options.add_options()
+    ("dir", "directory of the recording",
+    cxxopts::value<std::string>()->default_value("."))
+    ("out", "directory the results are written to",
+    cxxopts::value<std::string>()->default_value("batch"))
+    ("threads", "worker threads, 0 for one per core",
+    cxxopts::value<unsigned>()->default_value("0"))
+    ("beta", "gain of the Madgwick orientation filter",
+    cxxopts::value<float>()->default_value("0.1"))
+    ("bias", "gyro bias in deg/s subtracted from every sample, x,y,z",
+    cxxopts::value<std::string>()->default_value("0,0,0"))
+    ("scale", "gyro scale factors applied after the bias, x,y,z",
+    cxxopts::value<std::string>()->default_value("1,1,1"))
+    ("aggregate", "comma separated tumbling window lengths in seconds for per sensor statistics, empty to disable",
+    cxxopts::value<std::string>()->default_value("1,60"))
+    ("decimate", "export every Nth orientation, 0 to disable the orientation export",
+    cxxopts::value<uint32_t>()->default_value("1"))
+    ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if(result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    BatchJob::Options job{result["out"].as<std::string>(), glm::vec3(0.0f), glm::vec3(1.0f),
+                        result["beta"].as<float>(), {}, result["decimate"].as<uint32_t>()};
+    if(!parseVector(result["bias"].as<std::string>(), job.bias) ||
+        !parseVector(result["scale"].as<std::string>(), job.scale) ||
+        !parseWindowLengths(result["aggregate"].as<std::string>(), job.windows))
+    {
+        spdlog::critical("Invalid --bias, --scale or --aggregate");
+        return EXIT_FAILURE;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(job.output, error);
+    if(error)
+    {
+        spdlog::critical("Could not create {}: {}", job.output, error.message());
+        return EXIT_FAILURE;
+    }
+
+    auto start{std::chrono::steady_clock::now()};
+    SeriesQuery query{result["dir"].as<std::string>()};
+    if(!query.open()) return EXIT_FAILURE;
+    const double opened{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+
+    WorkStealingPool pool{result["threads"].as<unsigned>()};
+    BatchJob batch{query, job};
+    start = std::chrono::steady_clock::now();
+    const bool ok{batch.run(pool)};
+    const double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+
+    const BatchJob::Stats stats{batch.getStats()};
+    const WorkStealingPool::Stats tasks{pool.getStats()};
+    spdlog::info("{} samples in {} segments of {} sensors in {:.2f} s: {:.2f} M samples/s on {} threads, "
+                "{} tasks ({} stolen), {:.1f} MB written, index opened in {:.2f} s",
+                stats.samples, stats.segments, query.topics().size(), seconds,
+                static_cast<double>(stats.samples)/seconds*1e-6, pool.threadCount(), tasks.executed, tasks.stolen,
+                static_cast<double>(stats.bytes)*1e-6, opened);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cxxopts.hpp>
+#include "spdlog/spdlog.h"
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "query.hpp"
+#include "arrow_export.hpp"
+
+//time range queries over the files written by sensor_mqtt_subscriber --record
+//usage: sensor_query --dir rec --list
+//       sensor_query --dir rec --topic imu/0 --last 3600 --resolution 1
+//       sensor_query --dir rec --topic imu/0 --from 120 --to 180 --orientation true
+//       sensor_query --dir rec --topic imu/0 --arrow imu0.arrow
+//results go to stdout as CSV, everything else to stderr
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options{"sensor_query", "Queries recorded sensor data"};
+    options.add_options()
+    ("dir", "directory of the recording",
+    cxxopts::value<std::string>()->default_value("."))
+    ("list", "list the recorded topics as topic,begin,end,samples,segments",
+    cxxopts::value<bool>()->default_value("false"))
+    ("topic", "topic to query",
+    cxxopts::value<std::string>()->default_value(""))
+    ("from", "start of the range in seconds of the sensor clock, the start of the recording if missing",
+    cxxopts::value<double>())
+    ("to", "end of the range in seconds of the sensor clock, the end of the recording if missing",
+    cxxopts::value<double>())
+    ("last", "range of this many seconds before the end of the recording, replaces from and to",
+    cxxopts::value<double>()->default_value("0"))
+    ("resolution", "interval width in seconds, min/max/mean per interval; 0 returns every sample",
+    cxxopts::value<double>()->default_value("0"))
+    ("orientation", "fuse the samples and return orientations as t,w,x,y,z",
+    cxxopts::value<bool>()->default_value("false"))
+    ("warmup", "seconds of samples fused before the range when querying orientations",
+    cxxopts::value<double>()->default_value("5"))
+    ("gyro_only", "also fuse gyro only (3 axis) recordings, the orientation then drifts from the start of the warmup",
+    cxxopts::value<bool>()->default_value("false"))
+    ("beta", "gain of the Madgwick orientation filter",
+    cxxopts::value<float>()->default_value("0.1"))
+    ("arrow", "write the raw samples of the range to this Arrow IPC (Feather v2) file instead of stdout",
+    cxxopts::value<std::string>()->default_value(""))
+    ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+    if(result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return EXIT_SUCCESS;
+    }
+    spdlog::set_default_logger(spdlog::stderr_color_mt("sensor_query"));
+
+    const auto start{std::chrono::steady_clock::now()};
+    SeriesQuery query{result["dir"].as<std::string>()};
+    if(!query.open()) return EXIT_FAILURE;
+    const double opened{std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()};
+
+    if(result["list"].as<bool>())
+    {
+        for(const std::string& topic : query.topics())
+        {
+            const IndexedSeries* series{query.find(topic)};
+            std::printf("%s,%.6f,%.6f,%llu,%zu\n", topic.c_str(), series->begin(), series->end(),
+                        static_cast<unsigned long long>(series->sampleCount()), series->segmentCount());
+        }
+        return EXIT_SUCCESS;
+    }
+
+    const std::string topic{result["topic"].as<std::string>()};
+    const IndexedSeries* series{query.find(topic)};
+    if(!series)
+    {
+        spdlog::error("No recording of topic '{}' in {}, see --list", topic, result["dir"].as<std::string>());
+        return EXIT_FAILURE;
+    }
+    double from{result.count("from") ? result["from"].as<double>() : series->begin()};
+    double to{result.count("to") ? result["to"].as<double>() : series->end()};
+    if(result["last"].as<double>()>0.0)
+    {
+        to = series->end();
+        from = to-result["last"].as<double>();
+    }
+    const double resolution{result["resolution"].as<double>()};
+
+    const auto queried{std::chrono::steady_clock::now()};
+    size_t rows{0};
+    if(!result["arrow"].as<std::string>().empty())
+    {
+        ArrowWriter::Stats exported{};
+        if(!exportArrow(*series, from, to, result["arrow"].as<std::string>(), exported)) return EXIT_FAILURE;
+        rows = exported.rows;
+        spdlog::info("{} rows in {} record batches, {:.1f} MB", exported.rows, exported.batches,
+                    static_cast<double>(exported.bytes)*1e-6);
+    }
+    else if(result["orientation"].as<bool>())
+    {
+        const double warmup{result["warmup"].as<double>()};
+        const bool gyro_only{result["gyro_only"].as<bool>()};
+        if(!gyro_only && query.gyroOnly(topic, from-warmup, to))
+        {
+            spdlog::error("{} has no accelerometer in the range, use --gyro_only true for drifting orientations",
+                        topic);
+            return EXIT_FAILURE;
+        }
+        std::vector<SeriesQuery::Orientation> orientations;
+        rows = query.orientations(topic, from, to, resolution, orientations, warmup, result["beta"].as<float>(),
+                                gyro_only);
+        for(const SeriesQuery::Orientation& o : orientations)
+        {
+            std::printf("%.6f,%.6f,%.6f,%.6f,%.6f\n", o.t, o.q.w, o.q.x, o.q.y, o.q.z);
+        }
+    }
+    else if(resolution>0.0)
+    {
+        std::vector<Bucket> buckets;
+        rows = query.buckets(topic, from, to, resolution, buckets);
+        for(const Bucket& b : buckets)
+        {
+            std::printf("%.6f,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", b.start, b.count,
+                        b.min.x, b.min.y, b.min.z, b.max.x, b.max.y, b.max.z, b.mean.x, b.mean.y, b.mean.z);
+        }
+    }
+    else
+    {
+        std::vector<Sample> samples;
+        rows = query.samples(topic, from, to, samples);
+        for(const Sample& s : samples)
+        {
+            std::printf("%.6f,%.4f,%.4f,%.4f", s.timestamp, s.value.x, s.value.y, s.value.z);
+            if(s.axes>=6) std::printf(",%.4f,%.4f,%.4f", s.accel.x, s.accel.y, s.accel.z);
+            if(s.axes>=9) std::printf(",%.4f,%.4f,%.4f", s.mag.x, s.mag.y, s.mag.z);
+            std::printf("\n");
+        }
+    }
+    const double seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-queried).count()};
+    const SeriesQuery::Stats stats{query.getStats()};
+    spdlog::info("{} rows in {:.2f} ms ({} segments decoded, {} from the index), index opened in {:.2f} ms",
+                rows, seconds*1e3, stats.decoded, stats.summarized+stats.rolled, opened*1e3);
+    return EXIT_SUCCESS;
+}
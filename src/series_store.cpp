@@ -0,0 +1,600 @@
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "series_store.hpp"
+#include "spdlog/spdlog.h"
+
+static constexpr double INF{std::numeric_limits<double>::infinity()};
+
+//columns of a segment for an axis layout of 3, 6 or 9
+static size_t columnCount(uint8_t axes)
+{
+    return 1+3*std::clamp<size_t>(axes/3, 1, 3);
+}
+
+static float channelValue(const Sample& sample, size_t channel)
+{
+    const glm::vec3& v{channel<3 ? sample.value : channel<6 ? sample.accel : sample.mag};
+    return v[static_cast<int>(channel%3)];
+}
+
+static float& channelValue(Sample& sample, size_t channel)
+{
+    glm::vec3& v{channel<3 ? sample.value : channel<6 ? sample.accel : sample.mag};
+    return v[static_cast<int>(channel%3)];
+}
+
+std::string series::fileName(const std::string& directory, const std::string& topic)
+{
+    std::string name;
+    for(char c : topic)
+    {
+        if(c=='/') name += "%2F";
+        else if(c=='%') name += "%25";
+        else name += c;
+    }
+    return directory+"/"+name+".gts";
+}
+
+
+void SeriesWriter::BitWriter::write(uint64_t value, uint32_t count)
+{
+    //up to 64 bits, split so the 64 bit buffer never overflows
+    if(count>32)
+    {
+        write(value>>32, count-32);
+        value &= 0xffffffffull;
+        count = 32;
+    }
+    buffer = (buffer<<count) | (value & ((1ull<<count)-1));
+    bits += count;
+    while(bits>=8)
+    {
+        bits -= 8;
+        bytes.push_back(static_cast<uint8_t>(buffer>>bits));
+    }
+}
+
+void SeriesWriter::BitWriter::finish()
+{
+    if(bits) bytes.push_back(static_cast<uint8_t>(buffer<<(8-bits)));
+    bits = 0;
+    buffer = 0;
+}
+
+
+SeriesWriter::SeriesWriter(const std::string& _path, const std::string& _topic):fd{-1},
+                                                                                path{_path},
+                                                                                columns(series::MAX_COLUMNS),
+                                                                                channels(series::MAX_COLUMNS-1),
+                                                                                count{0},
+                                                                                axes{3},
+                                                                                t_min{INF},
+                                                                                t_max{-INF},
+                                                                                t_first{0.0},
+                                                                                opened{0.0},
+                                                                                previous_micros{0},
+                                                                                previous_delta{0},
+                                                                                stats{0, 0, 0}
+{
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if(fd<0)
+    {
+        spdlog::error("SeriesWriter: Could not open {}: {}", path, std::strerror(errno));
+        return;
+    }
+    struct stat info;
+    fstat(fd, &info);
+    const size_t size{static_cast<size_t>(info.st_size)};
+    if(size==0)
+    {
+        std::vector<uint8_t> header(sizeof(series::FileHeader)+_topic.size());
+        const series::FileHeader file{series::FILE_MAGIC, series::VERSION, static_cast<uint16_t>(_topic.size())};
+        std::memcpy(header.data(), &file, sizeof(file));
+        std::memcpy(header.data()+sizeof(file), _topic.data(), _topic.size());
+        if(::write(fd, header.data(), header.size())!=static_cast<ssize_t>(header.size()))
+        {
+            spdlog::error("SeriesWriter: Could not write {}: {}", path, std::strerror(errno));
+            ::close(fd);
+            fd = -1;
+        }
+        return;
+    }
+
+    //continuing a file: it has to be ours, and a segment cut short by a crash is cut off
+    series::FileHeader file{};
+    std::string topic(_topic.size(), '\0');
+    if(pread(fd, &file, sizeof(file), 0)!=sizeof(file) || file.magic!=series::FILE_MAGIC ||
+        file.topic_length!=_topic.size() ||
+        pread(fd, topic.data(), topic.size(), sizeof(file))!=static_cast<ssize_t>(topic.size()) || topic!=_topic)
+    {
+        spdlog::error("SeriesWriter: {} is not a series file of {}", path, _topic);
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+    size_t end{sizeof(file)+topic.size()};
+    series::SegmentHeader header;
+    while(end+sizeof(header)<=size && pread(fd, &header, sizeof(header), static_cast<off_t>(end))==sizeof(header) &&
+            header.magic==series::SEGMENT_MAGIC && header.bytes>=sizeof(header)+sizeof(series::SegmentFooter) &&
+            end+header.bytes<=size)
+    {
+        end += header.bytes;
+    }
+    if(end<size)
+    {
+        spdlog::warn("SeriesWriter: {} bytes of an incomplete segment cut off {}", size-end, path);
+        if(ftruncate(fd, static_cast<off_t>(end))!=0)
+        {
+            spdlog::error("SeriesWriter: Could not truncate {}: {}", path, std::strerror(errno));
+            ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+SeriesWriter::~SeriesWriter()
+{
+    flush();
+    if(fd>=0) ::close(fd);
+}
+
+void SeriesWriter::encodeTimestamp(int64_t micros)
+{
+    BitWriter& column{columns[0]};
+    if(count==0)
+    {
+        column.write(static_cast<uint64_t>(micros), 64);
+        previous_micros = micros;
+        previous_delta = 0;
+        return;
+    }
+    const int64_t delta{micros-previous_micros};
+    const int64_t dod{delta-previous_delta};
+    previous_micros = micros;
+    previous_delta = delta;
+    //zigzag, small changes of either sign get short codes
+    const uint64_t zz{(static_cast<uint64_t>(dod)<<1) ^ static_cast<uint64_t>(dod>>63)};
+    if(zz==0) column.write(0b0, 1);
+    else if(zz<(1u<<7)) {column.write(0b10, 2); column.write(zz, 7);}
+    else if(zz<(1u<<9)) {column.write(0b110, 3); column.write(zz, 9);}
+    else if(zz<(1u<<12)) {column.write(0b1110, 4); column.write(zz, 12);}
+    else {column.write(0b1111, 4); column.write(zz, 64);}
+}
+
+void SeriesWriter::encodeValue(size_t index, float value)
+{
+    BitWriter& column{columns[index+1]};
+    Channel& channel{channels[index]};
+    const uint32_t bits{std::bit_cast<uint32_t>(value)};
+    if(count==0)
+    {
+        column.write(bits, 32);
+        channel = Channel{bits, 32, 0};
+        return;
+    }
+    const uint32_t x{bits^channel.previous};
+    channel.previous = bits;
+    if(x==0)
+    {
+        column.write(0b0, 1);
+        return;
+    }
+    const uint32_t leading{std::min<uint32_t>(std::countl_zero(x), 31)};
+    const uint32_t trailing{static_cast<uint32_t>(std::countr_zero(x))};
+    //the meaningful bits fit the window of the previous value: no new window needed
+    if(channel.leading+channel.trailing<32 && leading>=channel.leading && trailing>=channel.trailing)
+    {
+        column.write(0b10, 2);
+        column.write(x>>channel.trailing, 32-channel.leading-channel.trailing);
+        return;
+    }
+    const uint32_t length{32-leading-trailing};
+    column.write(0b11, 2);
+    column.write(leading, 5);
+    column.write(length-1, 5);
+    column.write(x>>trailing, length);
+    channel.leading = leading;
+    channel.trailing = trailing;
+}
+
+void SeriesWriter::push(const Sample& sample)
+{
+    if(fd<0) return;
+    if(count && (sample.axes!=axes || count>=SEGMENT_SAMPLES || sample.timestamp-t_first>=SEGMENT_SECONDS))
+    {
+        flush();
+    }
+    if(count==0)
+    {
+        axes = sample.axes;
+        t_first = sample.timestamp;
+        opened = sample.arrival;
+    }
+    encodeTimestamp(std::llround(sample.timestamp*1e6));
+    for(size_t c=0; c+1<columnCount(axes); ++c) encodeValue(c, channelValue(sample, c));
+    t_min = std::min(t_min, sample.timestamp);
+    t_max = std::max(t_max, sample.timestamp);
+    ++count;
+}
+
+bool SeriesWriter::flushIdle(double now)
+{
+    if(count==0 || now-opened<SEGMENT_SECONDS) return true;
+    return flush();
+}
+
+bool SeriesWriter::flush()
+{
+    if(fd<0 || count==0) return true;
+    const size_t used{columnCount(axes)};
+    series::SegmentFooter footer{};
+    footer.t_min = t_min;
+    footer.t_max = t_max;
+    footer.count = count;
+    footer.axes = axes;
+    footer.columns = static_cast<uint8_t>(used);
+    footer.magic = series::FOOTER_MAGIC;
+    size_t bytes{sizeof(series::SegmentHeader)+sizeof(footer)};
+    for(size_t c=0; c<used; ++c)
+    {
+        columns[c].finish();
+        footer.column_bytes[c] = static_cast<uint32_t>(columns[c].bytes.size());
+        bytes += columns[c].bytes.size();
+    }
+    const series::SegmentHeader header{series::SEGMENT_MAGIC, static_cast<uint32_t>(bytes)};
+
+    //one write per segment, a crash leaves at most this segment incomplete
+    segment.resize(bytes);
+    uint8_t* out{segment.data()};
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    for(size_t c=0; c<used; ++c)
+    {
+        std::memcpy(out, columns[c].bytes.data(), columns[c].bytes.size());
+        out += columns[c].bytes.size();
+        columns[c].clear();
+    }
+    std::memcpy(out, &footer, sizeof(footer));
+
+    const uint32_t samples{count};
+    count = 0;
+    t_min = INF;
+    t_max = -INF;
+    //O_APPEND writes at the end, a partial segment has to go again or every later one is unreadable
+    const off_t start{lseek(fd, 0, SEEK_END)};
+    size_t written{0};
+    while(written<bytes)
+    {
+        const ssize_t n{::write(fd, segment.data()+written, bytes-written)};
+        if(n<0 && errno==EINTR) continue;
+        if(n<=0)
+        {
+            spdlog::error("SeriesWriter: Writing {} failed, {} samples lost: {}", path, samples,
+                        n<0 ? std::strerror(errno) : "short write");
+            if(start<0 || ftruncate(fd, start)!=0)
+            {
+                //the partial segment stays, stop appending behind it
+                spdlog::error("SeriesWriter: Could not cut off the partial segment of {}, recording stopped", path);
+                ::close(fd);
+                fd = -1;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    stats.samples += samples;
+    ++stats.segments;
+    stats.bytes += bytes;
+    return true;
+}
+
+
+//MSB first reader over one column of a mapped segment
+class BitReader{
+    public:
+        BitReader(const uint8_t* _data, size_t _size):data{_data}, end{_data+_size}, buffer{0}, bits{0} {}
+
+        uint64_t read(uint32_t count)
+        {
+            if(count>32)
+            {
+                const uint64_t high{read(count-32)};
+                return (high<<32) | read(32);
+            }
+            while(bits<count)
+            {
+                //past the end of the column reads zeros, a corrupt segment decodes to garbage but stays in bounds
+                buffer = (buffer<<8) | (data<end ? *data++ : 0u);
+                bits += 8;
+            }
+            bits -= count;
+            return (buffer>>bits) & ((1ull<<count)-1);
+        }
+        bool bit() {return read(1)!=0;}
+
+    private:
+        const uint8_t* data;
+        const uint8_t* end;
+        uint64_t buffer;
+        uint32_t bits;
+};
+
+
+SeriesReader::SeriesReader():base{nullptr}, size{0}, data_offset{0}
+{
+}
+
+SeriesReader::~SeriesReader()
+{
+    close();
+}
+
+void SeriesReader::close()
+{
+    if(base) munmap(const_cast<uint8_t*>(base), size);
+    base = nullptr;
+    size = 0;
+    data_offset = 0;
+    index.clear();
+    topic_name.clear();
+}
+
+bool SeriesReader::open(const std::string& _path)
+{
+    if(!map(_path)) return false;
+    const size_t end{scan(data_offset)};
+    if(end<size) spdlog::warn("SeriesReader: {} trailing bytes of {} ignored", size-end, path);
+    return true;
+}
+
+bool SeriesReader::map(const std::string& _path)
+{
+    close();
+    path = _path;
+    const int fd{::open(path.c_str(), O_RDONLY)};
+    if(fd<0)
+    {
+        spdlog::error("SeriesReader: Could not open {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    struct stat info;
+    fstat(fd, &info);
+    size = static_cast<size_t>(info.st_size);
+    void* mapped{size>=sizeof(series::FileHeader) ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED};
+    ::close(fd);
+    if(mapped==MAP_FAILED)
+    {
+        spdlog::error("SeriesReader: Could not map {}: {}", path, size ? std::strerror(errno) : "empty file");
+        size = 0;
+        return false;
+    }
+    base = static_cast<const uint8_t*>(mapped);
+
+    series::FileHeader file;
+    std::memcpy(&file, base, sizeof(file));
+    if(file.magic!=series::FILE_MAGIC || file.version!=series::VERSION || sizeof(file)+file.topic_length>size)
+    {
+        spdlog::error("SeriesReader: {} is not a series file", path);
+        close();
+        return false;
+    }
+    topic_name.assign(reinterpret_cast<const char*>(base+sizeof(file)), file.topic_length);
+    data_offset = sizeof(file)+file.topic_length;
+    return true;
+}
+
+size_t SeriesReader::scan(size_t offset)
+{
+    while(offset+sizeof(series::SegmentHeader)<=size)
+    {
+        series::SegmentHeader header;
+        std::memcpy(&header, base+offset, sizeof(header));
+        if(header.magic!=series::SEGMENT_MAGIC || header.bytes<sizeof(header)+sizeof(series::SegmentFooter) ||
+            offset+header.bytes>size) break;
+        series::SegmentFooter footer;
+        std::memcpy(&footer, base+offset+header.bytes-sizeof(footer), sizeof(footer));
+        if(footer.magic!=series::FOOTER_MAGIC) break;
+        index.push_back(Segment{offset, footer.t_min, footer.t_max, footer.count, footer.axes});
+        offset += header.bytes;
+    }
+    return offset;
+}
+
+uint64_t SeriesReader::sampleCount() const
+{
+    uint64_t total{0};
+    for(const Segment& segment : index) total += segment.count;
+    return total;
+}
+
+//timestamp column, _store(i, seconds) per sample
+template<typename Store>
+static void decodeTimestamps(BitReader& reader, size_t count, Store store)
+{
+    int64_t micros{static_cast<int64_t>(reader.read(64))};
+    int64_t delta{0};
+    for(size_t i=0; i<count; ++i)
+    {
+        if(i>0)
+        {
+            uint32_t width{64};
+            if(!reader.bit()) width = 0;
+            else if(!reader.bit()) width = 7;
+            else if(!reader.bit()) width = 9;
+            else if(!reader.bit()) width = 12;
+            const uint64_t zz{width ? reader.read(width) : 0};
+            delta += static_cast<int64_t>(zz>>1) ^ -static_cast<int64_t>(zz&1);
+            micros += delta;
+        }
+        store(i, static_cast<double>(micros)*1e-6);
+    }
+}
+
+//float channel column, _store(i, value) per sample
+template<typename Store>
+static void decodeChannel(BitReader& reader, size_t count, Store store)
+{
+    uint32_t bits{static_cast<uint32_t>(reader.read(32))};
+    uint32_t leading{0}, trailing{0};
+    store(0, std::bit_cast<float>(bits));
+    for(size_t i=1; i<count; ++i)
+    {
+        if(reader.bit())
+        {
+            if(reader.bit())
+            {
+                leading = static_cast<uint32_t>(reader.read(5));
+                trailing = 32-leading-static_cast<uint32_t>(reader.read(5)+1);
+            }
+            bits ^= static_cast<uint32_t>(reader.read(32-leading-trailing))<<trailing;
+        }
+        store(i, std::bit_cast<float>(bits));
+    }
+}
+
+size_t SeriesReader::decode(const Segment& segment, std::vector<Sample>& out, uint32_t sensor) const
+{
+    series::SegmentHeader header;
+    std::memcpy(&header, base+segment.offset, sizeof(header));
+    series::SegmentFooter footer;
+    std::memcpy(&footer, base+segment.offset+header.bytes-sizeof(footer), sizeof(footer));
+    const size_t used{std::min<size_t>(footer.columns, series::MAX_COLUMNS)};
+
+    const size_t first{out.size()};
+    out.resize(first+footer.count);
+    Sample blank{};
+    blank.sensor = sensor;
+    blank.axes = footer.axes;
+    for(size_t i=first; i<out.size(); ++i) out[i] = blank;
+    if(footer.count==0) return 0;
+
+    //column by column, every column is one sequential pass over its bytes
+    Sample* samples{out.data()+first};
+    const uint8_t* data{base+segment.offset+sizeof(header)};
+    for(size_t c=0; c<used; ++c)
+    {
+        BitReader reader{data, footer.column_bytes[c]};
+        data += footer.column_bytes[c];
+        if(c==0)
+        {
+            decodeTimestamps(reader, footer.count, [samples](size_t i, double t){
+                samples[i].timestamp = t;
+                samples[i].arrival = t;
+            });
+            continue;
+        }
+        decodeChannel(reader, footer.count, [samples, c](size_t i, float v){channelValue(samples[i], c-1) = v;});
+    }
+    return footer.count;
+}
+
+size_t SeriesReader::decodeColumns(const Segment& segment, const Columns& out) const
+{
+    series::SegmentHeader header;
+    std::memcpy(&header, base+segment.offset, sizeof(header));
+    series::SegmentFooter footer;
+    std::memcpy(&footer, base+segment.offset+header.bytes-sizeof(footer), sizeof(footer));
+    const size_t used{std::min<size_t>(footer.columns, series::MAX_COLUMNS)};
+    if(footer.count==0) return 0;
+
+    const uint8_t* data{base+segment.offset+sizeof(header)};
+    for(size_t c=0; c<used; ++c)
+    {
+        BitReader reader{data, footer.column_bytes[c]};
+        data += footer.column_bytes[c];
+        if(c==0 && out.timestamp)
+        {
+            double* t{out.timestamp};
+            decodeTimestamps(reader, footer.count, [t](size_t i, double v){t[i] = v;});
+        }
+        else if(c>0 && out.channel[c-1])
+        {
+            float* channel{out.channel[c-1]};
+            decodeChannel(reader, footer.count, [channel](size_t i, float v){channel[i] = v;});
+        }
+    }
+    return footer.count;
+}
+
+size_t SeriesReader::read(double from, double to, std::vector<Sample>& out, uint32_t sensor) const
+{
+    size_t total{0};
+    for(const Segment& segment : index)
+    {
+        if(segment.t_max<from || segment.t_min>to) continue;
+        const size_t first{out.size()};
+        decode(segment, out, sensor);
+        //only segments straddling the range are filtered
+        if(segment.t_min<from || segment.t_max>to)
+        {
+            const auto outside{std::remove_if(out.begin()+static_cast<std::ptrdiff_t>(first), out.end(),
+                                [&](const Sample& s){return s.timestamp<from || s.timestamp>to;})};
+            out.erase(outside, out.end());
+        }
+        total += out.size()-first;
+    }
+    return total;
+}
+
+
+SeriesRecorder::SeriesRecorder(const std::string& _directory, TopicLookup _topic):directory{_directory},
+                                                                                topic{std::move(_topic)}
+{
+}
+
+SeriesRecorder::~SeriesRecorder()
+{
+    flush();
+}
+
+void SeriesRecorder::push(const Sample& sample)
+{
+    if(sample.sensor>=writers.size()) writers.resize(sample.sensor+1);
+    std::unique_ptr<SeriesWriter>& writer{writers[sample.sensor]};
+    if(!writer)
+    {
+        std::string name{topic ? topic(sample.sensor) : std::string{}};
+        if(name.empty()) name = "sensor_"+std::to_string(sample.sensor);
+        writer = std::make_unique<SeriesWriter>(series::fileName(directory, name), name);
+        if(writer->ok()) spdlog::info("SeriesRecorder: recording {} to {}", name, series::fileName(directory, name));
+    }
+    writer->push(sample);
+}
+
+void SeriesRecorder::flush()
+{
+    for(std::unique_ptr<SeriesWriter>& writer : writers)
+    {
+        if(writer) writer->flush();
+    }
+}
+
+void SeriesRecorder::flushIdle(double now)
+{
+    for(std::unique_ptr<SeriesWriter>& writer : writers)
+    {
+        if(writer) writer->flushIdle(now);
+    }
+}
+
+SeriesWriter::Stats SeriesRecorder::getStats() const
+{
+    SeriesWriter::Stats total{0, 0, 0};
+    for(const std::unique_ptr<SeriesWriter>& writer : writers)
+    {
+        if(!writer) continue;
+        const SeriesWriter::Stats stats{writer->getStats()};
+        total.samples += stats.samples;
+        total.segments += stats.segments;
+        total.bytes += stats.bytes;
+    }
+    return total;
+}
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include "shader.hpp"
 #include "spdlog/spdlog.h"
 
@@ -126,5 +127,22 @@ void FragmentShader::setFloat(const uint& ID, const std::string& name, float val
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
-
-
+uint linkProgram(const BaseShader& vertex_shader, const BaseShader& fragment_shader)
+{
+    //create a shader program object 
+    uint program = glCreateProgram();
+    glAttachShader(program, vertex_shader.get());
+    glAttachShader(program, fragment_shader.get());
+    glLinkProgram(program);
+
+    int program_success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &program_success);
+    if(!program_success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        spdlog::error("The Program could not link to the shaders: {}", infoLog);
+        std::exit(EXIT_FAILURE);
+    }
+    return program;
+}
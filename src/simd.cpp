@@ -0,0 +1,58 @@
+#include "kernels.hpp"
+
+const char* simd::levelName(Level level)
+{
+    switch(level)
+    {
+        case NEON: return "NEON";
+        case SSE42: return "SSE4.2";
+        case AVX2: return "AVX2";
+        case AVX512: return "AVX-512";
+        default: return "scalar";
+    }
+}
+
+simd::Level simd::detect()
+{
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    //NEON is mandatory on AArch64
+    return NEON;
+#else
+  #if defined(SENSOR_HAVE_X86_KERNELS)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) return AVX512;
+    if(__builtin_cpu_supports("avx2")) return AVX2;
+    if(__builtin_cpu_supports("sse4.2")) return SSE42;
+  #endif
+    return SCALAR;
+#endif
+}
+
+const simd::Kernels& simd::kernels(Level level)
+{
+    static const Kernels scalar{makeKernels<Scalar>(SCALAR)};
+    static const Level available{detect()};
+    if(level>available) level = available;
+    switch(level)
+    {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+        case NEON:
+        {
+            static const Kernels neon{makeKernels<Neon>(NEON)};
+            return neon;
+        }
+#endif
+#if defined(SENSOR_HAVE_X86_KERNELS)
+        case SSE42: return kernelsSse42();
+        case AVX2: return kernelsAvx2();
+        case AVX512: return kernelsAvx512();
+#endif
+        default: return scalar;
+    }
+}
+
+const simd::Kernels& simd::kernels()
+{
+    static const Kernels& selected{kernels(detect())};
+    return selected;
+}
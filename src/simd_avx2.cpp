@@ -0,0 +1,8 @@
+//compiled with the AVX2 flags, only reached after simd::detect() reported AVX2
+#include "kernels.hpp"
+
+const simd::Kernels& simd::kernelsAvx2()
+{
+    static const Kernels table{makeKernels<Avx2>(AVX2)};
+    return table;
+}
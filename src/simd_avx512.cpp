@@ -0,0 +1,8 @@
+//compiled with the AVX512 flags, only reached after simd::detect() reported AVX512
+#include "kernels.hpp"
+
+const simd::Kernels& simd::kernelsAvx512()
+{
+    static const Kernels table{makeKernels<Avx512>(AVX512)};
+    return table;
+}
@@ -0,0 +1,8 @@
+//compiled with the SSE42 flags, only reached after simd::detect() reported SSE42
+#include "kernels.hpp"
+
+const simd::Kernels& simd::kernelsSse42()
+{
+    static const Kernels table{makeKernels<Sse>(SSE42)};
+    return table;
+}
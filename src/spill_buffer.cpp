@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "spill_buffer.hpp"
+#include "spdlog/spdlog.h"
+
+
+SpillBuffer::SpillBuffer(size_t _capacity, const std::string& _directory):
+                                                    base{nullptr},
+                                                    size{0},
+                                                    head{0},
+                                                    tail{0},
+                                                    records{0},
+                                                    rejected{0},
+                                                    peak{0}
+{
+    const size_t page{static_cast<size_t>(sysconf(_SC_PAGESIZE))};
+    size = std::max(page, (_capacity+page-1)/page*page);
+
+    //the file only gives the pages a backing store, nobody else ever opens it
+    std::string path{_directory+"/sensor_spill_XXXXXX"};
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    const int fd{mkstemp(name.data())};
+    if(fd<0 || unlink(name.data())!=0 || ftruncate(fd, static_cast<off_t>(size))!=0)
+    {
+        spdlog::critical("SpillBuffer::SpillBuffer: Could not create a {} byte spill file in {}: {}",
+                        size, _directory, std::strerror(errno));
+        std::exit(EXIT_FAILURE);
+    }
+    void* mapped{mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+    close(fd);
+    if(mapped==MAP_FAILED)
+    {
+        spdlog::critical("SpillBuffer::SpillBuffer: Mapping {} bytes failed: {}", size, std::strerror(errno));
+        std::exit(EXIT_FAILURE);
+    }
+    base = static_cast<std::byte*>(mapped);
+    spdlog::info("SpillBuffer: {} KiB mapped from {}", size>>10, _directory);
+}
+
+SpillBuffer::~SpillBuffer()
+{
+    if(base) munmap(base, size);
+}
+
+bool SpillBuffer::push(std::string_view topic, std::string_view payload,
+                    const uint32_t* seq, uint32_t epoch, double arrival)
+{
+    const size_t length{(sizeof(Header)+topic.size()+payload.size()+ALIGN-1)/ALIGN*ALIGN};
+    const uint64_t t{tail.load(std::memory_order_relaxed)};
+    const uint64_t h{head.load(std::memory_order_acquire)};
+    size_t offset{t%size};
+    //a record never wraps, the tail of the ring is skipped instead
+    const size_t skip{offset+length>size ? size-offset : 0};
+    if(length>size/2 || t+skip+length-h>size)
+    {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if(skip)
+    {
+        Header marker{};
+        marker.length = WRAP;
+        std::memcpy(base+offset, &marker, sizeof(marker.length));
+        offset = 0;
+    }
+
+    const Header header{static_cast<uint32_t>(length),
+                        static_cast<uint32_t>(topic.size()),
+                        static_cast<uint32_t>(payload.size()),
+                        seq ? *seq : 0u,
+                        arrival,
+                        seq ? 1u : 0u,
+                        epoch};
+    std::byte* dst{base+offset};
+    std::memcpy(dst, &header, sizeof(header));
+    std::memcpy(dst+sizeof(header), topic.data(), topic.size());
+    std::memcpy(dst+sizeof(header)+topic.size(), payload.data(), payload.size());
+
+    const uint64_t end{t+skip+length};
+    tail.store(end, std::memory_order_release);
+    records.fetch_add(1, std::memory_order_relaxed);
+    if(end-h>peak.load(std::memory_order_relaxed)) peak.store(end-h, std::memory_order_relaxed);
+    //a wakeup lost to the race with wait() costs at most its timeout
+    cv.notify_one();
+    return true;
+}
+
+bool SpillBuffer::front(Record& record)
+{
+    uint64_t h{head.load(std::memory_order_relaxed)};
+    if(h==tail.load(std::memory_order_acquire)) return false;
+    Header header;
+    std::memcpy(&header.length, base+h%size, sizeof(header.length));
+    if(header.length==WRAP)
+    {
+        h += size-h%size;
+        head.store(h, std::memory_order_release);
+        if(h==tail.load(std::memory_order_acquire)) return false;
+    }
+    const std::byte* src{base+h%size};
+    std::memcpy(&header, src, sizeof(header));
+    const char* text{reinterpret_cast<const char*>(src+sizeof(header))};
+    record.topic = std::string_view(text, header.topic_size);
+    record.payload = std::string_view(text+header.topic_size, header.payload_size);
+    record.seq = header.seq;
+    record.epoch = header.epoch;
+    record.has_seq = header.has_seq!=0;
+    record.arrival = header.arrival;
+    return true;
+}
+
+void SpillBuffer::pop()
+{
+    const uint64_t h{head.load(std::memory_order_relaxed)};
+    uint32_t length;
+    std::memcpy(&length, base+h%size, sizeof(length));
+    head.store(h+length, std::memory_order_release);
+}
+
+bool SpillBuffer::wait(std::chrono::milliseconds timeout)
+{
+    auto pending = [&](){
+        return head.load(std::memory_order_relaxed)!=tail.load(std::memory_order_acquire);
+    };
+    if(pending()) return true;
+    std::unique_lock<std::mutex> lc_{mx};
+    return cv.wait_for(lc_, timeout, pending);
+}
+
+SpillBuffer::Stats SpillBuffer::getStats() const
+{
+    const uint64_t h{head.load(std::memory_order_acquire)};
+    const uint64_t t{tail.load(std::memory_order_acquire)};
+    return Stats{records.load(std::memory_order_relaxed),
+                rejected.load(std::memory_order_relaxed),
+                t-h,
+                peak.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,75 @@
+#include <cstdlib>
+#include "stream_buffer.hpp"
+#include "spdlog/spdlog.h"
+using namespace gl;
+
+
+StreamBuffer::StreamBuffer(GLenum target_, GLsizeiptr region_size_):
+                                                    target{target_},
+                                                    region_size{region_size_},
+                                                    buffer{0},
+                                                    mapped{nullptr},
+                                                    region{0},
+                                                    stall_count{0}
+{
+    fences.fill(nullptr);
+    //immutable storage: persistent + coherent mapping lets the CPU keep the pointer
+    //for the whole lifetime of the buffer and makes writes visible without explicit flushes
+    const GLbitfield flags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferStorage(target, REGIONS*region_size, nullptr, flags);
+    mapped = static_cast<std::byte*>(glMapBufferRange(target, 0, REGIONS*region_size, flags));
+    if(!mapped)
+    {
+        spdlog::critical("StreamBuffer::StreamBuffer: Persistent mapping of {} bytes failed!",
+                        REGIONS*region_size);
+        std::exit(EXIT_FAILURE);
+    }
+    spdlog::debug("StreamBuffer: {}x{} bytes mapped persistently", REGIONS, region_size);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for(GLsync& fence : fences)
+    {
+        if(fence) glDeleteSync(fence);
+    }
+    glBindBuffer(target, buffer);
+    glUnmapBuffer(target);
+    glDeleteBuffers(1, &buffer);
+}
+
+void* StreamBuffer::begin()
+{
+    GLsync& fence = fences[region];
+    if(fence)
+    {
+        //poll first, flush the command stream only if the region is still in use
+        GLbitfield wait_flags{0};
+        GLenum status{glClientWaitSync(fence, 0, 0)};
+        if(status==GL_TIMEOUT_EXPIRED)
+        {
+            ++stall_count;
+            wait_flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            do
+            {
+                status = glClientWaitSync(fence, wait_flags, 1000000); //1ms
+                wait_flags = 0;
+            } while(status==GL_TIMEOUT_EXPIRED);
+        }
+        if(status==GL_WAIT_FAILED)
+        {
+            spdlog::error("StreamBuffer::begin: glClientWaitSync failed!");
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    return mapped + offset();
+}
+
+void StreamBuffer::end()
+{
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region+1)%REGIONS;
+}
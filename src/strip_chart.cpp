@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "strip_chart.hpp"
+#include "spdlog/spdlog.h"
+using namespace gl;
+
+//line colors of the x, y and z channels, same order as the axis colors
+static const glm::vec3 CHANNEL_COLORS[3]{
+                                    glm::vec3(1.0f, 0.0f, 0.0f),
+                                    glm::vec3(0.0f, 1.0f, 0.0f),
+                                    glm::vec3(0.0f, 0.0f, 1.0f)
+                                };
+
+
+StripChart::StripChart(uint columns_, float window_length_):
+                                            capacity{columns_+2}, //partially visible columns at both edges
+                                            window_length{window_length_},
+                                            decimator{columns_, window_length_},
+                                            stream{GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(2*(capacity+1)*sizeof(Vertex))},
+                                            head{0},
+                                            count{0},
+                                            latest{0.0f},
+                                            dirty_begin{0},
+                                            dirty_count{0},
+                                            stale{},
+                                            staging(2*(capacity+1))
+{
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    //every region holds a whole ring, a frame picks its region by the first vertex of the draw
+    glBindBuffer(GL_ARRAY_BUFFER, stream.get());
+    //time attribute
+    glVertexAttribPointer(0,1,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)offsetof(Vertex, t));
+    glEnableVertexAttribArray(0);
+    //x,y,z values attribute
+    glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)offsetof(Vertex, value));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+StripChart::~StripChart()
+{
+    glDeleteVertexArrays(1, &VAO);
+}
+
+void StripChart::markDirty(uint slot)
+{
+    if(dirty_count==0)
+    {
+        dirty_begin = slot;
+        dirty_count = 1;
+    }
+    else if(slot==(dirty_begin+dirty_count)%capacity)
+    {
+        dirty_count = std::min(dirty_count+1, capacity);
+    }
+    //any other slot is the current column, which is already inside the range
+}
+
+void StripChart::append(const Sample& _sample)
+{
+    stage(_sample.timestamp, decimator.add(_sample));
+}
+
+void StripChart::append(const Bucket& _bucket)
+{
+    stage(_bucket.start, decimator.add(_bucket.start, _bucket.min, _bucket.max, _bucket.count));
+}
+
+void StripChart::stage(double timestamp, bool opened)
+{
+    if(opened)
+    {
+        head = (head+1)%capacity;
+        count = std::min(count+1, capacity);
+    }
+    const MinMaxDecimator::Column& column{decimator.current()};
+    const uint slot{(head+capacity-1)%capacity};
+    const float t{decimator.columnTime(column.index)};
+    staging[2*slot] = Vertex{t, column.min};
+    staging[2*slot+1] = Vertex{t, column.max};
+    markDirty(slot);
+    latest = static_cast<float>(timestamp-decimator.getEpoch());
+}
+
+void StripChart::upload(std::byte* _region, uint _first, uint _count)
+{
+    std::memcpy(_region+2*_first*sizeof(Vertex), &staging[2*_first], 2*_count*sizeof(Vertex));
+}
+
+GLint StripChart::flush()
+{
+    //the slots changed since the last frame are missing from every region
+    if(dirty_count>0)
+    {
+        for(Range& range : stale)
+        {
+            if(range.count==0)
+            {
+                range = Range{dirty_begin, dirty_count};
+                continue;
+            }
+            //the ring head only moves forward, so the new slots extend the missing ones
+            const uint end{(dirty_begin+capacity-range.begin)%capacity+dirty_count};
+            range.count = std::min(capacity, std::max(range.count, end));
+        }
+        dirty_count = 0;
+    }
+
+    std::byte* region{static_cast<std::byte*>(stream.begin())};
+    Range& range{stale[stream.offset()/stream.regionSize()]};
+    if(range.count>0)
+    {
+        //at most two copies: the tail of the ring and the wrapped part at its start
+        const uint first_chunk{std::min(range.count, capacity-range.begin)};
+        upload(region, range.begin, first_chunk);
+        if(first_chunk<range.count)
+        {
+            upload(region, 0, range.count-first_chunk);
+        }
+        //slot 0 changed, refresh its mirror behind the last slot
+        if(range.begin==0 || first_chunk<range.count)
+        {
+            staging[2*capacity] = staging[0];
+            staging[2*capacity+1] = staging[1];
+            upload(region, capacity, 1);
+        }
+        range.count = 0;
+    }
+    return static_cast<GLint>(stream.offset()/static_cast<GLintptr>(sizeof(Vertex)));
+}
+
+void StripChart::draw(uint _program, float _scale)
+{
+    if(count==0) return;
+    const GLint base{flush()};
+
+    glUseProgram(_program);
+    glUniform1f(glGetUniformLocation(_program, "latest"), latest);
+    glUniform1f(glGetUniformLocation(_program, "window_length"), window_length);
+    glUniform1f(glGetUniformLocation(_program, "scale"), _scale);
+    const int channelLoc = glGetUniformLocation(_program, "channel");
+    const int colorLoc = glGetUniformLocation(_program, "color");
+
+    glBindVertexArray(VAO);
+    for(int channel=0; channel<3; ++channel)
+    {
+        glUniform1i(channelLoc, channel);
+        glUniform3fv(colorLoc, 1, &CHANNEL_COLORS[channel].x);
+        if(count<capacity)
+        {
+            glDrawArrays(GL_LINE_STRIP, base, 2*count);
+        }
+        else
+        {
+            //oldest part first; it ends on the mirror of slot 0 so both strips join
+            glDrawArrays(GL_LINE_STRIP, base+2*head, 2*(capacity-head+(head>0?1:0)));
+            if(head>0) glDrawArrays(GL_LINE_STRIP, base, 2*head);
+        }
+    }
+    glBindVertexArray(0);
+    stream.end();
+}
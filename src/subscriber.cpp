@@ -4,55 +4,73 @@
 #include <chrono>
 #include <vector>
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <csignal>
 #include <future>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
+#include <thread>
 extern "C" {
     #include <glad/glad.h>
 }
 #include <GLFW/glfw3.h>
-#define GLM_FORCE_CXX20
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include "mqtt/client.h"
 #include "mqtt/topic.h"
 #include "spdlog/spdlog.h"
 #include "shader.hpp"
+#include "axes.hpp"
 #include "window.hpp"
 #include "listener.hpp"
+#include "ingest.hpp"
 #include "parser.hpp"
+#include "sample.hpp"
+#include "sample_queue.hpp"
+#include "strip_chart.hpp"
+#include "ahrs.hpp"
+#include "jitter_buffer.hpp"
+#include "aggregate.hpp"
+#include "series_store.hpp"
+#include "arrow_export.hpp"
+#include "playback.hpp"
+#include "timeline.hpp"
 
 
 using namespace std::chrono_literals;
 
-static float vertices[] = {
-        //positions             //colors
-        0.0f,  0.0f, 0.0f, 1.0f, 0.0f, 0.0f, // origin
-        0.0f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, // origin
-        0.0f,  0.0f, 0.0f, 0.0f, 0.0f, 1.0f, // origin
-        0.0f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, // x
-        0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,  // y
-        0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 1.0f //z
-}; 
-    
-static uint indices[] = {
-        0, 3, //first axis 
-        1, 4, //second axis
-        2, 5 //third axis
-};
-
-
-const std::string SHADER_PATHS[2]{
+const std::string SHADER_PATHS[3]{
                                     "../shaders/vertex.txt", //vertex shader
-                                    "../shaders/fragment.txt" //fragment shader
+                                    "../shaders/fragment.txt", //fragment shader
+                                    "../shaders/plot_vertex.txt" //history plot vertex shader
                                 };
 
+//angle value drawn at the top edge of a history plot
+constexpr float PLOT_SCALE{180.0f};
+//fraction of the window height covered by the history plots
+constexpr float PLOT_AREA{0.35f};
+//seconds between two reports of samples dropped by the queue
+constexpr double QUEUE_REPORT_INTERVAL{10.0};
+//seconds between two republished window statistics
+constexpr double AGGREGATE_INTERVAL{1.0};
+//seconds between two updates of the statistics in the title bar
+constexpr double HUD_INTERVAL{0.5};
+//fraction of the window height covered by the playback timeline
+constexpr float TIMELINE_AREA{0.08f};
+//seconds an arrow key moves the playback cursor
+constexpr double PLAYBACK_STEP{1.0};
+
+//set by SIGINT/SIGTERM, the loops exit and the recordings are flushed on the way out
+static volatile std::sig_atomic_t stop_requested{0};
 
-void glSetup(uint& VAO, uint& VBO, uint &EBO, 
-            float* vertices, uint* indices,
-            uint vertice_size, uint indice_size);
+static void requestStop(int)
+{
+    stop_requested = 1;
+}
 
 
 int main(int argc, char** argv)
@@ -61,86 +79,362 @@ int main(int argc, char** argv)
     ArgParser* parser = ArgParser::GetInstance();    
     parser->parse(argc, argv);
     parser->help();
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
 
-    glm::vec3 view_angles;
-    //configure MQTTListener instance
-    MQTTListener mqtt_client{parser->getServer(),
-                            parser->getClientID(),
-                            parser->getTopic(),
-                            parser->getQualityLevel()};
-
-
-    //declare a future object related to MQTT communication
+    OrientationJitter jitter{parser->getExtrapolate()};
+    std::vector<glm::quat> orientations;
+    OverloadPolicy queue_policy;
+    if(!parsePolicy(parser->getQueuePolicy(), queue_policy))
+    {
+        spdlog::critical("Unknown queue policy: {}", parser->getQueuePolicy());
+        std::exit(EXIT_FAILURE);
+    }
+    //optional windowed statistics of the gyro rates per sensor
+    std::vector<double> window_lengths;
+    WindowAggregate::Mode window_mode;
+    if(!parseWindowLengths(parser->getAggregate(), window_lengths) ||
+        !parseWindowMode(parser->getAggregateMode(), window_mode))
+    {
+        spdlog::critical("Invalid statistics windows: {} {}", parser->getAggregate(), parser->getAggregateMode());
+        std::exit(EXIT_FAILURE);
+    }
+    std::unique_ptr<AggregateEngine> aggregates;
+    if(!window_lengths.empty())
+    {
+        aggregates = std::make_unique<AggregateEngine>(window_lengths, window_mode);
+    }
+    std::string aggregate_lines;
+    double aggregate_time{steadySeconds()};
+    std::vector<Sample> samples;
+    std::vector<SampleQueue::Stats> queue_stats;
+    std::vector<uint64_t> reported_drops;
+    double queue_report{steadySeconds()};
+    std::vector<std::unique_ptr<gl::StripChart>> charts;
+    //configure the MQTT ingest, one listener per shard
+    ShardedIngest ingest{IngestOptions{parser->getServers(),
+                                        parser->getClientID(),
+                                        parser->getTopics(),
+                                        parser->getQualityLevel(),
+                                        parser->getSessionExpiry(),
+                                        parser->getSpillCapacity(),
+                                        parser->getSpillDirectory(),
+                                        parser->getQueueCapacity(),
+                                        queue_policy,
+                                        parser->getDownsample(),
+                                        parser->getBeta(),
+                                        parser->getShareGroup(),
+                                        parser->getShareByTopic(),
+                                        parser->getResultTopic(),
+                                        parser->getThrottle(),
+                                        parser->getThrottleDepth(),
+                                        parser->getThrottleCpu(),
+                                        parser->getControlTopic(),
+                                        parser->getPin()},
+                        parser->getShards()};
+    if(parser->getOrdered())
+    {
+        ingest.setOrdered(parser->getLateness());
+    }
+    if(parser->getTierRaw())
+    {
+        ingest.setTiers(parser->getTierRaw());
+    }
+    //optional recording, one compressed series file per sensor topic
+    std::unique_ptr<SeriesRecorder> recorder;
+    if(!parser->getRecord().empty())
+    {
+        recorder = std::make_unique<SeriesRecorder>(parser->getRecord(),
+                                                    [&ingest](uint32_t sensor){return ingest.topic(sensor);});
+    }
+    //optional columnar export for analysis, one Arrow file for all sensors
+    std::unique_ptr<ArrowRecorder> exporter;
+    if(!parser->getArrow().empty())
+    {
+        exporter = std::make_unique<ArrowRecorder>(parser->getArrow(),
+                                                    [&ingest](uint32_t sensor){return ingest.topic(sensor);});
+    }
+    //optional playback of a recording instead of the live stream, nothing is subscribed then
+    std::unique_ptr<Playback> playback;
+    if(!parser->getPlayback().empty())
+    {
+        playback = std::make_unique<Playback>(parser->getPlayback(), parser->getHistoryLength(), parser->getBeta());
+        if(parser->getHeadless() || !playback->open())
+        {
+            spdlog::critical("Cannot play back {}, it needs a window and a recording", parser->getPlayback());
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        ingest.start();
+    }
+    uint64_t reported_late{0};
 
-    std::future<bool> mqtt_receiver_setup{std::async(std::launch::async,
-                                                    &MQTTListener::setupMQTT,
-                                                    &mqtt_client)};
+    auto reportDrops = [&](){
+        if(steadySeconds()-queue_report<=QUEUE_REPORT_INTERVAL) return false;
+        queue_report = steadySeconds();
+        ingest.stats(queue_stats);
+        reported_drops.resize(queue_stats.size(), 0);
+        for(size_t i=0; i<queue_stats.size(); ++i)
+        {
+            if(queue_stats[i].dropped==reported_drops[i]) continue;
+            spdlog::warn("Sensor {} overloaded: {} samples dropped ({}), {} of {} so far, queue depth peaked at {}",
+                        i, queue_stats[i].dropped-reported_drops[i], parser->getQueuePolicy(), queue_stats[i].dropped,
+                        queue_stats[i].accepted+queue_stats[i].dropped, queue_stats[i].max_depth);
+            reported_drops[i] = queue_stats[i].dropped;
+        }
+        for(uint32_t sensor=0; aggregates && sensor<aggregates->sensorCount(); ++sensor)
+        {
+            if(!aggregates->known(sensor)) continue;
+            for(size_t w=0; w<window_lengths.size(); ++w)
+            {
+                const Aggregate x{aggregates->get(sensor, w, 0)};
+                const Aggregate y{aggregates->get(sensor, w, 1)};
+                const Aggregate z{aggregates->get(sensor, w, 2)};
+                if(!x.count) continue;
+                spdlog::info("Sensor {} over {}s: mean {:.2f}/{:.2f}/{:.2f}, sd {:.2f}/{:.2f}/{:.2f}, "
+                            "range {:.1f}..{:.1f}/{:.1f}..{:.1f}/{:.1f}..{:.1f}, rms {:.2f}/{:.2f}/{:.2f} deg/s",
+                            sensor, window_lengths[w], x.mean, y.mean, z.mean,
+                            std::sqrt(x.variance), std::sqrt(y.variance), std::sqrt(z.variance),
+                            x.min, x.max, y.min, y.max, z.min, z.max, x.rms, y.rms, z.rms);
+            }
+        }
+        if(recorder)
+        {
+            const SeriesWriter::Stats recorded{recorder->getStats()};
+            spdlog::info("Recorded {} samples in {} segments, {:.2f} bytes per sample", recorded.samples,
+                        recorded.segments, recorded.samples ? static_cast<double>(recorded.bytes)/recorded.samples : 0.0);
+        }
+        const WatermarkMerge::Stats merged{ingest.mergeStats()};
+        if(merged.late!=reported_late)
+        {
+            spdlog::warn("Ordered merge: {} late samples dropped, {} waiting",
+                        merged.late-reported_late, merged.waiting);
+            reported_late = merged.late;
+        }
+        return true;
+    };
 
-    std::future<bool> mqtt_receiver_listen{std::async(std::launch::async,  
-                                                    &MQTTListener::listen,
-                                                    &mqtt_client,
-                                                    std::ref(view_angles))};                                    
+    //hands the drained samples to the recorder, the Arrow export and the statistics windows,
+    //the statistics are republished on "<aggregate_topic>/<sensor topic>";
+    //recordings of sensors that went quiet are flushed here as well
+    auto consume = [&](){
+        if(recorder)
+        {
+            for(const Sample& sample : samples) recorder->push(sample);
+            recorder->flushIdle(steadySeconds());
+        }
+        if(exporter)
+        {
+            for(const Sample& sample : samples) exporter->push(sample);
+            exporter->flushIdle(steadySeconds());
+        }
+        if(!aggregates) return;
+        for(const Sample& sample : samples) aggregates->push(sample);
+        if(parser->getAggregateTopic().empty() || steadySeconds()-aggregate_time<AGGREGATE_INTERVAL) return;
+        aggregate_time = steadySeconds();
+        for(uint32_t sensor=0; sensor<aggregates->sensorCount(); ++sensor)
+        {
+            if(!aggregates->known(sensor)) continue;
+            aggregate_lines.clear();
+            aggregates->format(sensor, aggregate_lines);
+            if(!aggregate_lines.empty()) ingest.publish(sensor, parser->getAggregateTopic(), aggregate_lines);
+        }
+    };
 
+    //worker mode: no window, the results leave through --result_topic
+    if(parser->getHeadless())
+    {
+        uint64_t processed{0};
+        double started{steadySeconds()};
+        while(!stop_requested)
+        {
+            processed += ingest.drain(samples);
+            consume();
+            const double since{steadySeconds()-started};
+            if(reportDrops())
+            {
+                spdlog::info("Worker {}: {:.0f} samples/s over {} sensors", parser->getClientID(),
+                            static_cast<double>(processed)/since, queue_stats.size());
+                processed = 0;
+                started = steadySeconds();
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        //what is still queued goes into the recordings before they are closed
+        ingest.stop();
+        ingest.drain(samples);
+        consume();
+        spdlog::info("Worker {}: stopped, flushing recordings", parser->getClientID());
+        recorder.reset();
+        exporter.reset();
+        return 0;
+    }
     
 
     GLFWwindow* window;  
     uint shader_program;
-    uint VBO; //vertex buffer object  
-    uint VAO; //vertex array object 
-    uint EBO; //element buffer object
+    uint plot_program;
     
     gl::Window frame{window, 600, 800, "subscriber_window"};
     
     //create Vertex and Fragment shader objects
     VertexShader vertex_shader{SHADER_PATHS[0]};
     FragmentShader fragment_shader{SHADER_PATHS[1]};
+    VertexShader plot_vertex_shader{SHADER_PATHS[2]};
     //compile dynamically both shaders
     vertex_shader.compile();
     fragment_shader.compile();
+    plot_vertex_shader.compile();
     //create a shader program object 
-    shader_program = glCreateProgram();
-    glAttachShader(shader_program, vertex_shader.get());
-    glAttachShader(shader_program, fragment_shader.get());
-    glLinkProgram(shader_program);
-
-    int shader_program_success;
-    char infoLog[512];
-    glGetProgramiv(shader_program,GL_LINK_STATUS, &shader_program_success);
-    if(!shader_program_success)
-    {
-        glGetProgramInfoLog(shader_program, 512, NULL, infoLog);
-        spdlog::error("The Program could not link to the shaders.");
-        //std::cerr<<"The program could not link to the shaders!!!\n";
-        std::exit(EXIT_FAILURE);
-    }   
+    shader_program = linkProgram(vertex_shader, fragment_shader);
+    //history plots share the fragment shader
+    plot_program = linkProgram(plot_vertex_shader, fragment_shader);
 
-    glSetup(VAO, VBO, EBO, vertices, indices, sizeof(vertices), sizeof(indices));
+    //released before the context is destroyed
+    auto axes{std::make_unique<gl::Axes>()};
 
 
-    std::future_status setup_status_;
     bool listener_result;   
     
     window = frame.get();
     
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::rotate(model, glm::radians(-55.0f),glm::vec3(0.0f,1.0f,1.0f));
-    glm::mat4 view = glm::mat4(1.0f);
-    view = glm::translate(view, glm::vec3(0.0f,0.0f,-3.0f));
+    const glm::mat4 camera_view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f,0.0f,-3.0f));
+    glm::mat4 view = camera_view;
     glm::mat4 projection;
     projection = glm::perspective(glm::radians(30.0f), 800.0f/600.0f, 0.1f, 100.0f);
     
+    double hud_time{0.0};
+    int chart_width{0};
+    std::vector<Bucket> buckets;
+
+    //the timeline shows the first sensor of the recording, the plots above it the
+    //history before the cursor and the axes the orientation at the cursor
+    std::unique_ptr<gl::Timeline> timeline;
+    if(playback)
+    {
+        frame.enableTimeline(TIMELINE_AREA);
+        timeline = std::make_unique<gl::Timeline>(playback->overview(0), playback->begin(), playback->end());
+    }
+    bool playing{false};
+    double replay_time{steadySeconds()};
+    double shown{0.0};      //time the plots are filled up to
+    bool refill{true};
+
+    //the cursor follows the clock while playing and the pointer while scrubbing; the plots
+    //continue with the samples passed since the last frame, a jump refills them. Until the
+    //prefetch thread has loaded the new position the last frame stays on screen.
+    auto replay = [&](){
+        const double now{steadySeconds()};
+        if(gl::Window::takePlayToggle()) playing = !playing;
+        double cursor{playback->position()};
+        if(playing) cursor += (now-replay_time)*parser->getPlaybackSpeed();
+        replay_time = now;
+        cursor += gl::Window::takeSteps()*PLAYBACK_STEP;
+        float fraction;
+        if(frame.scrubbing(fraction)) cursor = timeline->time(fraction);
+        playback->seek(cursor);
+        cursor = playback->position();
+        if(cursor>=playback->end()) playing = false;
+
+        samples.clear();
+        const double history{parser->getHistoryLength()};
+        const bool jump{refill || cursor<shown || cursor-shown>history};
+        bool loaded{true};
+        for(uint32_t sensor=0; loaded && sensor<playback->sensorCount(); ++sensor)
+        {
+            loaded = playback->samples(sensor, jump ? cursor-history : shown, cursor, samples);
+        }
+        if(!loaded) samples.clear();
+        else
+        {
+            if(jump) charts.clear();
+            refill = false;
+            shown = cursor;
+        }
+        glm::quat q;
+        if(playback->orientation(0, cursor, q)) orientations.assign(1, q);
+
+        if(now-hud_time<HUD_INTERVAL) return;
+        hud_time = now;
+        frame.setTitle(fmt::format("subscriber_window | {} {} {:.3f} / {:.3f} s", playing ? "playing" : "paused",
+                                playback->topic(0), cursor-playback->begin(), playback->end()-playback->begin()));
+    };
     //render loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && !stop_requested)
     {
         //check the input key at each iteration
         frame.processInput(window);
 
-        //check asynchronous mqtt communication
-        setup_status_ = mqtt_receiver_setup.wait_for(1ms);
-        if(setup_status_==std::future_status::ready){
-            
+        //one plot column per pixel: after a resize the plots are rebuilt from the history tier
+        //matching the new column width, which also covers a history longer than the raw tier
+        int fb_width, fb_height;
+        glfwGetFramebufferSize(window, &fb_width, &fb_height);
+        if(fb_width>0 && fb_width!=chart_width)
+        {
+            chart_width = fb_width;
+            refill = true;
+            const float history{parser->getHistoryLength()};
+            for(uint32_t sensor=0; sensor<charts.size(); ++sensor)
+            {
+                if(!charts[sensor]) continue;
+                charts[sensor] = std::make_unique<gl::StripChart>(static_cast<uint>(chart_width), history);
+                const TierStore* store{ingest.tiers(sensor)};
+                if(!store) continue;
+                buckets.clear();
+                store->read(store->newest()-history, store->newest(), history/chart_width, buckets);
+                for(const Bucket& bucket : buckets) charts[sensor]->append(bucket);
+            }
+        }
+
+        //hand the samples received since the last frame over to the history plots
+        if(playback) replay();
+        else
+        {
+            ingest.drain(samples);
+            consume();
+            reportDrops();
+        }
+        for(const Sample& sample : samples)
+        {
+            if(sample.sensor>=charts.size())
+            {
+                charts.resize(sample.sensor+1);
+            }
+            if(!charts[sample.sensor])
+            {
+                //one min/max column per horizontal pixel of the plot
+                charts[sample.sensor] = std::make_unique<gl::StripChart>(static_cast<uint>(std::max(chart_width, 1)),
+                                                                        parser->getHistoryLength());
+            }
+            charts[sample.sensor]->append(sample);
+            if(!playback) jitter.push(sample);
         }
-        setup_status_ = mqtt_receiver_listen.wait_for(1ms);
+        //gyro rms of the first sensor per window in the title bar
+        if(aggregates && !playback && steadySeconds()-hud_time>=HUD_INTERVAL)
+        {
+            hud_time = steadySeconds();
+            std::string title{"subscriber_window"};
+            for(uint32_t sensor=0; sensor<aggregates->sensorCount(); ++sensor)
+            {
+                if(!aggregates->known(sensor)) continue;
+                title += " | sensor "+std::to_string(sensor)+" rms";
+                for(size_t w=0; w<window_lengths.size(); ++w)
+                {
+                    title += fmt::format(" {}s {:.1f}/{:.1f}/{:.1f}", window_lengths[w],
+                                        aggregates->get(sensor, w, 0).rms, aggregates->get(sensor, w, 1).rms,
+                                        aggregates->get(sensor, w, 2).rms);
+                }
+                title += " deg/s";
+                break;
+            }
+            frame.setTitle(title);
+        }
+        //orientations replayed at a steady delay, independent of how the samples arrived
+        if(!playback) jitter.sample(steadySeconds(), orientations);
         //rendering commands 
         //at each frame cycle, we need to clear the screen otherwise old colors
         //from old frame will still hold on the viewport
@@ -148,24 +442,41 @@ int main(int argc, char** argv)
         //we specify which buffer we would like to clear
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);        
         
-        view = glm::rotate(view, glm::radians(view_angles.y),glm::vec3(0.0f,1.0f,0.0f));
+        //orientation is fused per sample on the ingest side, the frame only reads it
+        if(!orientations.empty())
+        {
+            view = camera_view*glm::mat4_cast(orientations[0]);
+        }
 
-        int modelLoc = glGetUniformLocation(shader_program, "model");
-        int viewLoc = glGetUniformLocation(shader_program, "view");
-        int projectiionLoc = glGetUniformLocation(shader_program, "projection");
         //recalculate view matrix 
         //view = frame.setCameraViewMatrix();
-        //now we are activating newly created program object 
-        glUseProgram(shader_program);
-        glBindVertexArray(VAO);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projectiionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        
+        axes->draw(shader_program, model, view, projection);
 
-        //draw axis lines
-        glLineWidth(3);
-        glDrawElements(GL_LINES, 6, GL_UNSIGNED_INT, 0);  //take indices into a consideration here. because you have saved indices as EBO.        
+        //history plots are stacked in the bottom part of the window, one per sensor,
+        //above the timeline when playing back
+        const int timeline_height{timeline ? static_cast<int>(fb_height*TIMELINE_AREA) : 0};
+        if(timeline)
+        {
+            glDisable(GL_DEPTH_TEST);
+            glViewport(0, 0, fb_width, timeline_height);
+            timeline->draw(plot_program, PLOT_SCALE, playback->position());
+            glViewport(0, 0, fb_width, fb_height);
+            glEnable(GL_DEPTH_TEST);
+        }
+        if(!charts.empty())
+        {
+            const int plot_height{static_cast<int>(fb_height*PLOT_AREA)/static_cast<int>(charts.size())};
+            glDisable(GL_DEPTH_TEST);
+            glLineWidth(1);
+            for(size_t i=0; i<charts.size(); ++i)
+            {
+                if(!charts[i]) continue;
+                glViewport(0, timeline_height+static_cast<int>(i)*plot_height, fb_width, plot_height);
+                charts[i]->draw(plot_program, PLOT_SCALE);
+            }
+            glViewport(0, 0, fb_width, fb_height);
+            glEnable(GL_DEPTH_TEST);
+        }
 
        
         //rendering is shown on the display
@@ -175,45 +486,15 @@ int main(int argc, char** argv)
     }
        
     //now we can delete shader program after linking them to program object    
-    glDeleteVertexArrays(1, &VAO);
+    charts.clear();
+    timeline.reset();
+    axes.reset();
+    recorder.reset();
+    exporter.reset();
     glDeleteProgram(shader_program);
+    glDeleteProgram(plot_program);
     glfwTerminate();
     return 0;
 
 }
 
-
-
-void glSetup(uint& VAO, uint& VBO, uint &EBO, 
-            float* vertices, uint* indices,
-            uint vertice_size, uint indice_size)
-{
-    //generate VAO object and bind it first of all
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-   
-    //create element buffer object EBO
-    glGenBuffers(1, &EBO);
-    glGenBuffers(1, &VBO);
-    //then bind and set EBO and VBOs
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indice_size, indices, GL_STATIC_DRAW);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertice_size, vertices, GL_STATIC_DRAW);
-    //we have to specify how OpenGL should interpret vertex data.
-    //it stores vertex data attributes including vertex buffer array in VAO object currently bound.
-    //describe how an element as a vertice should seem
-    //position attribute
-    glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,6*sizeof(float),(void*)0);    
-    glEnableVertexAttribArray(0); //enable vertex position attribute array- arg is an attribute index
-    //color attribute
-    glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,6*sizeof(float),(void*)(3*sizeof(float))); //last arg is an offset
-    glEnableVertexAttribArray(1); //enable vertex position attribute array- arg is an attribute index
-    //offset above become 3*sizeof(float) because for each vertice, first 3 elements are position values. 
-    //so color values starts from 4th element for each vertice.  
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0); //unbind VBO after glVertexAttribPointer function.
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glEnable(GL_DEPTH_TEST); 
-}
\ No newline at end of file
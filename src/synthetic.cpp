@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include "synthetic.hpp"
+#include "sample.hpp"
+#include "spdlog/spdlog.h"
+
+using namespace std::chrono_literals;
+
+//gravity and earth field seen by a level sensor
+static const glm::vec3 GRAVITY{0.0f, 0.0f, 9.81f};
+static const glm::vec3 EARTH_FIELD{0.25f, 0.0f, -0.40f};
+
+
+SyntheticPublisher::SyntheticPublisher(const std::string _address,
+                                    const std::string _client_id,
+                                    const std::string _topic_name,
+                                    const uint8_t _qos):server_address{_address},
+                                                        client_id{_client_id},
+                                                        topic_name{_topic_name},
+                                                        QOS{_qos},
+                                                        cli{
+                                                            mqtt::client(server_address,
+                                                                        client_id,
+                                                                        mqtt::create_options(MQTTVERSION_5))},
+                                                        running{false},
+                                                        sent{0},
+                                                        step_interval{0.5},
+                                                        step_angle{30.0f},
+                                                        throttle{ThrottleCommand::RESUME, 1, 0.0},
+                                                        pending{0},
+                                                        seq{0},
+                                                        epoch{static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count()) | 1u},
+                                                        gyro_sum{0.0f},
+                                                        accel_sum{0.0f},
+                                                        mag_sum{0.0f}
+{
+}
+
+bool SyntheticPublisher::connect()
+{
+    try
+    {
+        auto opts = mqtt::connect_options_builder()
+                                .keep_alive_interval(20s)
+                                .clean_session(true)
+                                .finalize();
+        cli.connect(opts);
+        if(!control_topic.empty()) cli.subscribe(control_topic, 1);
+    }
+    catch(const mqtt::exception& e)
+    {
+        spdlog::error("SyntheticPublisher::connect: {}", e.what());
+        return false;
+    }
+    spdlog::info("SyntheticPublisher connected to {} as {}", server_address, client_id);
+    return true;
+}
+
+void SyntheticPublisher::setControlTopic(const std::string& _control_prefix)
+{
+    control_topic = _control_prefix+"/"+topic_name;
+}
+
+void SyntheticPublisher::setStep(double _interval, float _angle)
+{
+    step_interval = _interval;
+    step_angle = _angle;
+}
+
+void SyntheticPublisher::run(Mode mode, double rate, uint8_t axes, uint64_t count)
+{
+    //a step only shows up as one rotation if nothing else moves the sensor
+    if(mode==STEPS) axes = 3;
+    const auto period{std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(1.0/rate))};
+    const uint64_t step_every{std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(step_interval*rate)))};
+    //the step sample turns the sensor over the interval since the previous sample
+    const float step_rate{step_angle*static_cast<float>(rate)};
+
+    uint64_t tick{0};
+    float direction{1.0f};
+    auto next{std::chrono::steady_clock::now()};
+    running = true;
+    while(running && (count==0 || tick<count))
+    {
+        std::this_thread::sleep_until(next);
+        next += period;
+
+        const double t{wallSeconds()};
+        glm::vec3 gyro{0.0f};
+        glm::vec3 accel{GRAVITY};
+        glm::vec3 mag{EARTH_FIELD};
+        if(mode==STEPS)
+        {
+            if(tick>0 && tick%step_every==0)
+            {
+                gyro.z = direction*step_rate;
+                direction = -direction;
+                spdlog::debug("SyntheticPublisher: step at {:.6f}", t);
+            }
+        }
+        else
+        {
+            const float phase{static_cast<float>(tick/rate)};
+            gyro = glm::vec3(40.0f*std::sin(0.7f*phase), 25.0f*std::sin(1.3f*phase), 60.0f*std::cos(0.4f*phase));
+            //small tilt wobble so the accelerometer carries information too
+            accel = GRAVITY + glm::vec3(0.3f*std::sin(phase), 0.3f*std::cos(phase), 0.0f);
+        }
+
+        poll();
+        emit(t, axes, gyro, accel, mag);
+        ++tick;
+    }
+    flush();
+    running = false;
+    spdlog::info("SyntheticPublisher: {} messages published on {}", sent.load(), topic_name);
+}
+
+void SyntheticPublisher::poll()
+{
+    if(control_topic.empty()) return;
+    mqtt::const_message_ptr msg;
+    while(cli.try_consume_message(&msg))
+    {
+        if(!msg) continue;
+        ThrottleCommand command;
+        if(!parseCommand(msg->get_payload_str(), command))
+        {
+            spdlog::warn("SyntheticPublisher: unknown control message {}", msg->get_payload_str());
+            continue;
+        }
+        if(command.mode!=throttle.mode || command.factor!=throttle.factor)
+        {
+            flush();
+            spdlog::info("SyntheticPublisher: {} x{}", command.mode==ThrottleCommand::RESUME ? "resume" :
+                                                    command.mode==ThrottleCommand::RATE ? "rate" : "batch",
+                                                    command.factor);
+        }
+        throttle = command;
+        lease_end = std::chrono::steady_clock::now()+std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                        std::chrono::duration<double>(command.lease));
+    }
+    if(throttle.mode!=ThrottleCommand::RESUME && std::chrono::steady_clock::now()>lease_end)
+    {
+        //the subscriber stopped renewing, back to full rate
+        flush();
+        throttle = ThrottleCommand{ThrottleCommand::RESUME, 1, 0.0};
+        spdlog::info("SyntheticPublisher: throttle lease expired");
+    }
+}
+
+void SyntheticPublisher::emit(double t, uint8_t axes, const glm::vec3& gyro, const glm::vec3& accel, const glm::vec3& mag)
+{
+    char buffer[192];
+    if(throttle.mode==ThrottleCommand::RATE)
+    {
+        //one averaged sample per factor samples, so the integrated rotation is kept
+        gyro_sum += gyro;
+        accel_sum += accel;
+        mag_sum += mag;
+        if(++pending<throttle.factor) return;
+        const float n{static_cast<float>(pending)};
+        const size_t length{format(buffer, sizeof(buffer), t, axes, gyro_sum/n, accel_sum/n, mag_sum/n)};
+        gyro_sum = accel_sum = mag_sum = glm::vec3(0.0f);
+        pending = 0;
+        batch.assign(buffer, length);
+        send(1);
+        return;
+    }
+
+    const size_t length{format(buffer, sizeof(buffer), t, axes, gyro, accel, mag)};
+    if(!batch.empty()) batch.push_back('\n');
+    batch.append(buffer, length);
+    if(++pending>=(throttle.mode==ThrottleCommand::BATCH ? throttle.factor : 1u))
+    {
+        send(pending);
+        pending = 0;
+    }
+}
+
+void SyntheticPublisher::flush()
+{
+    if(throttle.mode==ThrottleCommand::RATE)
+    {
+        gyro_sum = accel_sum = mag_sum = glm::vec3(0.0f);
+        batch.clear();
+    }
+    else if(pending>0)
+    {
+        send(pending);
+    }
+    pending = 0;
+}
+
+void SyntheticPublisher::send(uint32_t samples)
+{
+    try
+    {
+        auto msg = mqtt::make_message(topic_name, batch, QOS, false);
+        //lets the subscriber detect loss, duplicates and reordering, a batch numbers its lines from here
+        msg->set_properties(mqtt::properties{
+                {mqtt::property::USER_PROPERTY, "seq", std::to_string(seq)},
+                {mqtt::property::USER_PROPERTY, "epoch", std::to_string(epoch)}});
+        cli.publish(msg);
+        ++sent;
+    }
+    catch(const mqtt::exception& e)
+    {
+        spdlog::warn("SyntheticPublisher::send: publish failed: {}", e.what());
+    }
+    seq += samples;
+    batch.clear();
+}
+
+size_t SyntheticPublisher::format(char* buffer, size_t size, double t, uint8_t axes,
+                                const glm::vec3& gyro, const glm::vec3& accel, const glm::vec3& mag)
+{
+    int length{std::snprintf(buffer, size, "%.6f,%.4f,%.4f,%.4f", t, gyro.x, gyro.y, gyro.z)};
+    if(axes>=6 && length>0)
+    {
+        length += std::snprintf(buffer+length, size-length, ",%.4f,%.4f,%.4f", accel.x, accel.y, accel.z);
+    }
+    if(axes==9 && length>0)
+    {
+        length += std::snprintf(buffer+length, size-length, ",%.4f,%.4f,%.4f", mag.x, mag.y, mag.z);
+    }
+    return length>0 ? std::min(static_cast<size_t>(length), size-1) : 0;
+}
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <sys/resource.h>
+#include "throttle.hpp"
+
+
+size_t formatCommand(const ThrottleCommand& command, char* buffer, size_t size)
+{
+    int length;
+    if(command.mode==ThrottleCommand::RESUME)
+    {
+        length = std::snprintf(buffer, size, "resume");
+    }
+    else
+    {
+        length = std::snprintf(buffer, size, "throttle,%s,%u,%.1f",
+                            command.mode==ThrottleCommand::RATE ? "rate" : "batch",
+                            command.factor, command.lease);
+    }
+    return length>0 ? std::min(static_cast<size_t>(length), size-1) : 0;
+}
+
+bool parseCommand(std::string_view text, ThrottleCommand& command)
+{
+    while(!text.empty() && (text.back()=='\0' || text.back()=='\n' || text.back()=='\r')) text.remove_suffix(1);
+    if(text=="resume")
+    {
+        command = ThrottleCommand{ThrottleCommand::RESUME, 1, 0.0};
+        return true;
+    }
+
+    constexpr std::string_view PREFIX{"throttle,"};
+    if(text.substr(0, PREFIX.size())!=PREFIX) return false;
+    text.remove_prefix(PREFIX.size());
+    ThrottleCommand parsed{ThrottleCommand::RATE, 1, 0.0};
+    if(text.substr(0, 5)=="rate,") text.remove_prefix(5);
+    else if(text.substr(0, 6)=="batch,")
+    {
+        parsed.mode = ThrottleCommand::BATCH;
+        text.remove_prefix(6);
+    }
+    else return false;
+
+    const char* last{text.data()+text.size()};
+    auto [factor_end, factor_ec] = std::from_chars(text.data(), last, parsed.factor);
+    if(factor_ec!=std::errc() || factor_end==last || *factor_end!=',' || parsed.factor==0) return false;
+    auto [lease_end, lease_ec] = std::from_chars(factor_end+1, last, parsed.lease);
+    if(lease_ec!=std::errc() || lease_end!=last) return false;
+    command = parsed;
+    return true;
+}
+
+
+ThrottleController::ThrottleController(float _depth_limit, float _cpu_limit):
+                                                    depth_limit{_depth_limit},
+                                                    cpu_limit{_cpu_limit},
+                                                    last_time{0.0},
+                                                    last_cpu{0.0},
+                                                    cpu_load{0.0}
+{
+}
+
+double ThrottleController::threadCpuSeconds()
+{
+    rusage usage{};
+#ifdef RUSAGE_THREAD
+    getrusage(RUSAGE_THREAD, &usage);
+#else
+    getrusage(RUSAGE_SELF, &usage);
+#endif
+    return static_cast<double>(usage.ru_utime.tv_sec+usage.ru_stime.tv_sec)+
+           static_cast<double>(usage.ru_utime.tv_usec+usage.ru_stime.tv_usec)*1e-6;
+}
+
+bool ThrottleController::evaluate(double now, const SampleQueue& queue,
+                                std::vector<std::pair<uint32_t, ThrottleCommand>>& commands)
+{
+    if(last_time==0.0)
+    {
+        last_time = now;
+        last_cpu = threadCpuSeconds();
+        return false;
+    }
+    if(now-last_time<INTERVAL) return false;
+
+    const double cpu{threadCpuSeconds()};
+    cpu_load = (cpu-last_cpu)/(now-last_time);
+    last_cpu = cpu;
+    last_time = now;
+    const bool cpu_busy{cpu_load>cpu_limit};
+
+    queue.stats(stats);
+    sensors.resize(stats.size(), SensorState{0, 1, 0, ThrottleCommand::RESUME});
+    const double depth_threshold{depth_limit*static_cast<double>(queue.getCapacity())};
+    //a few intervals, so one lost command does not end a throttle
+    const double lease{3.0*INTERVAL};
+    for(uint32_t i=0; i<stats.size(); ++i)
+    {
+        SensorState& sensor{sensors[i]};
+        const bool queue_busy{stats[i].dropped>sensor.dropped || stats[i].depth>depth_threshold};
+        sensor.dropped = stats[i].dropped;
+        if(queue_busy || cpu_busy)
+        {
+            //too many samples for the renderer: fewer samples, too many messages: fewer messages
+            sensor.mode = queue_busy ? ThrottleCommand::RATE : ThrottleCommand::BATCH;
+            sensor.factor = std::min(sensor.factor*2, MAX_FACTOR);
+            sensor.clear = 0;
+            commands.emplace_back(i, ThrottleCommand{sensor.mode, sensor.factor, lease});
+        }
+        else if(sensor.factor>1)
+        {
+            if(++sensor.clear>=CLEAR_EVALUATIONS)
+            {
+                sensor.factor /= 2;
+                sensor.clear = 0;
+            }
+            if(sensor.factor==1) sensor.mode = ThrottleCommand::RESUME;
+            commands.emplace_back(i, ThrottleCommand{sensor.mode, sensor.factor, lease});
+        }
+    }
+    return true;
+}
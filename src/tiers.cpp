@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "tiers.hpp"
+
+static constexpr double INF{std::numeric_limits<double>::infinity()};
+
+
+void TierStore::Ring::push(const Bucket& bucket)
+{
+    if(slots.empty()) return;
+    slots[(head+count)%slots.size()] = bucket;
+    if(count<slots.size()) ++count;
+    else head = (head+1)%slots.size();
+}
+
+
+TierStore::TierStore(size_t _raw_capacity, size_t _second_capacity, size_t _minute_capacity):latest{-INF}
+{
+    const std::array<size_t, TIERS> capacities{_raw_capacity, _second_capacity, _minute_capacity};
+    for(size_t tier=0; tier<TIERS; ++tier)
+    {
+        rings[tier] = Ring{std::vector<Bucket>(capacities[tier]), 0, 0};
+        open[tier] = Bucket{0.0, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 0};
+    }
+}
+
+void TierStore::push(const Sample& sample)
+{
+    const Bucket raw{sample.timestamp, sample.value, sample.value, sample.value, 1};
+    rings[0].push(raw);
+    latest = std::max(latest, sample.timestamp);
+    fold(1, raw);
+}
+
+void TierStore::fold(size_t tier, const Bucket& bucket)
+{
+    Bucket& current{open[tier]};
+    const double start{std::floor(bucket.start/WIDTHS[tier])*WIDTHS[tier]};
+    if(current.count && start>current.start)
+    {
+        rings[tier].push(current);
+        if(tier+1<TIERS) fold(tier+1, current);
+        current.count = 0;
+    }
+    if(!current.count)
+    {
+        current = bucket;
+        current.start = start;
+        return;
+    }
+    //late buckets stay in the open one instead of rewriting history
+    const float n{static_cast<float>(current.count)}, m{static_cast<float>(bucket.count)};
+    current.min = glm::min(current.min, bucket.min);
+    current.max = glm::max(current.max, bucket.max);
+    current.mean = (current.mean*n+bucket.mean*m)/(n+m);
+    current.count += bucket.count;
+}
+
+double TierStore::oldest(size_t tier) const
+{
+    if(rings[tier].count) return rings[tier][0].start;
+    return tier>0 && open[tier].count ? open[tier].start : INF;
+}
+
+size_t TierStore::select(double from, double resolution) const
+{
+    size_t tier{0};
+    while(tier+1<TIERS && WIDTHS[tier+1]<=resolution) ++tier;
+    //the finer tier has forgotten the start of the range, a coarser one may still hold it
+    while(tier+1<TIERS && oldest(tier)>from && oldest(tier+1)<oldest(tier)) ++tier;
+    return tier;
+}
+
+size_t TierStore::read(double from, double to, double resolution, std::vector<Bucket>& out) const
+{
+    return read(select(from, resolution), from, to, out);
+}
+
+size_t TierStore::read(size_t tier, double from, double to, std::vector<Bucket>& out) const
+{
+    const Ring& ring{rings[tier]};
+    const double width{WIDTHS[tier]};
+    //buckets are in start order, skip the ones ending before the range
+    size_t low{0}, high{ring.count};
+    while(low<high)
+    {
+        const size_t middle{(low+high)/2};
+        if(ring[middle].start+width<from) low = middle+1;
+        else high = middle;
+    }
+    const size_t before{out.size()};
+    for(size_t i=low; i<ring.count && ring[i].start<=to; ++i) out.push_back(ring[i]);
+    //the open bucket of a coarse tier lacks the samples still in the open bucket of the finer one
+    if(tier>0 && open[tier].count && open[tier].start+width>=from && open[tier].start<=to)
+    {
+        out.push_back(open[tier]);
+    }
+    return out.size()-before;
+}
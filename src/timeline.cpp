@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cstddef>
+#include "timeline.hpp"
+using namespace gl;
+
+//same colors as the strip charts and the axes
+static const glm::vec3 CHANNEL_COLORS[3]{
+                                    glm::vec3(1.0f, 0.0f, 0.0f),
+                                    glm::vec3(0.0f, 1.0f, 0.0f),
+                                    glm::vec3(0.0f, 0.0f, 1.0f)
+                                };
+static const glm::vec3 CURSOR_COLOR{1.0f, 1.0f, 1.0f};
+
+
+Timeline::Timeline(const std::vector<Bucket>& _overview, double _begin, double _end):
+                                            begin{_begin},
+                                            end{std::max(_end, _begin+1e-3)},
+                                            columns{static_cast<uint>(_overview.size())}
+{
+    //two vertices per bucket, min then max, and two for the cursor behind them
+    std::vector<Vertex> vertices;
+    vertices.reserve(2*columns+2);
+    for(const Bucket& bucket : _overview)
+    {
+        const float t{static_cast<float>(bucket.start-begin)};
+        vertices.push_back(Vertex{t, bucket.min});
+        vertices.push_back(Vertex{t, bucket.max});
+    }
+    vertices.resize(2*columns+2, Vertex{0.0f, glm::vec3(0.0f)});
+
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), vertices.data(), GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0,1,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)offsetof(Vertex, t));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),(void*)offsetof(Vertex, value));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+Timeline::~Timeline()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+}
+
+void Timeline::draw(uint _program, float _scale, double _cursor)
+{
+    //a full height line on channel 0
+    const float t{static_cast<float>(_cursor-begin)};
+    const Vertex cursor[2]{Vertex{t, glm::vec3(-_scale, 0.0f, 0.0f)}, Vertex{t, glm::vec3(_scale, 0.0f, 0.0f)}};
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 2*columns*sizeof(Vertex), sizeof(cursor), cursor);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    //the right edge is the end of the recording, the window its whole length
+    glUseProgram(_program);
+    glUniform1f(glGetUniformLocation(_program, "latest"), static_cast<float>(end-begin));
+    glUniform1f(glGetUniformLocation(_program, "window_length"), static_cast<float>(end-begin));
+    glUniform1f(glGetUniformLocation(_program, "scale"), _scale);
+    const int channelLoc = glGetUniformLocation(_program, "channel");
+    const int colorLoc = glGetUniformLocation(_program, "color");
+
+    glBindVertexArray(VAO);
+    for(int channel=0; columns>0 && channel<3; ++channel)
+    {
+        glUniform1i(channelLoc, channel);
+        glUniform3fv(colorLoc, 1, &CHANNEL_COLORS[channel].x);
+        glDrawArrays(GL_LINE_STRIP, 0, 2*columns);
+    }
+    glUniform1i(channelLoc, 0);
+    glUniform3fv(colorLoc, 1, &CURSOR_COLOR.x);
+    glDrawArrays(GL_LINES, 2*columns, 2);
+    glBindVertexArray(0);
+}
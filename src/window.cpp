@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include "window.hpp"
@@ -5,7 +6,8 @@
 using namespace gl;
 
 
-Window::Window(GLFWwindow* window_, const uint height_, const uint width_, const std::string window_name_):
+Window::Window(GLFWwindow* window_, const uint height_, const uint width_, const std::string window_name_,
+                const bool visible_):
                                                                 window{window_}, 
                                                                 height{height_},
                                                                 width{width_}
@@ -15,6 +17,7 @@ Window::Window(GLFWwindow* window_, const uint height_, const uint width_, const
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     
     this->init();
+    glfwWindowHint(GLFW_VISIBLE, visible_ ? GLFW_TRUE : GLFW_FALSE);
     glfwSetErrorCallback(Window::error_callback);
     this->createWindow(window_name_);
     //create context of the rendering window in the main thread
@@ -83,6 +86,66 @@ void Window::framebuffer_size_callback(GLFWwindow* window, int width, int height
     glViewport(0,0, width, height);
 }
 
+void Window::enableTimeline(float area)
+{
+    timeline_area = area;
+    scrub_active = false;
+    play_toggles = 0;
+    steps = 0;
+    glfwSetMouseButtonCallback(window, Window::mouse_button_callback);
+    glfwSetKeyCallback(window, Window::key_callback);
+}
+
+bool Window::scrubbing(float& fraction) const
+{
+    if(!scrub_active) return false;
+    double x, y;
+    int window_width, window_height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &window_width, &window_height);
+    if(window_width<=0) return false;
+    fraction = std::clamp(static_cast<float>(x/window_width), 0.0f, 1.0f);
+    return true;
+}
+
+bool Window::takePlayToggle()
+{
+    const bool toggled{play_toggles%2==1};
+    play_toggles = 0;
+    return toggled;
+}
+
+int Window::takeSteps()
+{
+    const int taken{steps};
+    steps = 0;
+    return taken;
+}
+
+void Window::mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if(button!=GLFW_MOUSE_BUTTON_LEFT) return;
+    if(action==GLFW_RELEASE)
+    {
+        scrub_active = false;
+        return;
+    }
+    //a drag started on the timeline keeps scrubbing outside of it until released
+    double x, y;
+    int window_width, window_height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &window_width, &window_height);
+    scrub_active = y>=window_height*(1.0f-timeline_area);
+}
+
+void Window::key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if(action==GLFW_RELEASE) return;
+    if(key==GLFW_KEY_SPACE && action==GLFW_PRESS) ++play_toggles;
+    else if(key==GLFW_KEY_RIGHT) ++steps;
+    else if(key==GLFW_KEY_LEFT) --steps;
+}
+
 void Window::error_callback(int error, const char* description)
 {
     std::cout<<description<<std::endl;
@@ -123,9 +186,10 @@ void Window::processInput(GLFWwindow *window)
 {
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     {
+        //the render loop ends after this frame and flushes the recordings on its way out
         glfwSetWindowShouldClose(window, true);
         spdlog::warn("Exit button pressed...");
-        std::exit(EXIT_SUCCESS);
+        return;
     }
     
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
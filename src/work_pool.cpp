@@ -0,0 +1,107 @@
+#include <algorithm>
+#include "work_pool.hpp"
+
+//the pool and deque of the worker running on this thread, nullptr outside of workers
+static thread_local const WorkStealingPool* current_pool{nullptr};
+static thread_local unsigned current_index{0};
+
+
+WorkStealingPool::WorkStealingPool(unsigned _threads):queued{0},
+                                                    pending{0},
+                                                    executed{0},
+                                                    stolen{0},
+                                                    next{0},
+                                                    stopping{false}
+{
+    const unsigned count{_threads ? _threads : std::max(1u, std::thread::hardware_concurrency())};
+    for(unsigned i=0; i<count; ++i) queues.push_back(std::make_unique<Queue>());
+    for(unsigned i=0; i<count; ++i) workers.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mx};
+        stopping = true;
+    }
+    work.notify_all();
+    for(std::thread& worker : workers) worker.join();
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    const unsigned index{current_pool==this ? current_index
+                                            : next.fetch_add(1, std::memory_order_relaxed)%threadCount()};
+    pending.fetch_add(1);
+    //counted first and under the lock the sleeping workers check: no wakeup is lost
+    //and the count never drops below the tasks in the deques
+    {
+        std::lock_guard<std::mutex> lock{mx};
+        queued.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock{queues[index]->mx};
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    work.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock{mx};
+    finished.wait(lock, [this]{return pending.load()==0;});
+}
+
+bool WorkStealingPool::take(unsigned index, Task& task)
+{
+    {
+        //own deque newest first, its data is most likely still in cache
+        Queue& own{*queues[index]};
+        std::lock_guard<std::mutex> lock{own.mx};
+        if(!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for(unsigned k=1; k<threadCount(); ++k)
+    {
+        //the others oldest first, the far end from their owner
+        Queue& other{*queues[(index+k)%threadCount()]};
+        std::lock_guard<std::mutex> lock{other.mx};
+        if(other.tasks.empty()) continue;
+        task = std::move(other.tasks.front());
+        other.tasks.pop_front();
+        queued.fetch_sub(1);
+        stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(unsigned index)
+{
+    current_pool = this;
+    current_index = index;
+    Task task;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock{mx};
+            work.wait(lock, [this]{return stopping || queued.load()>0;});
+            if(stopping) return;
+        }
+        //another worker may have taken it in between, or it is not pushed yet
+        if(!take(index, task)) continue;
+        task();
+        task = nullptr;
+        executed.fetch_add(1, std::memory_order_relaxed);
+        if(pending.fetch_sub(1)==1)
+        {
+            std::lock_guard<std::mutex> lock{mx};
+            finished.notify_all();
+        }
+    }
+}
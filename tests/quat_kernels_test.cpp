@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "spdlog/spdlog.h"
+#include "kernels.hpp"
+
+//Checks every batched quaternion kernel of every level available on this CPU
+//against glm. The element count is not a multiple of any vector width, so the
+//tail lanes are covered, and the inputs include the cases slerp treats specially:
+//equal, opposite and nearly parallel quaternions and t at 0 and 1.
+//Returns nonzero if any kernel is off by more than its tolerance.
+
+//max abs difference to glm, per component
+constexpr float MULTIPLY_TOLERANCE{1e-5f};
+constexpr float NORMALIZE_TOLERANCE{1e-6f};
+constexpr float ROTATE_TOLERANCE{1e-5f};
+constexpr float SLERP_TOLERANCE{2e-5f};
+constexpr size_t ELEMENTS{4099};
+
+struct QuatArrays{
+    std::vector<float> w, x, y, z;
+    explicit QuatArrays(size_t n):w(n), x(n), y(n), z(n){}
+    QuatSoA view() {return QuatSoA{w.data(), x.data(), y.data(), z.data()};}
+    glm::quat at(size_t i) const {return glm::quat(w[i], x[i], y[i], z[i]);}
+    void set(size_t i, const glm::quat& q) {w[i] = q.w; x[i] = q.x; y[i] = q.y; z[i] = q.z;}
+};
+
+struct Vec3Arrays{
+    std::vector<float> x, y, z;
+    explicit Vec3Arrays(size_t n):x(n), y(n), z(n){}
+    Vec3SoA view() {return Vec3SoA{x.data(), y.data(), z.data()};}
+    glm::vec3 at(size_t i) const {return glm::vec3(x[i], y[i], z[i]);}
+};
+
+static float quatError(const glm::quat& a, const glm::quat& b)
+{
+    //q and -q are the same rotation
+    const float same{std::max({std::fabs(a.w-b.w), std::fabs(a.x-b.x), std::fabs(a.y-b.y), std::fabs(a.z-b.z)})};
+    const float flipped{std::max({std::fabs(a.w+b.w), std::fabs(a.x+b.x), std::fabs(a.y+b.y), std::fabs(a.z+b.z)})};
+    return std::min(same, flipped);
+}
+
+static bool check(simd::Level level, const char* kernel, float error, float tolerance)
+{
+    const bool passed{std::isfinite(error) && error<=tolerance};
+    if(passed) spdlog::info("{:>8} {:<9}: max error {:.1e}", simd::levelName(level), kernel, error);
+    else spdlog::error("{:>8} {:<9}: max error {:.1e} above {:.1e}", simd::levelName(level), kernel, error, tolerance);
+    return passed;
+}
+
+int main()
+{
+    const size_t n{ELEMENTS};
+    std::mt19937 rng{5};
+    std::normal_distribution<float> gauss{0.0f, 1.0f};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+    QuatArrays a{n}, b{n}, raw{n};
+    Vec3Arrays v{n};
+    std::vector<float> t(n);
+    for(size_t i=0; i<n; ++i)
+    {
+        raw.set(i, glm::quat(gauss(rng), gauss(rng), gauss(rng), gauss(rng)));
+        a.set(i, glm::normalize(raw.at(i)));
+        const glm::quat qb{glm::normalize(glm::quat(gauss(rng), gauss(rng), gauss(rng), gauss(rng)))};
+        switch(i%8)
+        {
+            case 0: b.set(i, a.at(i)); break;
+            case 1: b.set(i, -a.at(i)); break;
+            case 2: b.set(i, glm::normalize(a.at(i)+qb*1e-3f)); break;
+            case 3: b.set(i, glm::normalize(-a.at(i)+qb*1e-3f)); break;
+            default: b.set(i, qb); break;
+        }
+        v.x[i] = gauss(rng); v.y[i] = gauss(rng); v.z[i] = gauss(rng);
+        t[i] = i%16==4 ? 0.0f : i%16==5 ? 1.0f : unit(rng);
+    }
+
+    bool passed{true};
+    size_t levels{0};
+    for(simd::Level level : {simd::SCALAR, simd::NEON, simd::SSE42, simd::AVX2, simd::AVX512})
+    {
+        const simd::Kernels& k{simd::kernels(level)};
+        if(k.level!=level) continue;
+        ++levels;
+
+        QuatArrays out{n};
+        float error{0.0f};
+        k.quatMultiply(a.view(), b.view(), out.view(), n);
+        for(size_t i=0; i<n; ++i) error = std::max(error, quatError(out.at(i), a.at(i)*b.at(i)));
+        passed &= check(level, "multiply", error, MULTIPLY_TOLERANCE);
+
+        QuatArrays normalized{raw};
+        k.quatNormalize(normalized.view(), n);
+        error = 0.0f;
+        for(size_t i=0; i<n; ++i) error = std::max(error, quatError(normalized.at(i), glm::normalize(raw.at(i))));
+        passed &= check(level, "normalize", error, NORMALIZE_TOLERANCE);
+
+        Vec3Arrays rotated{n};
+        k.rotateVector(a.view(), v.view(), rotated.view(), n);
+        error = 0.0f;
+        for(size_t i=0; i<n; ++i)
+        {
+            const glm::vec3 d{rotated.at(i)-a.at(i)*v.at(i)};
+            error = std::max({error, std::fabs(d.x), std::fabs(d.y), std::fabs(d.z)});
+        }
+        passed &= check(level, "rotate", error, ROTATE_TOLERANCE);
+
+        k.quatSlerp(a.view(), b.view(), t.data(), out.view(), n);
+        error = 0.0f;
+        for(size_t i=0; i<n; ++i) error = std::max(error, quatError(out.at(i), glm::slerp(a.at(i), b.at(i), t[i])));
+        passed &= check(level, "slerp", error, SLERP_TOLERANCE);
+    }
+    spdlog::info("{} levels checked, detected {}", levels, simd::levelName(simd::kernels().level));
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,425 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "spdlog/spdlog.h"
+#include "reconnect.hpp"
+
+//Runs ReconnectManager against in-process fake MQTT v5 brokers on the loopback
+//interface, so no mosquitto is needed. A broker can be stopped, which drops the
+//connection and refuses new ones like a restarting broker, keeping or forgetting
+//the session, or stalled, which keeps the connection but stops answering.
+//Checks that a restart with the session kept resumes it without resubscribing and
+//delivers the QoS 1 messages queued meanwhile, that a lost session is subscribed
+//again, and that a dropped or stalled active broker fails over to the standby.
+//Returns nonzero if any check fails.
+
+using namespace std::chrono_literals;
+
+constexpr auto WAIT_TIMEOUT{5s};
+constexpr auto DOWNTIME{300ms};
+const std::string TOPIC{"test/imu"};
+
+//the part of an MQTT v5 broker the reconnect manager uses: CONNECT, SUBSCRIBE,
+//UNSUBSCRIBE, PINGREQ and DISCONNECT, one client at a time, QoS 1 towards it
+class FakeBroker{
+    public:
+        FakeBroker():listener{socket(AF_INET, SOCK_STREAM, 0)},
+                    conn{-1},
+                    client{-1},
+                    refusing{false},
+                    stalled{false},
+                    stopping{false},
+                    session{false},
+                    next_id{1},
+                    subscribes{0}
+        {
+            const int on{1};
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            socklen_t len{sizeof(addr)};
+            if(bind(listener, reinterpret_cast<sockaddr*>(&addr), len)!=0 || listen(listener, 4)!=0 ||
+               getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len)!=0)
+            {
+                spdlog::critical("FakeBroker: Could not listen on the loopback interface: {}", std::strerror(errno));
+                std::exit(EXIT_FAILURE);
+            }
+            port = ntohs(addr.sin_port);
+            thread = std::thread{&FakeBroker::serve, this};
+        }
+
+        ~FakeBroker()
+        {
+            {
+                std::lock_guard<std::mutex> lc_{mx};
+                stopping = true;
+                if(conn>=0) shutdown(conn, SHUT_RDWR);
+            }
+            thread.join();
+            close(listener);
+        }
+
+        std::string uri() const {return "tcp://127.0.0.1:"+std::to_string(port);}
+
+        //drops the client and refuses connections until start()
+        void stop(bool keep_session)
+        {
+            std::lock_guard<std::mutex> lc_{mx};
+            refusing = true;
+            if(!keep_session) forget();
+            if(conn>=0) shutdown(conn, SHUT_RDWR);
+            client = -1;
+        }
+
+        void start()
+        {
+            std::lock_guard<std::mutex> lc_{mx};
+            refusing = false;
+            stalled = false;
+        }
+
+        //keeps the connection but leaves every packet unanswered
+        void stall()
+        {
+            std::lock_guard<std::mutex> lc_{mx};
+            stalled = true;
+        }
+
+        //sent at once if the client is connected, queued if only its session is
+        void publish(const std::string& topic, const std::string& payload)
+        {
+            std::lock_guard<std::mutex> lc_{mx};
+            if(!subscriptions.count(topic)) return;
+            if(client>=0) send(client, publishPacket(topic, payload));
+            else if(session) queued.push_back(publishPacket(topic, payload));
+        }
+
+        uint64_t subscribeCount() const
+        {
+            std::lock_guard<std::mutex> lc_{mx};
+            return subscribes;
+        }
+
+    private:
+        void serve()
+        {
+            pollfd pfd{listener, POLLIN, 0};
+            while(true)
+            {
+                {
+                    std::lock_guard<std::mutex> lc_{mx};
+                    if(stopping) return;
+                }
+                if(poll(&pfd, 1, 50)<=0) continue;
+                const int fd{accept(listener, nullptr, nullptr)};
+                if(fd<0) continue;
+                {
+                    std::lock_guard<std::mutex> lc_{mx};
+                    if(refusing || stopping)
+                    {
+                        close(fd);
+                        continue;
+                    }
+                    conn = fd;
+                }
+                converse(fd);
+                std::lock_guard<std::mutex> lc_{mx};
+                if(client==fd) client = -1;
+                conn = -1;
+                close(fd);
+            }
+        }
+
+        //one client connection, returns when it is closed from either side
+        void converse(int fd)
+        {
+            uint8_t type;
+            std::string body;
+            while(readPacket(fd, type, body))
+            {
+                std::lock_guard<std::mutex> lc_{mx};
+                if(stopping || refusing) return;
+                if(stalled) continue;
+                size_t pos{0};
+                switch(type>>4)
+                {
+                    case 1:     //CONNECT
+                    {
+                        //protocol name, then the level and the connect flags
+                        const uint8_t flags{static_cast<uint8_t>(body[2+readU16(body, 0)+1])};
+                        if(flags & 0x02) forget();          //clean start
+                        const bool present{session};
+                        session = true;
+                        client = fd;
+                        send(fd, packet(0x20, std::string{static_cast<char>(present), 0, 0}));
+                        for(const std::string& msg : queued) send(fd, msg);
+                        queued.clear();
+                        break;
+                    }
+                    case 8:     //SUBSCRIBE
+                    {
+                        const std::string id{body.substr(0, 2)};
+                        pos = 2;
+                        pos += readVarint(body, pos);
+                        std::string codes;
+                        while(pos<body.size())
+                        {
+                            const size_t len{readU16(body, pos)};
+                            subscriptions.insert(body.substr(pos+2, len));
+                            codes += static_cast<char>(body[pos+2+len] & 0x03);    //granted QoS
+                            pos += 2+len+1;
+                        }
+                        ++subscribes;
+                        send(fd, packet(0x90, id+std::string(1, '\0')+codes));
+                        break;
+                    }
+                    case 10:    //UNSUBSCRIBE
+                    {
+                        const std::string id{body.substr(0, 2)};
+                        pos = 2;
+                        pos += readVarint(body, pos);
+                        std::string codes;
+                        while(pos<body.size())
+                        {
+                            const size_t len{readU16(body, pos)};
+                            codes += subscriptions.erase(body.substr(pos+2, len)) ? '\x00' : '\x11';
+                            pos += 2+len;
+                        }
+                        send(fd, packet(0xB0, id+std::string(1, '\0')+codes));
+                        break;
+                    }
+                    case 12:    //PINGREQ
+                        send(fd, packet(0xD0, ""));
+                        break;
+                    case 14:    //DISCONNECT
+                        return;
+                    default:    //PUBACK of our messages, nothing else is sent by the client
+                        break;
+                }
+            }
+        }
+
+        void forget()
+        {
+            session = false;
+            subscriptions.clear();
+            queued.clear();
+        }
+
+        std::string publishPacket(const std::string& topic, const std::string& payload)
+        {
+            const uint16_t id{next_id++};
+            if(next_id==0) next_id = 1;
+            std::string body;
+            body += static_cast<char>(topic.size()>>8);
+            body += static_cast<char>(topic.size() & 0xff);
+            body += topic;
+            body += static_cast<char>(id>>8);
+            body += static_cast<char>(id & 0xff);
+            body += '\0';           //no properties
+            body += payload;
+            return packet(0x32, body);
+        }
+
+        static std::string packet(uint8_t header, const std::string& body)
+        {
+            std::string out(1, static_cast<char>(header));
+            size_t len{body.size()};
+            do
+            {
+                uint8_t byte{static_cast<uint8_t>(len & 0x7f)};
+                len >>= 7;
+                if(len) byte |= 0x80;
+                out += static_cast<char>(byte);
+            }while(len);
+            return out+body;
+        }
+
+        static void send(int fd, const std::string& data)
+        {
+            size_t done{0};
+            while(done<data.size())
+            {
+                const ssize_t n{::send(fd, data.data()+done, data.size()-done, MSG_NOSIGNAL)};
+                if(n<=0) return;
+                done += n;
+            }
+        }
+
+        static bool readAll(int fd, char* out, size_t len)
+        {
+            size_t done{0};
+            while(done<len)
+            {
+                const ssize_t n{recv(fd, out+done, len-done, 0)};
+                if(n<=0) return false;
+                done += n;
+            }
+            return true;
+        }
+
+        static bool readPacket(int fd, uint8_t& type, std::string& body)
+        {
+            char byte;
+            if(!readAll(fd, &byte, 1)) return false;
+            type = static_cast<uint8_t>(byte);
+            size_t len{0};
+            for(int shift=0; ; shift+=7)
+            {
+                if(!readAll(fd, &byte, 1)) return false;
+                len |= static_cast<size_t>(byte & 0x7f)<<shift;
+                if(!(byte & 0x80)) break;
+            }
+            body.resize(len);
+            return len==0 || readAll(fd, body.data(), len);
+        }
+
+        static size_t readU16(const std::string& body, size_t pos)
+        {
+            return static_cast<uint8_t>(body[pos])<<8 | static_cast<uint8_t>(body[pos+1]);
+        }
+
+        //skips a variable byte integer and the bytes it counts, returns the total length
+        static size_t readVarint(const std::string& body, size_t pos)
+        {
+            size_t value{0};
+            size_t used{0};
+            for(int shift=0; ; shift+=7)
+            {
+                const uint8_t byte{static_cast<uint8_t>(body[pos+used++])};
+                value |= static_cast<size_t>(byte & 0x7f)<<shift;
+                if(!(byte & 0x80)) break;
+            }
+            return used+value;
+        }
+
+        int listener;
+        uint16_t port;
+        std::thread thread;
+        mutable std::mutex mx;
+        int conn;           //accepted connection
+        int client;         //the same once its CONNECT was answered
+        bool refusing;
+        bool stalled;
+        bool stopping;
+        bool session;
+        std::set<std::string> subscriptions;
+        std::deque<std::string> queued;
+        uint16_t next_id;
+        uint64_t subscribes;
+};
+
+static bool waitFor(const std::function<bool()>& done)
+{
+    const auto deadline{std::chrono::steady_clock::now()+WAIT_TIMEOUT};
+    while(!done())
+    {
+        if(std::chrono::steady_clock::now()>deadline) return false;
+        std::this_thread::sleep_for(5ms);
+    }
+    return true;
+}
+
+static bool check(const char* what, bool passed)
+{
+    if(passed) spdlog::info("{}: passed", what);
+    else spdlog::error("{}: failed", what);
+    return passed;
+}
+
+//one broker restarted twice, first keeping the session, then losing it
+static bool restart()
+{
+    FakeBroker broker;
+    std::atomic<uint64_t> received{0};
+    ReconnectManager manager{{broker.uri()}, "reconnect_test_restart", 300};
+    manager.addTopic(TOPIC, 1);
+    manager.setMessageCallback([&](mqtt::const_message_ptr){++received;});
+    bool passed{check("first connect", manager.connect() && broker.subscribeCount()==1)};
+
+    broker.publish(TOPIC, "0,0,0,0");
+    passed &= check("delivery", waitFor([&](){return received==1;}));
+
+    broker.stop(true);
+    broker.publish(TOPIC, "1,0,0,0");
+    std::this_thread::sleep_for(DOWNTIME);
+    broker.start();
+    passed &= check("reconnect after a restart", waitFor([&](){return manager.getStats().reconnects==1;}));
+    ReconnectManager::Stats stats{manager.getStats()};
+    passed &= check("session resumed without resubscribing", stats.resumed==1 && broker.subscribeCount()==1);
+    passed &= check("message queued during the restart delivered", waitFor([&](){return received==2;}));
+    spdlog::info("reconnected {:.0f} ms after the connection was lost, {:.0f} ms downtime",
+                stats.last*1e3, std::chrono::duration<double, std::milli>(DOWNTIME).count());
+
+    broker.stop(false);
+    std::this_thread::sleep_for(DOWNTIME);
+    broker.start();
+    passed &= check("reconnect after losing the session", waitFor([&](){return manager.getStats().reconnects==2;}));
+    stats = manager.getStats();
+    passed &= check("subscribed again", stats.resumed==1 && broker.subscribeCount()==2);
+    broker.publish(TOPIC, "2,0,0,0");
+    passed &= check("delivery on the new session", waitFor([&](){return received==3;}));
+    manager.stop();
+    return passed;
+}
+
+//two brokers, the active one is stopped and later the new active one stalls
+static bool failover()
+{
+    FakeBroker first;
+    FakeBroker second;
+    FakeBroker* brokers[2]{&first, &second};
+    std::atomic<uint64_t> received{0};
+    ReconnectManager manager{{first.uri(), second.uri()}, "reconnect_test_failover", 300};
+    manager.addTopic(TOPIC, 1);
+    manager.setMessageCallback([&](mqtt::const_message_ptr){++received;});
+    bool passed{check("connect to two brokers", manager.connect() &&
+                    first.subscribeCount()+second.subscribeCount()==1)};
+    const size_t active{first.subscribeCount()==1 ? 0u : 1u};
+    FakeBroker& from{*brokers[active]};
+    FakeBroker& to{*brokers[1-active]};
+
+    from.stop(true);
+    passed &= check("failover on a dropped connection", waitFor([&](){return manager.getStats().failovers==1;}) &&
+                    to.subscribeCount()==1);
+    to.publish(TOPIC, "0,0,0,0");
+    passed &= check("delivery after failover", waitFor([&](){return received==1;}));
+    spdlog::info("failed over {:.1f} ms after the connection was lost", manager.getStats().last*1e3);
+
+    //the stopped broker comes back as a standby before the active one stalls
+    from.start();
+    std::this_thread::sleep_for(DOWNTIME+2*ReconnectManager::PROBE_INTERVAL);
+    const uint64_t subscribed{from.subscribeCount()};
+    to.stall();
+    passed &= check("failover from a stalled broker", waitFor([&](){return manager.getStats().failovers==2;}) &&
+                    from.subscribeCount()==subscribed+1);
+    const double detected{manager.getStats().last};
+    spdlog::info("failed over {:.0f} ms after the first missed probe", detected*1e3);
+    const double bound{std::chrono::duration<double>(ReconnectManager::MAX_MISSES*
+                        (ReconnectManager::PROBE_INTERVAL+ReconnectManager::PROBE_TIMEOUT)).count()};
+    passed &= check("stalled broker noticed within the documented bound", detected<bound+0.1);
+    manager.stop();
+    return passed;
+}
+
+int main()
+{
+    bool passed{restart()};
+    passed &= failover();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
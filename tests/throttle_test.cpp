@@ -0,0 +1,225 @@
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "spdlog/spdlog.h"
+#include "sample_queue.hpp"
+#include "throttle.hpp"
+
+//Checks ThrottleController::evaluate on SampleQueues filled by hand: a queue that
+//waits deeper than the depth limit or drops samples throttles the rate, a busy
+//listener thread batches, the factor doubles up to MAX_FACTOR while the load lasts,
+//and it only halves after CLEAR_EVALUATIONS clear evaluations in a row, down to a
+//resume. The CPU limit is set out of reach (or below zero) so the measured load of
+//this thread does not matter. Also checks that formatCommand() output parses back
+//to the same command and that malformed commands are rejected.
+//Returns nonzero if any check fails.
+
+using Commands = std::vector<std::pair<uint32_t, ThrottleCommand>>;
+
+constexpr float NEVER_BUSY{1e9f};
+constexpr float ALWAYS_BUSY{-1.0f};
+constexpr size_t CAPACITY{64};
+
+static bool check(const std::string& what, bool passed)
+{
+    if(passed) spdlog::info("{}: passed", what);
+    else spdlog::error("{}: failed", what);
+    return passed;
+}
+
+static void fill(SampleQueue& queue, uint32_t sensor, size_t count)
+{
+    Sample s{};
+    s.sensor = sensor;
+    s.axes = 3;
+    for(size_t i=0; i<count; ++i)
+    {
+        s.timestamp = static_cast<double>(i)*1e-3;
+        queue.push(s);
+    }
+}
+
+//the command for _sensor in _commands, nullptr if there is none
+static const ThrottleCommand* find(const Commands& commands, uint32_t sensor)
+{
+    for(const auto& [index, command] : commands)
+    {
+        if(index==sensor) return &command;
+    }
+    return nullptr;
+}
+
+static bool is(const ThrottleCommand* command, ThrottleCommand::Mode mode, uint32_t factor)
+{
+    return command && command->mode==mode && command->factor==factor && command->lease>0.0;
+}
+
+//evaluations one INTERVAL apart, starting after the arming call
+class Clock{
+    public:
+        Clock():now{100.0} {}
+        Commands next(ThrottleController& controller, const SampleQueue& queue)
+        {
+            now += ThrottleController::INTERVAL;
+            Commands commands;
+            controller.evaluate(now, queue, commands);
+            return commands;
+        }
+        double now;
+};
+
+static bool depth()
+{
+    SampleQueue queue{CAPACITY};
+    ThrottleController controller{0.5f, NEVER_BUSY};
+    Clock clock;
+    Commands commands;
+    bool passed{check("first call only arms", !controller.evaluate(clock.now, queue, commands) && commands.empty())};
+    passed &= check("no evaluation within an interval",
+                    !controller.evaluate(clock.now+0.5*ThrottleController::INTERVAL, queue, commands));
+
+    //sensor 0 stays below half the capacity, sensor 1 above it
+    fill(queue, 0, CAPACITY/4);
+    fill(queue, 1, CAPACITY/2+8);
+    commands = clock.next(controller, queue);
+    passed &= check("shallow queue not throttled", !find(commands, 0));
+    passed &= check("deep queue throttles the rate", is(find(commands, 1), ThrottleCommand::RATE, 2));
+
+    bool doubled{true};
+    for(uint32_t factor : {4u, 8u, ThrottleController::MAX_FACTOR, ThrottleController::MAX_FACTOR})
+    {
+        doubled &= is(find(clock.next(controller, queue), 1), ThrottleCommand::RATE, factor);
+    }
+    passed &= check("factor doubles up to MAX_FACTOR while the load lasts", doubled);
+
+    std::vector<Sample> drained;
+    queue.drain(drained);
+    //renewed at the same factor until CLEAR_EVALUATIONS clear ones, then halved
+    bool held{true};
+    for(uint32_t k=1; k<ThrottleController::CLEAR_EVALUATIONS; ++k)
+    {
+        held &= is(find(clock.next(controller, queue), 1), ThrottleCommand::RATE, ThrottleController::MAX_FACTOR);
+    }
+    passed &= check("factor held until the load has been clear long enough", held);
+    passed &= check("factor halves after the clear evaluations",
+                    is(find(clock.next(controller, queue), 1), ThrottleCommand::RATE, ThrottleController::MAX_FACTOR/2));
+
+    const ThrottleCommand* last{nullptr};
+    size_t evaluations{0};
+    do
+    {
+        commands = clock.next(controller, queue);
+        last = find(commands, 1);
+        ++evaluations;
+    }while(last && last->mode!=ThrottleCommand::RESUME && evaluations<64);
+    passed &= check("recovers to a resume", last && last->mode==ThrottleCommand::RESUME && last->factor==1);
+    passed &= check("nothing sent once resumed", clock.next(controller, queue).empty());
+    return passed;
+}
+
+static bool drops()
+{
+    //the depth limit is out of reach, only the dropped counter can throttle
+    SampleQueue queue{CAPACITY, OverloadPolicy::DROP_OLDEST};
+    ThrottleController controller{2.0f, NEVER_BUSY};
+    Clock clock;
+    Commands commands;
+    controller.evaluate(clock.now, queue, commands);
+
+    fill(queue, 0, CAPACITY+6);
+    bool passed{check("dropped samples throttle the rate",
+                    is(find(clock.next(controller, queue), 0), ThrottleCommand::RATE, 2))};
+    //the counter did not move since, a full queue alone is below the limit
+    passed &= check("old drops do not throttle again",
+                    is(find(clock.next(controller, queue), 0), ThrottleCommand::RATE, 2));
+    fill(queue, 0, 1);
+    passed &= check("new drops throttle further",
+                    is(find(clock.next(controller, queue), 0), ThrottleCommand::RATE, 4));
+    return passed;
+}
+
+static bool hysteresis()
+{
+    SampleQueue queue{CAPACITY};
+    ThrottleController controller{0.5f, NEVER_BUSY};
+    Clock clock;
+    Commands commands;
+    std::vector<Sample> drained;
+    controller.evaluate(clock.now, queue, commands);
+
+    fill(queue, 0, CAPACITY);
+    clock.next(controller, queue);
+    queue.drain(drained);
+    //clear for one evaluation less than needed, then loaded again
+    for(uint32_t k=1; k<ThrottleController::CLEAR_EVALUATIONS; ++k) clock.next(controller, queue);
+    fill(queue, 0, CAPACITY);
+    bool passed{check("load before the clear run ends doubles again",
+                    is(find(clock.next(controller, queue), 0), ThrottleCommand::RATE, 4))};
+    queue.drain(drained);
+    bool held{true};
+    for(uint32_t k=1; k<ThrottleController::CLEAR_EVALUATIONS; ++k)
+    {
+        held &= is(find(clock.next(controller, queue), 0), ThrottleCommand::RATE, 4);
+    }
+    passed &= check("clear run restarts after new load", held &&
+                    is(find(clock.next(controller, queue), 0), ThrottleCommand::RATE, 2));
+    return passed;
+}
+
+static bool cpu()
+{
+    SampleQueue queue{CAPACITY};
+    ThrottleController controller{0.5f, ALWAYS_BUSY};
+    Clock clock;
+    Commands commands;
+    controller.evaluate(clock.now, queue, commands);
+
+    fill(queue, 0, 1);
+    fill(queue, 1, CAPACITY);
+    commands = clock.next(controller, queue);
+    bool passed{check("busy thread batches", is(find(commands, 0), ThrottleCommand::BATCH, 2))};
+    passed &= check("deep queue still throttles the rate", is(find(commands, 1), ThrottleCommand::RATE, 2));
+    passed &= check("cpu load measured", std::isfinite(controller.cpuLoad()) && controller.cpuLoad()>=0.0);
+    return passed;
+}
+
+static bool roundTrip()
+{
+    bool passed{true};
+    char buffer[64];
+    for(const ThrottleCommand& command : {ThrottleCommand{ThrottleCommand::RESUME, 1, 0.0},
+                                        ThrottleCommand{ThrottleCommand::RATE, 4, 3.0},
+                                        ThrottleCommand{ThrottleCommand::BATCH, ThrottleController::MAX_FACTOR, 2.5}})
+    {
+        const size_t length{formatCommand(command, buffer, sizeof(buffer))};
+        ThrottleCommand parsed{ThrottleCommand::RATE, 0, -1.0};
+        const bool ok{parseCommand(std::string_view{buffer, length}, parsed) && parsed.mode==command.mode &&
+                    parsed.factor==command.factor && (command.mode==ThrottleCommand::RESUME || parsed.lease==command.lease)};
+        passed &= check(std::string{"round trip of \""}+std::string{buffer, length}+"\"", ok);
+    }
+
+    ThrottleCommand parsed{};
+    passed &= check("trailing newline accepted", parseCommand("throttle,batch,2,3.0\n", parsed) &&
+                    parsed.mode==ThrottleCommand::BATCH && parsed.factor==2);
+    bool rejected{true};
+    for(std::string_view text : {"", "resumed", "throttle", "throttle,fast,2,3.0", "throttle,rate,0,3.0",
+                                "throttle,rate,2", "throttle,rate,2,", "throttle,rate,x,3.0", "throttle,rate,2,3.0,1"})
+    {
+        rejected &= !parseCommand(text, parsed);
+    }
+    passed &= check("malformed commands rejected", rejected);
+    return passed;
+}
+
+int main()
+{
+    bool passed{depth()};
+    passed &= drops();
+    passed &= hysteresis();
+    passed &= cpu();
+    passed &= roundTrip();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}